@@ -31,6 +31,102 @@ namespace llvm {
         int times;
     };
 
+    struct PassStringEncryption {
+        int enable;
+        int mode; // 0: 首次使用时解密 1: 全局构造函数解密 2: 解密到栈上
+    };
+
+    struct PassSubstitution {
+        int enable;
+        int prob;
+        int depth;  // 改写深度，新生成的运算继续改写 depth - 1 次
+        int budget; // 单个函数吞吐延迟增长上限 [%]，按循环深度加权，0 表示不限制
+    };
+
+    struct PassFlattening {
+        int enable;
+        int hot;  // 循环头部相对函数入口的执行频率达到该值时整个循环不平坦化，0 表示全部平坦化
+        int mode; // 0: 跳转表分发 1: 稀疏 switch 分发
+    };
+
+    struct PassBogusControlFlow {
+        int enable;
+        int prob;
+        int weights; // 1: 假分支带 !prof 权重并把垃圾代码放入 .text.unlikely 0: 不带权重，用于对比
+        int strength; // 不透明谓词的最低等级 0: ALU 1: 全局变量 2: 线程局部状态
+    };
+
+    struct PassStructReorder {
+        int enable;
+        int locality; // 1: 按访问频率把共同访问的字段放进同一条 cache line 0: 只减少填充
+    };
+
+    struct PassGVMerge {
+        int enable;
+        int locality; // 1: 按访问频率把共同访问的变量放进同一条 cache line 0: 只减少填充
+    };
+
+    struct PassStackLayout {
+        int enable;
+        int padding; // 每个栈帧新增填充的上限 [bytes]，0 表示只重排
+    };
+
+    struct PassFunctionOrder {
+        int enable;
+        int mode; // 0: 在冷热分组内打乱 1: 整体随机打乱，仅用于性能对比
+    };
+
+    struct PassBlockShuffle {
+        int enable;
+        int hot; // 边的概率达到该值 [%] 时两端的块保持顺序执行
+    };
+
+    struct PassApiHiding {
+        int enable;
+        std::string symbols; // 逗号分隔的外部函数名，* 结尾表示前缀匹配，为空时选择编译器不认识的全部外部函数
+    };
+
+    struct PassSwitchEncoding {
+        int enable;
+        int min; // 至少有 min 个 case（不计跳转到 default 的 case）的 switch 才编码
+    };
+
+    struct PassIntegrityCheck {
+        int enable;
+        int interval; // 后台线程校验一遍全部代码的周期 [ms]
+        int chunk;    // 每次唤醒计算的字节数 [KB]，其余时间休眠
+    };
+
+    struct PassIndirectCall {
+        int enable;
+        int prob;
+    };
+
+    struct ObfuscationBudget {
+        int func_growth;    // 单个函数 IR 指令增长上限 [%]，0 表示不限制
+        int module_growth;  // 单个 pass 在 module 上的指令增长上限 [%]
+        int func_time;      // 单个函数耗时上限 [ms]
+        int module_time;    // 单个 pass 在 module 上的耗时上限 [ms]
+        int text_growth;    // 所有 pass 预计新增代码占 module 代码的上限 [%]，0 表示不限制
+        int latency_growth; // 单个函数每次调用预计新增延迟的上限 [%]，0 表示不限制
+    };
+
+    struct ObfuscationScope {
+        int loop_depth; // 循环深度达到该值的块不做指令级混淆，0 表示不限制
+        int innermost;  // 1: 最内层循环中的块不做指令级混淆
+        int hot;        // 块执行次数相对函数入口达到该值时不做指令级混淆，0 表示不限制
+    };
+
+    struct ObfuscationTier {
+        int enable;         // 1: 按 profile 热度给函数分档 none / light / full
+        std::string profile; // .profdata 或 sample profile 路径，为空时使用 IR 中的 profile 信息（-fprofile-use）
+        int none;           // 执行次数最高、合计占总次数 none / 1000000 的代码所在函数不混淆
+        int light;          // 合计占总次数 light / 1000000 的代码所在函数（不含 none 档）轻度混淆
+        int prob;           // light 档函数中各 pass 的 prob 按该比例缩小 [%]
+        int repeat;         // light 档函数中 Substitution.depth 与 FunctionWrapper.times 的上限
+        int flatten;        // 1: light 档函数仍然平坦化
+    };
+
     struct ObfuscationOptions {
         explicit ObfuscationOptions(const Twine &FileName);
 
@@ -40,8 +136,35 @@ namespace llvm {
 
         void dump() const;
 
+        // 有效配置 + 随机种子 + 插件版本的摘要，用于 LTO cache key
+        uint64_t fingerprint() const;
+
         int verbose = false;
 
+        std::string report; // 报告输出目录，为空时不输出
+
+        int mem_profile = false; // 在报告中记录每个 pass 的内存变化
+
+        int runtime = false; // 1: 调用 buer_rt 中的辅助函数，不在每个 module 中生成对应的 IR
+
+        int cold_only = false; // 1: 先做冷热拆分，只混淆拆分出的冷函数和原本就是冷函数的函数
+
+        int rt_profile = false; // 1: 在插件生成的函数入口插入计数器，退出时由 buer_rt 写出
+
+        ObfuscationBudget Budget{
+                .func_growth = 400,
+                .module_growth = 200,
+        };
+
+        ObfuscationScope Scope{};
+
+        ObfuscationTier Tier{
+                .none = 10000,
+                .light = 100000,
+                .prob = 50,
+                .repeat = 1,
+        };
+
         PassHelloWorld HelloWorld{};
 
         PassNameObf FuncNameObf{
@@ -61,9 +184,71 @@ namespace llvm {
                 .times = 5
         };
 
+        PassStringEncryption StringEncryption{
+                .mode = 0
+        };
+
+        PassSubstitution Substitution{
+                .prob = 100,
+                .depth = 1,
+                .budget = 50
+        };
+
+        PassFlattening Flattening{
+                .hot = 8,
+                .mode = 0
+        };
+
+        PassBogusControlFlow BogusControlFlow{
+                .prob = 30,
+                .weights = 1,
+                .strength = 1
+        };
+
+        PassStructReorder StructReorder{
+                .locality = 1
+        };
+
+        PassIndirectCall IndirectCall{
+                .prob = 100
+        };
+
+        PassGVMerge GVMerge{
+                .locality = 1
+        };
+
+        PassStackLayout StackLayout{
+                .padding = 64
+        };
+
+        PassFunctionOrder FunctionOrder{
+                .mode = 0
+        };
+
+        PassBlockShuffle BlockShuffle{
+                .hot = 80
+        };
+
+        PassApiHiding ApiHiding{};
+
+        PassSwitchEncoding SwitchEncoding{
+                .min = 4
+        };
+
+        PassIntegrityCheck IntegrityCheck{
+                .interval = 5000,
+                .chunk = 64
+        };
+
     private:
         void handleRoot(yaml::Node *n);
 
+        void handleBudget(yaml::MappingNode *n);
+
+        void handleScope(yaml::MappingNode *n);
+
+        void handleTier(yaml::MappingNode *n);
+
         void handleHelloWorld(yaml::MappingNode *n);
 
         void handleFuncNameObf(yaml::MappingNode *n);
@@ -72,6 +257,32 @@ namespace llvm {
 
         void handleFunctionWrapper(yaml::MappingNode *n);
 
+        void handleStringEncryption(yaml::MappingNode *n);
+
+        void handleSubstitution(yaml::MappingNode *n);
+
+        void handleFlattening(yaml::MappingNode *n);
+
+        void handleBogusControlFlow(yaml::MappingNode *n);
+
+        void handleIndirectCall(yaml::MappingNode *n);
+
+        void handleStructReorder(yaml::MappingNode *n);
+
+        void handleGVMerge(yaml::MappingNode *n);
+
+        void handleStackLayout(yaml::MappingNode *n);
+
+        void handleFunctionOrder(yaml::MappingNode *n);
+
+        void handleBlockShuffle(yaml::MappingNode *n);
+
+        void handleApiHiding(yaml::MappingNode *n);
+
+        void handleSwitchEncoding(yaml::MappingNode *n);
+
+        void handleIntegrityCheck(yaml::MappingNode *n);
+
         bool parseOptions(const Twine &FileName);
 
         void loadCommandLineArgs();
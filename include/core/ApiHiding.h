@@ -0,0 +1,35 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_APIHIDING_H
+#define OBFUSCATOR_APIHIDING_H
+
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 外部 API 隐藏：对选中外部函数的调用改为调用 Wra_ 包装函数，包装函数从本 module 的指针表中读取地址后调用
+    // 指针表在第一次调用时由 buer.api.resolve 一次性用 dlsym 解析全部表项，函数名加密保存，解析时才解密到栈上
+    class ApiHiding : public PassInfoMixin<ApiHiding> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit ApiHiding(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+
+        // 调用的外部声明可以通过 dlsym 解析并且被 Symbols 选中（逗号分隔，* 结尾表示前缀匹配）；
+        // Symbols 为空时选择 TargetLibraryInfo 不认识的全部外部函数，编译器会优化的库函数需要显式列出
+        static bool isCandidate(CallBase &CB, const TargetLibraryInfo &TLI, StringRef Symbols);
+
+        // 每个被隐藏的函数新增的包装函数指令数（guard 检查 + 读表 + 解码 + 调用）
+        static const uint64_t WrapperCost = 8;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_APIHIDING_H
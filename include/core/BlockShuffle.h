@@ -0,0 +1,27 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_BLOCKSHUFFLE_H
+#define OBFUSCATOR_BLOCKSHUFFLE_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 基本块顺序随机化：沿概率达到阈值的边把基本块连成顺序执行链，链内顺序保持不变，
+    // 只打乱整条链和冷块的先后；入口所在的链保持在最前面，循环头部总是链的第一个块
+    class BlockShuffle : public PassInfoMixin<BlockShuffle> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit BlockShuffle(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_BLOCKSHUFFLE_H
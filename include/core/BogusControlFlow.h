@@ -0,0 +1,32 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_BOGUSCONTROLFLOW_H
+#define OBFUSCATOR_BOGUSCONTROLFLOW_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 虚假控制流：在基本块开头插入恒为真/假的不透明谓词，假分支进入调用垃圾函数的虚假块
+    // 谓词由 OpaquePredicateFactory 生成，strength 指定最低等级
+    // weights 开启时假分支带 !prof 权重 0，垃圾函数标记为 cold 并放入 .text.unlikely，
+    // 块布局会让真实路径保持顺序执行
+    class BogusControlFlow : public PassInfoMixin<BogusControlFlow> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit BogusControlFlow(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &) const;
+
+        // 每个被选中的基本块新增的指令数（谓词 + 分支 + 虚假块）
+        static const uint64_t BlockCost = 8;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_BOGUSCONTROLFLOW_H
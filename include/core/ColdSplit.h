@@ -0,0 +1,28 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_COLDSPLIT_H
+#define OBFUSCATOR_COLDSPLIT_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 只混淆冷代码：先运行 HotColdSplitting，把 profile 或静态启发式判定的冷区域拆分为 <函数名>.cold.N，
+    // 再给拆分出的函数和原本就是冷函数的函数追加各 pass 的注解，其余函数追加 no-<pass>，热路径保持原样；
+    // 用户显式写在函数上的注解优先，拆分出的函数继承原函数的注解
+    class ColdSplit : public PassInfoMixin<ColdSplit> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit ColdSplit(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_COLDSPLIT_H
@@ -0,0 +1,27 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_CONFIGSTAMP_H
+#define OBFUSCATOR_CONFIGSTAMP_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 把混淆配置指纹写入 module flag "buer.obf.config"
+    // ThinLTO 的 cache key 包含 module hash，配置/种子/版本变化后不会复用旧的缓存对象
+    class ConfigStamp : public PassInfoMixin<ConfigStamp> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit ConfigStamp(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_CONFIGSTAMP_H
@@ -0,0 +1,38 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_FLATTENING_H
+#define OBFUSCATOR_FLATTENING_H
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 控制流平坦化：基本块之间的跳转改为写入编码后的状态值，再由分发块跳转
+    // mode 0: 状态值解码为连续下标，分发块 lower 为跳转表
+    // mode 1: 直接按稀疏的随机状态值 switch（比较树），用于性能对比
+    // 头部块频率达到阈值的循环整体保持原样，其中的跳转不经过分发块
+    class Flattening : public PassInfoMixin<Flattening> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit Flattening(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+
+        // 热循环中的基本块，Hot 为循环头部相对入口的执行频率阈值，0 表示全部平坦化
+        static SmallPtrSet<BasicBlock *, 16> hotLoopBlocks(LoopInfo &LI, BlockFrequencyInfo &BFI, int Hot);
+
+        // 异常处理、indirectbr、取地址的基本块等无法经过分发块
+        static bool isSupported(Function &F);
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_FLATTENING_H
@@ -0,0 +1,27 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_FUNCTIONORDER_H
+#define OBFUSCATOR_FUNCTIONORDER_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 函数顺序随机化：按 热 / 普通 / 包装函数 / 冷 分组，组的先后固定，只在组内打乱函数的顺序，
+    // 保留按冷热排布带来的 i-TLB 与 I-cache 局部性；冷热来自 profile 或 hot / cold 属性
+    class FunctionOrder : public PassInfoMixin<FunctionOrder> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit FunctionOrder(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_FUNCTIONORDER_H
@@ -20,6 +20,13 @@ namespace llvm {
         PreservedAnalyses run(Module &M, ModuleAnalysisManager &) const;
 
         static CallBase* HandleCallBase(CallBase* CB);
+
+        // 按 CB 的实参类型创建转发到原被调函数的包装函数，不能包装时返回 nullptr；
+        // Name 为空时命名为 Wra_<被调函数名>
+        static Function* CreateWrapper(CallBase* CB, StringRef Name = "");
+
+        // 把 CB 改为调用 CreateWrapper 生成的包装函数
+        static CallBase* Redirect(CallBase* CB, Function* Wrapper);
     };
 
 } // namespace llvm
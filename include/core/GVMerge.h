@@ -0,0 +1,34 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_GVMERGE_H
+#define OBFUSCATOR_GVMERGE_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 全局变量合并：把内部全局变量按 只读 / 已初始化 / 零初始化 合并进至多三个 64 字节对齐的 blob，
+    // 函数中的访问改为 blob 基址 + 编码后的偏移，运行时减去 module 级密钥还原；
+    // locality 开启时按访问频率把经常在同一函数中访问的变量放进同一条 cache line
+    class GVMerge : public PassInfoMixin<GVMerge> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit GVMerge(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+
+        // 不考虑注解时可以合并的全局变量
+        static bool isCandidate(GlobalVariable &GV);
+
+        // 每处访问新增的指令数（偏移解码 + GEP + 类型转换）
+        static const uint64_t UseCost = 3;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_GVMERGE_H
@@ -0,0 +1,33 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_INDIRECTCALL_H
+#define OBFUSCATOR_INDIRECTCALL_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 间接调用：直接调用改为从函数指针表中读取编码后的地址，减去 module 级密钥后调用
+    // 每个 module 只有一张 64 字节对齐的表，按调用频率从高到低排列，热点表项集中在少数几条 cache line 中
+    class IndirectCall : public PassInfoMixin<IndirectCall> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit IndirectCall(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+
+        // 可以改为间接调用的直接调用点
+        static bool isCandidate(CallBase &CB);
+
+        // 每个调用点新增的指令数（读表 + 解码 + 类型转换）
+        static const uint64_t CallCost = 3;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_INDIRECTCALL_H
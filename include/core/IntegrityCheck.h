@@ -0,0 +1,32 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_INTEGRITYCHECK_H
+#define OBFUSCATOR_INTEGRITYCHECK_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 代码完整性校验：选中的函数放入 buer_ic_text 段，链接后连续排列，由 __start_ / __stop_ 符号界定；
+    // 期望的 CRC32C 放在 buer_ic_sum 段（comdat，每个 so 一份），链接后由 tools/integrity/ic_patch.py 写入。
+    // 全局构造函数只把区间登记给 buer_rt，校验在最低优先级的后台线程中分块进行，不在启动路径和热路径上。仅支持 ELF
+    class IntegrityCheck : public PassInfoMixin<IntegrityCheck> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit IntegrityCheck(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &) const;
+
+        // 段名是合法的 C 标识符，链接器才会生成 __start_ / __stop_ 符号
+        static constexpr const char *TextSection = "buer_ic_text";
+        static constexpr const char *SumSection = "buer_ic_sum";
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_INTEGRITYCHECK_H
@@ -0,0 +1,27 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_OVERHEADPLANNER_H
+#define OBFUSCATOR_OVERHEADPLANNER_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 在混淆之前预测每个函数在各 pass 下的开销，并按优先级在全局预算内挑选混淆对象
+    // 未被选中的函数会被追加 no-<pass> 注解
+    class OverheadPlanner : public PassInfoMixin<OverheadPlanner> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit OverheadPlanner(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_OVERHEADPLANNER_H
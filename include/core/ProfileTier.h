@@ -0,0 +1,28 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_PROFILETIER_H
+#define OBFUSCATOR_PROFILETIER_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // profile 分档：按 ProfileSummary 的热度分位给每个函数分配 none / light / full 档位，写入函数属性 buer.tier；
+    // none 档追加所有 pass 的 no- 注解，light 档由 Eligibility 取得缩小后的 prob / repeat，full 档保持原配置。
+    // 函数上的 tier-none / tier-light / tier-full 注解优先于 profile
+    class ProfileTier : public PassInfoMixin<ProfileTier> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit ProfileTier(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_PROFILETIER_H
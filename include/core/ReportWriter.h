@@ -0,0 +1,26 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_REPORTWRITER_H
+#define OBFUSCATOR_REPORTWRITER_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 在 pipeline 末尾把本编译单元的混淆报告写到 Options->report 目录
+    class ReportWriter : public PassInfoMixin<ReportWriter> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit ReportWriter(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_REPORTWRITER_H
@@ -0,0 +1,32 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_RUNTIMEPROFILE_H
+#define OBFUSCATOR_RUNTIMEPROFILE_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 运行时开销剖析：在各 pass 生成的函数（Wra_*、解密 / 解析辅助函数、拆分出的冷函数等）入口给计数器加一。
+    // 计数表为 [BUER_RT_PROF_SLOTS][stride] 的 i64 数组，每个线程独占按 64 字节对齐的一行，入口只有一次 TLS load、
+    // 一次预测命中的分支和一次不加锁的加法；module 析构时交给 buer_rt 求和写出。文件中只有 module 标识与计数器下标，
+    // 由 tools/report/prof_map.py 通过报告映射回 pass 与来源函数，不把函数名写入二进制
+    class RuntimeProfile : public PassInfoMixin<RuntimeProfile> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit RuntimeProfile(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &) const;
+
+        // 与 buer_rt.h 中的 BUER_RT_PROF_SLOTS 一致
+        static constexpr unsigned Slots = 32;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_RUNTIMEPROFILE_H
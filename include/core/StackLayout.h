@@ -0,0 +1,28 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_STACKLAYOUT_H
+#define OBFUSCATOR_STACKLAYOUT_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 栈布局随机化：打乱入口块中静态 alloca 的顺序，并在冷槽位前插入随机填充
+    // 按块频率统计的访问最频繁的槽位排在最前面，保持在靠近栈帧基址的第一条 cache line 中，
+    // 每个栈帧新增的填充不超过 padding 字节
+    class StackLayout : public PassInfoMixin<StackLayout> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit StackLayout(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_STACKLAYOUT_H
@@ -0,0 +1,36 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_STRINGENCRYPTION_H
+#define OBFUSCATOR_STRINGENCRYPTION_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 字符串加密：常量字符串替换为 XOR 密钥流加密后的密文
+    // mode 0: 首次使用时原地解密，带线程安全的 once guard
+    // mode 1: 全局构造函数中一次性原地解密
+    // mode 2: 每次进入函数时解密到栈上，明文不落在全局内存中
+    class StringEncryption : public PassInfoMixin<StringEncryption> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit StringEncryption(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &) const;
+
+        // 密钥流：第 b 个 16 字节块使用 key + b * delta（逐字节相加）
+        static void encrypt(std::vector<uint8_t> &data, const uint8_t key[16], uint8_t delta);
+
+        // void (i8* dst, i8* src, i64 len, i8* key, i8 delta)，按 16 字节向量块解密
+        // Runtime 为 true 时返回 buer_rt 中的 __buer_rt_v1_decrypt
+        static Function *getDecryptFunction(Module &M, bool Runtime = false);
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_STRINGENCRYPTION_H
@@ -0,0 +1,28 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_STRUCTREORDER_H
+#define OBFUSCATOR_STRUCTREORDER_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 结构体字段重排：随机打乱只在本 module 内部使用、布局不会被外部观察到的结构体的字段顺序
+    // locality 开启时按块频率（有 profile 时按实际次数）把经常一起访问的字段放进同一条 cache line，
+    // 每条 cache line 内按对齐从大到小排列以减少填充；被 memcpy / memset 或按 sizeof 分配的结构体保持原大小
+    class StructReorder : public PassInfoMixin<StructReorder> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit StructReorder(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_STRUCTREORDER_H
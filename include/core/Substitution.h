@@ -0,0 +1,33 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_SUBSTITUTION_H
+#define OBFUSCATOR_SUBSTITUTION_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // 指令替换：用随机选择的 MBA (mixed boolean-arithmetic) 恒等式改写 add/sub/xor/and/or
+    // 每个函数按 TTI 吞吐代价和循环深度维护延迟预算，按 收益 / 代价 从高到低选择改写对象
+    class Substitution : public PassInfoMixin<Substitution> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit Substitution(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+
+        // 可以改写的指令：非 i1 整数上的 add/sub/xor/and/or，且操作数不全为常量
+        static bool isCandidate(Instruction &I);
+
+        // 一条指令按深度 depth 改写后最多变成多少条指令
+        static uint64_t expansion(int depth);
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_SUBSTITUTION_H
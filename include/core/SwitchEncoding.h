@@ -0,0 +1,34 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_SWITCHENCODING_H
+#define OBFUSCATOR_SWITCHENCODING_H
+
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/PassPlugin.h>
+#include "ObfuscationOptions.h"
+
+namespace llvm {
+
+    // switch 常量编码：为每个 switch 的 case 值生成最小完美哈希（乘移位 + 分桶位移表），
+    // 条件值先哈希到槽位，再与表中 异或编码 后的 case 值比较，相等时按槽位下标跳转；
+    // 槽位是 [0, 2^n) 内的稠密下标，后端仍然生成 O(1) 的跳转表，代码中不再出现原始 case 常量
+    class SwitchEncoding : public PassInfoMixin<SwitchEncoding> {
+        ObfuscationOptions* Options;
+
+    public:
+        explicit SwitchEncoding(ObfuscationOptions* Options) : Options(Options) {}
+
+        PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM) const;
+
+        // 不考虑 case 数量时可以编码的 switch
+        static bool isCandidate(SwitchInst &SI);
+
+        // 每个 switch 新增的指令数（哈希 + 两次查表 + 比较 + 条件跳转）
+        static const uint64_t DispatchCost = 12;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_SWITCHENCODING_H
@@ -0,0 +1,68 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef BUER_RT_H
+#define BUER_RT_H
+
+// 混淆 pass 注入代码使用的运行时辅助函数（-obf-rt=1 时调用，否则每个 module 各自生成等价的 IR）
+// ABI 稳定：函数名带版本号，签名或语义变化时新增 _v2 函数，旧版本继续保留，已编译的目标文件不受影响
+// 所有函数为 hidden 可见性，静态链接进每个 so，不会跨 so 相互覆盖
+
+#include <stdint.h>
+
+#define BUER_RT_ABI_VERSION 1
+
+// guard 状态
+#define BUER_RT_UNINIT 0
+#define BUER_RT_RUNNING 1
+#define BUER_RT_DONE 2
+#define BUER_RT_WAITING 3 // 正在执行且有线程在 futex 上等待
+
+// RuntimeProfile 计数表的行数：每个线程独占一行，用尽时其余线程共用最后一行
+#define BUER_RT_PROF_SLOTS 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 密钥流解密：第 b 个 16 字节块使用 key + b * delta（逐字节相加），dst 与 src 可以相同
+// 按 CPU 特性选择 AVX2 / SSE2 / NEON / 标量实现
+void __buer_rt_v1_decrypt(uint8_t *dst, const uint8_t *src, uint64_t len, const uint8_t *key, uint8_t delta);
+
+// 第一次调用时原地解密 data，其他线程在 futex 上等待解密完成；调用方先检查 *guard == BUER_RT_DONE
+void __buer_rt_v1_once(uint32_t *guard, uint8_t *data, uint64_t len, const uint8_t *key, uint8_t delta);
+
+// 第一次调用时把 names（\0 分隔、按 key / delta 加密）解密到栈上，逐项 dlsym(RTLD_DEFAULT) 后
+// 把 地址 + enc_key 写入 table，最后清空明文；其他线程在 futex 上等待解析完成
+void __buer_rt_v1_resolve(uint32_t *guard, void **table, uint32_t count, const uint8_t *names, uint64_t len,
+                          const uint8_t *key, uint8_t delta, const uint32_t *offsets, uintptr_t enc_key);
+
+// CRC32C（Castagnoli），与 zlib 的 crc32 用法相同：初值传 0，分段计算时传入上一段的结果
+// x86 上有 SSE4.2、ARM 上编译时带 +crc 时用硬件指令三路并行，否则查表
+uint32_t __buer_rt_v1_crc32c(uint32_t crc, const uint8_t *data, uint64_t len);
+
+// 登记需要校验的代码区间 [begin, end)，*expected 为链接后由 tools/integrity/ic_patch.py 写入的 CRC32C，为 0 时不校验
+// 第一次登记时启动最低优先级的后台线程：每 interval_ms 校验一遍全部区间，每次只计算 chunk_kb，
+// 其余时间休眠，第一次计算在启动 interval_ms / 分块数 之后；校验失败时 abort
+void __buer_rt_v1_ic_register(const uint8_t *begin, const uint8_t *end, const uint32_t *expected,
+                              uint32_t interval_ms, uint32_t chunk_kb);
+
+// 后台校验累计的字节数、线程 CPU 时间 [ns] 与完成的轮数，用于评估开销
+void __buer_rt_v1_ic_stats(uint64_t *bytes, uint64_t *cpu_ns, uint64_t *rounds);
+
+// 当前线程在计数表中的行号 + 1，0 表示尚未分配；注入的计数代码直接读取（initial-exec）
+extern __thread uint32_t __buer_rt_v1_prof_slot;
+
+// 为当前线程分配一行并写入 __buer_rt_v1_prof_slot，返回行号 + 1；线程退出时归还
+uint32_t __buer_rt_v1_prof_thread(void);
+
+// 把 counters（BUER_RT_PROF_SLOTS 行，每行 stride 个）按列求和，非 0 的项以 "<module> <index> <count>" 追加到
+// 环境变量 BUER_PROF_FILE 指定的文件，默认为当前目录下的 buer-prof.<pid>.txt；由每个 module 的析构函数调用
+void __buer_rt_v1_prof_dump(uint32_t module, const uint64_t *counters, uint32_t count, uint32_t stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BUER_RT_H
@@ -0,0 +1,59 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_BUDGET_H
+#define OBFUSCATOR_BUDGET_H
+
+#include "ObfuscationOptions.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Module.h>
+#include <chrono>
+
+namespace llvm {
+
+    // 混淆强度预算：限制单个 pass 带来的 IR 膨胀和耗时
+    // 超出预算时由 pass 自行降级（减少轮数、降低概率），并通过 degrade() 记录
+    class BudgetTracker {
+    public:
+        BudgetTracker(ObfuscationOptions *Options, StringRef Pass, Module &M);
+
+        // F 在函数预算和 module 预算内还能新增的指令数
+        uint64_t remaining(Function &F);
+
+        // 记录为 F 新增的指令数
+        void charge(Function &F, uint64_t Added);
+
+        // 开始处理一个新函数，重置函数计时
+        void startFunction();
+
+        bool functionTimeExceeded() const;
+
+        bool moduleTimeExceeded() const;
+
+        // 输出并记录一次降级
+        void degrade(const GlobalValue &GV, StringRef Message) const;
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        // 指令很少的函数按此值计算预算，避免小函数被过度降级
+        static const uint64_t MinFunctionBase = 64;
+
+        struct FunctionUsage {
+            uint64_t base = 0;
+            uint64_t added = 0;
+        };
+
+        ObfuscationOptions *Options;
+        std::string Pass;
+        uint64_t moduleBase = 0;
+        uint64_t moduleAdded = 0;
+        DenseMap<Function *, FunctionUsage> usage;
+        clock::time_point moduleStart;
+        clock::time_point functionStart;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_BUDGET_H
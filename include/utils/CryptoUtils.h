@@ -54,6 +54,9 @@ namespace llvm {
         // Returns a uniformly distributed 64-bit value
         uint64_t get_uint64_t();
 
+        // Number of times the pool has been (re)filled
+        uint64_t get_refills() const { return refills; }
+
         // Scramble a 32-bit value depending on a 128-bit value
         static unsigned scramble32(unsigned in, const char key[16]);
 
@@ -65,6 +68,7 @@ namespace llvm {
         char ctr[16]{};
         char pool[CryptoUtils_POOL_SIZE]{};
         uint32_t idx{};
+        uint64_t refills{};
         std::string seed;
         bool seeded;
 
@@ -0,0 +1,47 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_OPAQUEPREDICATE_H
+#define OBFUSCATOR_OPAQUEPREDICATE_H
+
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Module.h>
+
+namespace llvm {
+
+    // 不透明谓词的强度等级，等级越高越难静态求值，运行期开销也越高
+    enum class OpaqueTier {
+        ALU = 0,         // 只对函数参数做数论运算，没有访存；参数为常量时可被 IPSCCP 折叠
+        Global = 1,      // 读取共享的只读全局变量，链接期无法折叠
+        ThreadLocal = 2, // 读取线程局部状态并在每次求值后改写，值随执行变化
+    };
+
+    // 生成 O3 下不会被折叠、恒等于给定真值的谓词
+    // 谓词对任意输入都成立：x * (x + 1) 为偶数，或 7 * y^2 - 1 != x^2（两边模 8 不相交）
+    class OpaquePredicateFactory {
+    public:
+        explicit OpaquePredicateFactory(Module &M) : M(M) {}
+
+        // 在 IRB 当前位置生成恒等于 Truth 的谓词，X 返回参与运算的 i32 值，可供虚假路径使用
+        Value *create(IRBuilder<> &IRB, OpaqueTier Tier, bool Truth, Value *&X);
+
+        // F 中满足强度要求的最便宜等级：ALU 需要外部可见函数的整数参数，否则升到 Global
+        static OpaqueTier choose(Function &F, OpaqueTier MinTier);
+
+        // 一个谓词的预计延迟 (TCK_Latency)，不含使用谓词的分支
+        static uint64_t cost(TargetTransformInfo &TTI, LLVMContext &Ctx, OpaqueTier Tier);
+
+    private:
+        Module &M;
+
+        GlobalVariable *getGlobal(StringRef Name, bool ThreadLocal);
+
+        // Tier 对应的谓词输入
+        Value *getOperand(IRBuilder<> &IRB, OpaqueTier Tier);
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_OPAQUEPREDICATE_H
@@ -0,0 +1,66 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_OVERHEAD_H
+#define OBFUSCATOR_OVERHEAD_H
+
+#include "ObfuscationOptions.h"
+#include "utils/Utils.h"
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/PassManager.h>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+    // 某个 pass 作用在某个函数上的开销，单位为 TTI cost
+    struct PassOverhead {
+        std::string pass;
+        uint64_t size = 0;   // 新增代码大小 (TCK_CodeSize)
+        double latency = 0;  // 函数每次调用新增的延迟 (TCK_Latency，按块频率加权)
+    };
+
+    // 在变换之前用 TargetTransformInfo 静态预测各 pass 的开销
+    class OverheadEstimator {
+    public:
+        OverheadEstimator(ObfuscationOptions *Options, FunctionAnalysisManager &FAM)
+                : Options(Options), FAM(FAM) {}
+
+        // F 当前的代码大小
+        uint64_t size(Function &F);
+
+        // F 每次调用的延迟
+        double latency(Function &F);
+
+        // F 在所有已开启且会作用于它的 pass 下的开销
+        std::vector<PassOverhead> estimate(Function &F);
+
+    private:
+        ObfuscationOptions *Options;
+        FunctionAnalysisManager &FAM;
+
+        static uint64_t cost(TargetTransformInfo &TTI, Instruction &I, TargetTransformInfo::TargetCostKind Kind);
+
+        PassOverhead estimateFunctionWrapper(Function &F, const Eligibility &Scope);
+
+        PassOverhead estimateStringEncryption(Function &F);
+
+        PassOverhead estimateSubstitution(Function &F, const Eligibility &Scope);
+
+        PassOverhead estimateFlattening(Function &F, const Eligibility &Scope);
+
+        PassOverhead estimateBogusControlFlow(Function &F, const Eligibility &Scope);
+
+        PassOverhead estimateIndirectCall(Function &F, const Eligibility &Scope);
+
+        PassOverhead estimateGVMerge(Function &F);
+
+        PassOverhead estimateApiHiding(Function &F, const Eligibility &Scope);
+
+        PassOverhead estimateSwitchEncoding(Function &F, const Eligibility &Scope);
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_OVERHEAD_H
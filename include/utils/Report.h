@@ -0,0 +1,134 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef OBFUSCATOR_REPORT_H
+#define OBFUSCATOR_REPORT_H
+
+#include "ObfuscationOptions.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+    // module 规模快照
+    struct ModuleSize {
+        uint64_t functions = 0;
+        uint64_t blocks = 0;
+        uint64_t instructions = 0;
+
+        static ModuleSize of(Module &M);
+    };
+
+    // 进程内存快照，单位字节
+    struct MemorySample {
+        uint64_t rss = 0;
+        uint64_t peak = 0;
+        uint64_t heap = 0;
+
+        static MemorySample now();
+    };
+
+    // 单个 pass 在一个 module 上的运行记录
+    struct PassRecord {
+        std::string pass;
+        ModuleSize before;
+        ModuleSize after;
+        double seconds = 0;
+        bool memory = false; // 是否开启了内存统计
+        MemorySample memBefore;
+        MemorySample memAfter;
+    };
+
+    // OverheadPlanner 对某个函数、某个 pass 的预测与决策
+    struct PlanEntry {
+        std::string function;
+        std::string pass;
+        Function *F = nullptr;
+        uint64_t baseSize = 0;
+        double baseLatency = 0;
+        uint64_t size = 0;      // 预测新增大小
+        double latency = 0;     // 预测每次调用新增延迟
+        bool selected = false;
+        int64_t measured = -1;  // 实际新增大小，由 ReportWriter 在混淆后填写
+    };
+
+    // pass 生成的函数及其来源函数
+    struct GeneratedFunction {
+        std::string pass;
+        Function *F;
+        Function *source;
+    };
+
+    // 降级、跳过等需要告知用户的事件
+    struct ReportNote {
+        std::string pass;
+        std::string object;
+        std::string message;
+    };
+
+    // 单个编译单元的混淆报告，由 ReportWriter 在 pipeline 末尾写出
+    class ObfuscationReport {
+    public:
+        void addPass(PassRecord Record);
+
+        void addNote(StringRef Pass, StringRef Object, StringRef Message);
+
+        void addPlan(PlanEntry Entry);
+
+        void addGenerated(StringRef Pass, Function *F, Function *Source);
+
+        // FuncNameObf 改名前的函数名，报告中按原名映射
+        void addRenamed(Function *F, StringRef Original);
+
+        // RuntimeProfile 为函数分配的计数器下标
+        void addCounter(Function *F, uint32_t Index);
+
+        // 函数被重建（如 StructReorder 改写签名）时，把记录中的 Old 换成 New，Old 随后会被删除
+        void replaceFunction(Function *Old, Function *New);
+
+        const std::vector<GeneratedFunction> &getGenerated() const { return generated; }
+
+        // 报告文件名与运行时计数中使用的 module 标识：module id 的 hash
+        static uint32_t moduleId(const Module &M);
+
+        // 混淆完成后用 Size 计算每个已选中计划项的实际新增大小
+        void measure(function_ref<uint64_t(Function &)> Size);
+
+        void write(raw_ostream &OS, Module &M, ObfuscationOptions *Options) const;
+
+        void clear();
+
+    private:
+        std::vector<PassRecord> passes;
+        std::vector<ReportNote> notes;
+        std::vector<PlanEntry> plan;
+        std::vector<GeneratedFunction> generated;
+        DenseMap<Function *, std::string> renamed;
+        DenseMap<Function *, uint32_t> counters;
+    };
+
+    extern ManagedStatic<ObfuscationReport> report;
+
+    // RAII：记录 pass 运行前后的 module 规模和耗时，mem_profile 开启时还会记录内存
+    class PassRecorder {
+    public:
+        PassRecorder(ObfuscationOptions *Options, StringRef Pass, Module &M);
+
+        ~PassRecorder();
+
+    private:
+        ObfuscationOptions *Options;
+        Module &M;
+        PassRecord Record;
+        std::chrono::steady_clock::time_point start;
+    };
+
+} // namespace llvm
+
+#endif //OBFUSCATOR_REPORT_H
@@ -1,9 +1,12 @@
 #ifndef OBFUSCATOR_UTILS_H
 #define OBFUSCATOR_UTILS_H
 
+#include <llvm/IR/Dominators.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/PassManager.h>
 #include <llvm/Transforms/Utils/Local.h> // For DemoteRegToStack and DemotePHIToStack
+#include "ObfuscationOptions.h"
 
 namespace llvm {
     bool valueEscapes(Instruction *Inst);
@@ -12,10 +15,67 @@ namespace llvm {
 
     void fixStack(Function &F);
 
+    // 修改 CFG 之后调用：只降级前驱已变化的 PHI 和不再支配所有使用的值，DT 须基于新的 CFG
+    void fixStack(Function &F, DominatorTree &DT);
+
     std::string readAnnotate(GlobalObject *go);
 
+    // 给函数追加注解，与 __attribute__((annotate)) 等效，供 pass 之间传递决策
+    void addAnnotate(Function &F, StringRef annotation);
+
+    // 用 From 的全部注解（函数属性与 llvm.global.annotations）替换 F 的注解属性，供 pass 生成的函数沿用原函数的决策
+    void inheritAnnotate(Function &F, GlobalObject *From);
+
     bool toObfuscate(int flag, GlobalObject *go, const std::string& attribute);
 
+    // 给函数追加所有作用于函数代码的 pass 的注解，Enable 为 false 时追加 no-<pass>；已有显式注解的 pass 保持不变
+    void addPassAnnotates(Function &F, bool Enable);
+
+    // ProfileTier 写入的函数档位 none / light / full，未写入时为空
+    StringRef readTier(const Function &F);
+
+    void writeTier(Function &F, StringRef Tier);
+
+    class BlockFrequencyInfo;
+    class LoopInfo;
+
+    // 指令级混淆范围：toObfuscate 的函数级判断之上，再按 Scope 配置过滤基本块与指令
+    // cold 函数（或 profile 入口计数为 0）中的块全部可混淆；hot 函数在配置了任一阈值时排除所有循环中的块；
+    // 其余函数按循环深度、是否最内层循环、块相对入口的执行次数排除。需要在修改 CFG 之前查询；
+    // light 档的函数通过 prob / repeat 取得按 Tier 配置缩小的参数
+    class Eligibility {
+    public:
+        Eligibility(ObfuscationOptions *Options, int flag, Function &F, const std::string &attribute,
+                    FunctionAnalysisManager &FAM);
+
+        // 与 toObfuscate(flag, &F, attribute) 相同
+        bool function() const { return enabled; }
+
+        bool block(const BasicBlock &BB) const;
+
+        bool instruction(const Instruction &I) const { return block(*I.getParent()); }
+
+        // pass 的 prob 在函数所在档位的取值
+        int prob(int Prob) const { return light ? Prob * Tier.prob / 100 : Prob; }
+
+        // 改写深度、包装轮数等重复次数在函数所在档位的取值
+        int repeat(int Repeat) const { return light ? std::min(Repeat, Tier.repeat) : Repeat; }
+
+    private:
+        const ObfuscationScope &Scope;
+        const ObfuscationTier &Tier;
+        bool enabled;
+        bool light = false;
+        bool cold = false;
+        bool hot = false;
+        LoopInfo *LI = nullptr;
+        BlockFrequencyInfo *BFI = nullptr;
+        double entry = 1;
+    };
+
+    // buer_rt 中的辅助函数声明（见 runtime/buer_rt.h），hidden 且 dso_local，调用不经过 PLT
+    Function *getRuntimeFunction(Module &M, StringRef Name, FunctionType *FTy);
+
     void LowerConstantExpr(Function &F);
 
     void printInst(Instruction *ins);
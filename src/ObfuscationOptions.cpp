@@ -2,10 +2,12 @@
 #include <llvm/ADT/SmallString.h>
 #include <llvm/Support/ErrorOr.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/CommandLine.h>
 #include "utils/CryptoUtils.h"
+#include "Version.h"
 #include <fmt/core.h>
 #include <fmt/color.h>
 #include <string>
@@ -19,6 +21,62 @@ namespace llvm {
     static cl::opt<std::string> RandomSeed("obf-seed", cl::init(""),
                                            cl::desc("random seed, 32bit hex, 0x is accepted"), cl::Optional);
     static cl::opt<int> Verbose("obf-verbose", cl::init(0), cl::desc("Print obf log"));
+    static cl::opt<std::string> ReportDir("obf-report", cl::init(""),
+                                          cl::desc("Directory for per-TU obfuscation reports"), cl::Optional);
+    static cl::opt<int> MemProfile("obf-mem-profile", cl::init(0),
+                                   cl::desc("Record RSS and heap deltas of each pass in the report"));
+    static cl::opt<int> Runtime("obf-rt", cl::init(0),
+                                cl::desc("Call helpers in buer_rt instead of emitting them into every module"));
+    static cl::opt<int> ColdOnly("obf-cold-only", cl::init(0),
+                                 cl::desc("Split cold regions out and obfuscate only cold functions"));
+    static cl::opt<int> RuntimeProfile("obf-rt-prof", cl::init(0),
+                                       cl::desc("Count entries of generated functions and dump them at exit"));
+
+    // 膨胀与耗时预算
+    static cl::opt<int> BudgetFuncGrowth("obf-budget-fg", cl::init(400),
+                                         cl::desc("Max IR growth per function [%], 0 = unlimited"), cl::Optional);
+    static cl::opt<int> BudgetModuleGrowth("obf-budget-mg", cl::init(200),
+                                           cl::desc("Max IR growth per pass and module [%], 0 = unlimited"),
+                                           cl::Optional);
+    static cl::opt<int> BudgetFuncTime("obf-budget-ft", cl::init(0),
+                                       cl::desc("Max time per function [ms], 0 = unlimited"), cl::Optional);
+    static cl::opt<int> BudgetModuleTime("obf-budget-mt", cl::init(0),
+                                         cl::desc("Max time per pass and module [ms], 0 = unlimited"), cl::Optional);
+    static cl::opt<int> BudgetTextGrowth("obf-budget-text", cl::init(0),
+                                         cl::desc("Max predicted .text growth of all passes [%], 0 = unlimited"),
+                                         cl::Optional);
+    static cl::opt<int> BudgetLatencyGrowth("obf-budget-lat", cl::init(0),
+                                            cl::desc("Max predicted latency growth per function [%], 0 = unlimited"),
+                                            cl::Optional);
+
+    // 指令级混淆范围
+    static cl::opt<int> ScopeLoopDepth("obf-scope-ld", cl::init(0),
+                                       cl::desc("Skip blocks at this loop depth or deeper, 0 = unlimited"),
+                                       cl::Optional);
+    static cl::opt<int> ScopeInnermost("obf-scope-inner", cl::init(0),
+                                       cl::desc("Skip blocks in innermost loops"), cl::Optional);
+    static cl::opt<int> ScopeHot("obf-scope-hot", cl::init(0),
+                                 cl::desc("Skip blocks executed at least this many times per call, 0 = unlimited"),
+                                 cl::Optional);
+
+    // profile 分档
+    static cl::opt<int> TierEnable("obf-tier", cl::init(0),
+                                   cl::desc("Assign none / light / full tiers by profile hotness"), cl::Optional);
+    static cl::opt<std::string> TierProfile("obf-tier-profile", cl::init(""),
+                                            cl::desc("Instrumentation (.profdata) or sample profile used for tiers"),
+                                            cl::Optional);
+    static cl::opt<int> TierNone("obf-tier-none", cl::init(10000),
+                                 cl::desc("Hottest code covering this share of counts [per million] is not obfuscated"),
+                                 cl::Optional);
+    static cl::opt<int> TierLight("obf-tier-light", cl::init(100000),
+                                  cl::desc("Hot code covering this share of counts [per million] is lightly obfuscated"),
+                                  cl::Optional);
+    static cl::opt<int> TierProb("obf-tier-prob", cl::init(50),
+                                 cl::desc("Scale of pass probabilities in the light tier [%]"), cl::Optional);
+    static cl::opt<int> TierRepeat("obf-tier-repeat", cl::init(1),
+                                   cl::desc("Max substitution depth and wrapper rounds in the light tier"), cl::Optional);
+    static cl::opt<int> TierFlatten("obf-tier-fla", cl::init(0),
+                                    cl::desc("Still flatten functions in the light tier"), cl::Optional);
 
     // 函数名混淆
     static cl::opt<int> FuncNameObfEnable("obf-fn", cl::init(0), cl::desc("Enable the FunctionNameObf pass"));
@@ -50,6 +108,112 @@ namespace llvm {
     static cl::opt<int> FunctionWrapperTimes("obf-fw-t", cl::init(5),
                                              cl::desc("Obfuscate times"), cl::Optional);
 
+    // 字符串加密
+    static cl::opt<int> StringEncryptionEnable("obf-se", cl::init(0),
+                                               cl::desc("Enable the StringEncryption pass"));
+    static cl::opt<int> StringEncryptionMode("obf-se-m", cl::init(0),
+                                             cl::desc("0: decrypt on first use, 1: decrypt in global ctor, "
+                                                      "2: decrypt to stack"), cl::Optional);
+
+    // 指令替换
+    static cl::opt<int> SubstitutionEnable("obf-sub", cl::init(0),
+                                           cl::desc("Enable the Substitution pass"));
+    static cl::opt<int> SubstitutionProb("obf-sub-p", cl::init(100),
+                                         cl::desc("Obfuscate probability [%]"), cl::Optional);
+    static cl::opt<int> SubstitutionDepth("obf-sub-d", cl::init(1),
+                                          cl::desc("Rewrite depth"), cl::Optional);
+    static cl::opt<int> SubstitutionBudget("obf-sub-b", cl::init(50),
+                                           cl::desc("Max weighted throughput growth per function [%], "
+                                                    "0 = unlimited"), cl::Optional);
+
+    // 控制流平坦化
+    static cl::opt<int> FlatteningEnable("obf-fla", cl::init(0),
+                                         cl::desc("Enable the Flattening pass"));
+    static cl::opt<int> FlatteningHot("obf-fla-hot", cl::init(8),
+                                      cl::desc("Keep loops whose header runs at least this many times per call, "
+                                               "0 = flatten all loops"), cl::Optional);
+    static cl::opt<int> FlatteningMode("obf-fla-m", cl::init(0),
+                                       cl::desc("0: jump table dispatcher, 1: sparse switch dispatcher"),
+                                       cl::Optional);
+
+    // 虚假控制流
+    static cl::opt<int> BogusControlFlowEnable("obf-bcf", cl::init(0),
+                                               cl::desc("Enable the BogusControlFlow pass"));
+    static cl::opt<int> BogusControlFlowProb("obf-bcf-p", cl::init(30),
+                                             cl::desc("Obfuscate probability [%]"), cl::Optional);
+    static cl::opt<int> BogusControlFlowWeights("obf-bcf-w", cl::init(1),
+                                                cl::desc("Mark bogus edges never taken and move junk code to "
+                                                         ".text.unlikely"), cl::Optional);
+    static cl::opt<int> BogusControlFlowStrength("obf-bcf-s", cl::init(1),
+                                                 cl::desc("Minimum opaque predicate tier, 0: ALU only, "
+                                                          "1: shared global, 2: thread-local state"),
+                                                 cl::Optional);
+
+    // 全局变量合并
+    static cl::opt<int> GVMergeEnable("obf-gvm", cl::init(0),
+                                      cl::desc("Enable the GVMerge pass"));
+    static cl::opt<int> GVMergeLocality("obf-gvm-l", cl::init(1),
+                                        cl::desc("Group globals accessed together into the same cache line"),
+                                        cl::Optional);
+
+    // 栈布局随机化
+    static cl::opt<int> StackLayoutEnable("obf-sl", cl::init(0),
+                                          cl::desc("Enable the StackLayout pass"));
+    static cl::opt<int> StackLayoutPadding("obf-sl-pad", cl::init(64),
+                                           cl::desc("Max padding added to a stack frame in bytes"),
+                                           cl::Optional);
+
+    // 函数顺序随机化
+    static cl::opt<int> FunctionOrderEnable("obf-fo", cl::init(0),
+                                            cl::desc("Enable the FunctionOrder pass"));
+    static cl::opt<int> FunctionOrderMode("obf-fo-m", cl::init(0),
+                                          cl::desc("0: shuffle inside hot/cold buckets, 1: fully random"),
+                                          cl::Optional);
+
+    // 基本块顺序随机化
+    static cl::opt<int> BlockShuffleEnable("obf-bs", cl::init(0),
+                                           cl::desc("Enable the BlockShuffle pass"));
+    static cl::opt<int> BlockShuffleHot("obf-bs-hot", cl::init(80),
+                                        cl::desc("Keep blocks joined by an edge at least this likely [%] in order"),
+                                        cl::Optional);
+
+    // 外部 API 隐藏
+    static cl::opt<int> ApiHidingEnable("obf-api", cl::init(0),
+                                        cl::desc("Enable the ApiHiding pass"));
+    static cl::opt<std::string> ApiHidingSymbols("obf-api-s", cl::init(""),
+                                                 cl::desc("Comma separated external functions to hide, "
+                                                          "a trailing * matches a prefix"),
+                                                 cl::Optional);
+
+    // switch 常量编码
+    static cl::opt<int> SwitchEncodingEnable("obf-swe", cl::init(0),
+                                             cl::desc("Enable the SwitchEncoding pass"));
+    static cl::opt<int> SwitchEncodingMin("obf-swe-min", cl::init(4),
+                                          cl::desc("Encode switches with at least this many cases"),
+                                          cl::Optional);
+
+    // 代码完整性校验
+    static cl::opt<int> IntegrityCheckEnable("obf-ic", cl::init(0),
+                                             cl::desc("Enable the IntegrityCheck pass"));
+    static cl::opt<int> IntegrityCheckInterval("obf-ic-interval", cl::init(5000),
+                                               cl::desc("Period of a full background check [ms]"),
+                                               cl::Optional);
+    static cl::opt<int> IntegrityCheckChunk("obf-ic-chunk", cl::init(64),
+                                            cl::desc("Bytes checksummed per wake-up [KB]"), cl::Optional);
+
+    // 间接调用
+    static cl::opt<int> IndirectCallEnable("obf-icall", cl::init(0),
+                                           cl::desc("Enable the IndirectCall pass"));
+    static cl::opt<int> IndirectCallProb("obf-icall-p", cl::init(100),
+                                         cl::desc("Obfuscate probability [%]"), cl::Optional);
+
+    // 结构体字段重排
+    static cl::opt<int> StructReorderEnable("obf-sr", cl::init(0),
+                                            cl::desc("Enable the StructReorder pass"));
+    static cl::opt<int> StructReorderLocality("obf-sr-l", cl::init(1),
+                                              cl::desc("Group fields accessed together into the same cache line"),
+                                              cl::Optional);
+
 
     ObfuscationOptions::ObfuscationOptions() { // 获取home目录失败才执行
         loadCommandLineArgs();
@@ -68,6 +232,72 @@ namespace llvm {
         if (Verbose.getNumOccurrences()) {
             verbose = Verbose;
         }
+        if (ReportDir.getNumOccurrences()) {
+            report = ReportDir;
+        }
+        if (MemProfile.getNumOccurrences()) {
+            mem_profile = MemProfile;
+        }
+        if (Runtime.getNumOccurrences()) {
+            runtime = Runtime;
+        }
+        if (ColdOnly.getNumOccurrences()) {
+            cold_only = ColdOnly;
+        }
+        if (RuntimeProfile.getNumOccurrences()) {
+            rt_profile = RuntimeProfile;
+        }
+        // 膨胀与耗时预算
+        if (BudgetFuncGrowth.getNumOccurrences()) {
+            Budget.func_growth = BudgetFuncGrowth;
+        }
+        if (BudgetModuleGrowth.getNumOccurrences()) {
+            Budget.module_growth = BudgetModuleGrowth;
+        }
+        if (BudgetFuncTime.getNumOccurrences()) {
+            Budget.func_time = BudgetFuncTime;
+        }
+        if (BudgetModuleTime.getNumOccurrences()) {
+            Budget.module_time = BudgetModuleTime;
+        }
+        if (BudgetTextGrowth.getNumOccurrences()) {
+            Budget.text_growth = BudgetTextGrowth;
+        }
+        if (BudgetLatencyGrowth.getNumOccurrences()) {
+            Budget.latency_growth = BudgetLatencyGrowth;
+        }
+        // 指令级混淆范围
+        if (ScopeLoopDepth.getNumOccurrences()) {
+            Scope.loop_depth = ScopeLoopDepth;
+        }
+        if (ScopeInnermost.getNumOccurrences()) {
+            Scope.innermost = ScopeInnermost;
+        }
+        if (ScopeHot.getNumOccurrences()) {
+            Scope.hot = ScopeHot;
+        }
+        // profile 分档
+        if (TierEnable.getNumOccurrences()) {
+            Tier.enable = TierEnable;
+        }
+        if (TierProfile.getNumOccurrences()) {
+            Tier.profile = TierProfile;
+        }
+        if (TierNone.getNumOccurrences()) {
+            Tier.none = TierNone;
+        }
+        if (TierLight.getNumOccurrences()) {
+            Tier.light = TierLight;
+        }
+        if (TierProb.getNumOccurrences()) {
+            Tier.prob = TierProb;
+        }
+        if (TierRepeat.getNumOccurrences()) {
+            Tier.repeat = TierRepeat;
+        }
+        if (TierFlatten.getNumOccurrences()) {
+            Tier.flatten = TierFlatten;
+        }
         if (HelloWorldEnable.getNumOccurrences()) {
             HelloWorld.enable = HelloWorldEnable;
         }
@@ -118,6 +348,115 @@ namespace llvm {
         if (FunctionWrapperTimes.getNumOccurrences()) {
             FunctionWrapper.times = FunctionWrapperTimes;
         }
+        // 字符串加密
+        if (StringEncryptionEnable.getNumOccurrences()) {
+            StringEncryption.enable = StringEncryptionEnable;
+        }
+        if (StringEncryptionMode.getNumOccurrences()) {
+            StringEncryption.mode = StringEncryptionMode;
+        }
+        // 指令替换
+        if (SubstitutionEnable.getNumOccurrences()) {
+            Substitution.enable = SubstitutionEnable;
+        }
+        if (SubstitutionProb.getNumOccurrences()) {
+            Substitution.prob = SubstitutionProb;
+        }
+        if (SubstitutionDepth.getNumOccurrences()) {
+            Substitution.depth = SubstitutionDepth;
+        }
+        if (SubstitutionBudget.getNumOccurrences()) {
+            Substitution.budget = SubstitutionBudget;
+        }
+        // 控制流平坦化
+        if (FlatteningEnable.getNumOccurrences()) {
+            Flattening.enable = FlatteningEnable;
+        }
+        if (FlatteningHot.getNumOccurrences()) {
+            Flattening.hot = FlatteningHot;
+        }
+        if (FlatteningMode.getNumOccurrences()) {
+            Flattening.mode = FlatteningMode;
+        }
+        // 虚假控制流
+        if (BogusControlFlowEnable.getNumOccurrences()) {
+            BogusControlFlow.enable = BogusControlFlowEnable;
+        }
+        if (BogusControlFlowProb.getNumOccurrences()) {
+            BogusControlFlow.prob = BogusControlFlowProb;
+        }
+        if (BogusControlFlowWeights.getNumOccurrences()) {
+            BogusControlFlow.weights = BogusControlFlowWeights;
+        }
+        if (BogusControlFlowStrength.getNumOccurrences()) {
+            BogusControlFlow.strength = BogusControlFlowStrength;
+        }
+        // 间接调用
+        if (IndirectCallEnable.getNumOccurrences()) {
+            IndirectCall.enable = IndirectCallEnable;
+        }
+        if (IndirectCallProb.getNumOccurrences()) {
+            IndirectCall.prob = IndirectCallProb;
+        }
+        // 结构体字段重排
+        if (StructReorderEnable.getNumOccurrences()) {
+            StructReorder.enable = StructReorderEnable;
+        }
+        if (StructReorderLocality.getNumOccurrences()) {
+            StructReorder.locality = StructReorderLocality;
+        }
+        // 全局变量合并
+        if (GVMergeEnable.getNumOccurrences()) {
+            GVMerge.enable = GVMergeEnable;
+        }
+        if (GVMergeLocality.getNumOccurrences()) {
+            GVMerge.locality = GVMergeLocality;
+        }
+        // 栈布局随机化
+        if (StackLayoutEnable.getNumOccurrences()) {
+            StackLayout.enable = StackLayoutEnable;
+        }
+        if (StackLayoutPadding.getNumOccurrences()) {
+            StackLayout.padding = StackLayoutPadding;
+        }
+        // 函数顺序随机化
+        if (FunctionOrderEnable.getNumOccurrences()) {
+            FunctionOrder.enable = FunctionOrderEnable;
+        }
+        if (FunctionOrderMode.getNumOccurrences()) {
+            FunctionOrder.mode = FunctionOrderMode;
+        }
+        // 基本块顺序随机化
+        if (BlockShuffleEnable.getNumOccurrences()) {
+            BlockShuffle.enable = BlockShuffleEnable;
+        }
+        if (BlockShuffleHot.getNumOccurrences()) {
+            BlockShuffle.hot = BlockShuffleHot;
+        }
+        // 外部 API 隐藏
+        if (ApiHidingEnable.getNumOccurrences()) {
+            ApiHiding.enable = ApiHidingEnable;
+        }
+        if (ApiHidingSymbols.getNumOccurrences()) {
+            ApiHiding.symbols = ApiHidingSymbols;
+        }
+        // switch 常量编码
+        if (SwitchEncodingEnable.getNumOccurrences()) {
+            SwitchEncoding.enable = SwitchEncodingEnable;
+        }
+        if (SwitchEncodingMin.getNumOccurrences()) {
+            SwitchEncoding.min = SwitchEncodingMin;
+        }
+        // 代码完整性校验
+        if (IntegrityCheckEnable.getNumOccurrences()) {
+            IntegrityCheck.enable = IntegrityCheckEnable;
+        }
+        if (IntegrityCheckInterval.getNumOccurrences()) {
+            IntegrityCheck.interval = IntegrityCheckInterval;
+        }
+        if (IntegrityCheckChunk.getNumOccurrences()) {
+            IntegrityCheck.chunk = IntegrityCheckChunk;
+        }
     }
 
     void ObfuscationOptions::checkOptions() const {
@@ -130,10 +469,92 @@ namespace llvm {
         } \
         } while (false)
 
+        if (Budget.func_growth < 0 || Budget.module_growth < 0 || Budget.func_time < 0 || Budget.module_time < 0 ||
+            Budget.text_growth < 0 || Budget.latency_growth < 0) {
+            echo_err("Budget: 预算不能为负数\n");
+            abort();
+        }
+        if (Scope.loop_depth < 0 || Scope.hot < 0) {
+            echo_err("Scope: 阈值不能为负数\n");
+            abort();
+        }
+        if (Tier.none < 0 || Tier.light < Tier.none || Tier.light > 1000000) {
+            echo_err("Tier: 需要满足 0 <= none <= light <= 1000000\n");
+            abort();
+        }
+        if (Tier.prob < 0 || Tier.prob > 100 || Tier.repeat < 1) {
+            echo_err("Tier: prob 只能为 [0, 100]，repeat 至少为 1\n");
+            abort();
+        }
         check_enable(HelloWorld.enable, "HelloWorld");
         check_enable(FuncNameObf.enable, "FunctionNameObf");
         check_enable(GVNameObf.enable, "GlobalVariableNameObf");
         check_enable(FunctionWrapper.enable, "FunctionWrapper");
+        check_enable(StringEncryption.enable, "StringEncryption");
+        if (StringEncryption.mode < 0 || StringEncryption.mode > 2) {
+            echo_err("StringEncryption.mode: 值只能为 0(首次使用时解密) 1(全局构造函数解密) 2(解密到栈上) 之一\n");
+            abort();
+        }
+        check_enable(Substitution.enable, "Substitution");
+        if (Substitution.depth < 1 || Substitution.depth > 4) {
+            echo_err("Substitution.depth: 值只能为 1 到 4\n");
+            abort();
+        }
+        if (Substitution.budget < 0) {
+            echo_err("Substitution.budget: 预算不能为负数\n");
+            abort();
+        }
+        check_enable(Flattening.enable, "Flattening");
+        if (Flattening.hot < 0) {
+            echo_err("Flattening.hot: 阈值不能为负数\n");
+            abort();
+        }
+        if (Flattening.mode < 0 || Flattening.mode > 1) {
+            echo_err("Flattening.mode: 值只能为 0(跳转表分发) 1(稀疏 switch 分发) 之一\n");
+            abort();
+        }
+        check_enable(BogusControlFlow.enable, "BogusControlFlow");
+        if (BogusControlFlow.strength < 0 || BogusControlFlow.strength > 2) {
+            echo_err("BogusControlFlow.strength: 值只能为 0(ALU) 1(全局变量) 2(线程局部状态) 之一\n");
+            abort();
+        }
+        check_enable(IndirectCall.enable, "IndirectCall");
+        check_enable(StructReorder.enable, "StructReorder");
+        check_enable(GVMerge.enable, "GVMerge");
+        check_enable(StackLayout.enable, "StackLayout");
+        if (StackLayout.padding < 0) {
+            echo_err("StackLayout.padding: 填充上限不能为负数\n");
+            abort();
+        }
+        check_enable(FunctionOrder.enable, "FunctionOrder");
+        if (FunctionOrder.mode < 0 || FunctionOrder.mode > 1) {
+            echo_err("FunctionOrder.mode: 值只能为 0(冷热分组内打乱) 1(整体随机打乱) 之一\n");
+            abort();
+        }
+        check_enable(BlockShuffle.enable, "BlockShuffle");
+        if (BlockShuffle.hot < 0 || BlockShuffle.hot > 100) {
+            echo_err("BlockShuffle.hot: 值只能为 0 到 100\n");
+            abort();
+        }
+        check_enable(ApiHiding.enable, "ApiHiding");
+        check_enable(SwitchEncoding.enable, "SwitchEncoding");
+        if (SwitchEncoding.min < 1) {
+            echo_err("SwitchEncoding.min: 值不能小于 1\n");
+            abort();
+        }
+        check_enable(IntegrityCheck.enable, "IntegrityCheck");
+        if (IntegrityCheck.interval < 1 || IntegrityCheck.chunk < 1) {
+            echo_err("IntegrityCheck: interval 与 chunk 不能小于 1\n");
+            abort();
+        }
+        if (IntegrityCheck.enable && !runtime) {
+            echo_err("IntegrityCheck: 后台校验由 buer_rt 实现，需要同时设置 Runtime = 1\n");
+            abort();
+        }
+        if (rt_profile && (!runtime || report.empty())) {
+            echo_err("RuntimeProfile: 计数由 buer_rt 写出并通过报告映射回函数，需要同时设置 Runtime = 1 与 Report\n");
+            abort();
+        }
 #undef echo_err
 #undef check_enable
     }
@@ -170,6 +591,59 @@ namespace llvm {
         }
     }
 
+    void ObfuscationOptions::handleBudget(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "func_growth") {
+                Budget.func_growth = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "module_growth") {
+                Budget.module_growth = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "func_time") {
+                Budget.func_time = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "module_time") {
+                Budget.module_time = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "text_growth") {
+                Budget.text_growth = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "latency_growth") {
+                Budget.latency_growth = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleScope(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "loop_depth") {
+                Scope.loop_depth = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "innermost") {
+                Scope.innermost = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "hot") {
+                Scope.hot = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleTier(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                Tier.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "profile") {
+                Tier.profile = getNodeString(i.getValue()).str();
+            } else if (K == "none") {
+                Tier.none = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "light") {
+                Tier.light = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "prob") {
+                Tier.prob = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "repeat") {
+                Tier.repeat = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "flatten") {
+                Tier.flatten = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
     void ObfuscationOptions::handleHelloWorld(yaml::MappingNode *n) {
         for (auto &i: *n) {
             StringRef K = getNodeString(i.getKey());
@@ -227,13 +701,184 @@ namespace llvm {
         }
     }
 
+    void ObfuscationOptions::handleStringEncryption(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                StringEncryption.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "mode") {
+                StringEncryption.mode = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleSubstitution(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                Substitution.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "prob") {
+                Substitution.prob = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "depth") {
+                Substitution.depth = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "budget") {
+                Substitution.budget = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleFlattening(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                Flattening.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "hot") {
+                Flattening.hot = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "mode") {
+                Flattening.mode = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleBogusControlFlow(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                BogusControlFlow.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "prob") {
+                BogusControlFlow.prob = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "weights") {
+                BogusControlFlow.weights = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "strength") {
+                BogusControlFlow.strength = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleIndirectCall(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                IndirectCall.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "prob") {
+                IndirectCall.prob = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleStructReorder(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                StructReorder.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "locality") {
+                StructReorder.locality = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleGVMerge(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                GVMerge.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "locality") {
+                GVMerge.locality = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleStackLayout(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                StackLayout.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "padding") {
+                StackLayout.padding = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleFunctionOrder(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                FunctionOrder.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "mode") {
+                FunctionOrder.mode = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleBlockShuffle(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                BlockShuffle.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "hot") {
+                BlockShuffle.hot = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleApiHiding(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                ApiHiding.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "symbols") {
+                ApiHiding.symbols = getNodeString(i.getValue()).str();
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleSwitchEncoding(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                SwitchEncoding.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "min") {
+                SwitchEncoding.min = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
+    void ObfuscationOptions::handleIntegrityCheck(yaml::MappingNode *n) {
+        for (auto &i: *n) {
+            StringRef K = getNodeString(i.getKey());
+            if (K == "enable") {
+                IntegrityCheck.enable = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "interval") {
+                IntegrityCheck.interval = static_cast<int>(getIntVal(i.getValue()));
+            } else if (K == "chunk") {
+                IntegrityCheck.chunk = static_cast<int>(getIntVal(i.getValue()));
+            }
+        }
+    }
+
     void ObfuscationOptions::handleRoot(yaml::Node *n) {
         if (!n)
             return;
         if (auto *mn = dyn_cast<yaml::MappingNode>(n)) {
             for (auto &i: *mn) {
                 StringRef K = getNodeString(i.getKey());
-                if (K == "HelloWorld") {
+                if (K == "Report") {
+                    report = getNodeString(i.getValue()).str();
+                } else if (K == "MemProfile") {
+                    mem_profile = static_cast<int>(getIntVal(i.getValue()));
+                } else if (K == "Runtime") {
+                    runtime = static_cast<int>(getIntVal(i.getValue()));
+                } else if (K == "ColdOnly") {
+                    cold_only = static_cast<int>(getIntVal(i.getValue()));
+                } else if (K == "RuntimeProfile") {
+                    rt_profile = static_cast<int>(getIntVal(i.getValue()));
+                } else if (K == "Budget") {
+                    handleBudget(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "Scope") {
+                    handleScope(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "Tier") {
+                    handleTier(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "HelloWorld") {
                     handleHelloWorld(dyn_cast<yaml::MappingNode>(i.getValue()));
                 } else if (K == "FuncNameObf") {
                     handleFuncNameObf(dyn_cast<yaml::MappingNode>(i.getValue()));
@@ -241,6 +886,32 @@ namespace llvm {
                     handleGVNameObf(dyn_cast<yaml::MappingNode>(i.getValue()));
                 } else if (K == "FunctionWrapper") {
                     handleFunctionWrapper(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "StringEncryption") {
+                    handleStringEncryption(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "Substitution") {
+                    handleSubstitution(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "Flattening") {
+                    handleFlattening(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "BogusControlFlow") {
+                    handleBogusControlFlow(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "IndirectCall") {
+                    handleIndirectCall(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "StructReorder") {
+                    handleStructReorder(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "GVMerge") {
+                    handleGVMerge(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "StackLayout") {
+                    handleStackLayout(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "FunctionOrder") {
+                    handleFunctionOrder(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "BlockShuffle") {
+                    handleBlockShuffle(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "ApiHiding") {
+                    handleApiHiding(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "SwitchEncoding") {
+                    handleSwitchEncoding(dyn_cast<yaml::MappingNode>(i.getValue()));
+                } else if (K == "IntegrityCheck") {
+                    handleIntegrityCheck(dyn_cast<yaml::MappingNode>(i.getValue()));
                 }
             }
         }
@@ -265,6 +936,97 @@ namespace llvm {
         return true;
     }
 
+    uint64_t ObfuscationOptions::fingerprint() const {
+        std::stringstream ss;
+        ss << "version=" << obf_version_name << "\n";
+        auto *seed = (unsigned char *) crypto->get_seed();
+        ss << "seed=";
+        if (seed) {
+            for (int i = 0; i < 16; i++) {
+                ss << fmt::format("{:02x}", seed[i]);
+            }
+        }
+        ss << "\n";
+#define hash_config(name, value) ss << name << "=" << (value) << "\n"
+        hash_config("runtime", runtime);
+        hash_config("cold_only", cold_only);
+        hash_config("rt_profile", rt_profile);
+        hash_config("Budget.func_growth", Budget.func_growth);
+        hash_config("Budget.module_growth", Budget.module_growth);
+        hash_config("Budget.func_time", Budget.func_time);
+        hash_config("Budget.module_time", Budget.module_time);
+        hash_config("Budget.text_growth", Budget.text_growth);
+        hash_config("Budget.latency_growth", Budget.latency_growth);
+        hash_config("Scope.loop_depth", Scope.loop_depth);
+        hash_config("Scope.innermost", Scope.innermost);
+        hash_config("Scope.hot", Scope.hot);
+        hash_config("Tier.enable", Tier.enable);
+        hash_config("Tier.none", Tier.none);
+        hash_config("Tier.light", Tier.light);
+        hash_config("Tier.prob", Tier.prob);
+        hash_config("Tier.repeat", Tier.repeat);
+        hash_config("Tier.flatten", Tier.flatten);
+        if (Tier.enable && !Tier.profile.empty()) {
+            // 分档取决于 profile 的内容而不是路径
+            auto Buffer = MemoryBuffer::getFile(Tier.profile);
+            hash_config("Tier.profile", Buffer ? MD5Hash((*Buffer)->getBuffer()) : 0);
+        }
+        hash_config("HelloWorld.enable", HelloWorld.enable);
+        hash_config("FuncNameObf.enable", FuncNameObf.enable);
+        hash_config("FuncNameObf.prefix", FuncNameObf.prefix);
+        hash_config("FuncNameObf.suffix", FuncNameObf.suffix);
+        hash_config("FuncNameObf.charset", FuncNameObf.charset);
+        hash_config("FuncNameObf.length", FuncNameObf.length);
+        hash_config("GVNameObf.enable", GVNameObf.enable);
+        hash_config("GVNameObf.prefix", GVNameObf.prefix);
+        hash_config("GVNameObf.suffix", GVNameObf.suffix);
+        hash_config("GVNameObf.charset", GVNameObf.charset);
+        hash_config("GVNameObf.length", GVNameObf.length);
+        hash_config("FunctionWrapper.enable", FunctionWrapper.enable);
+        hash_config("FunctionWrapper.prob", FunctionWrapper.prob);
+        hash_config("FunctionWrapper.times", FunctionWrapper.times);
+        hash_config("StringEncryption.enable", StringEncryption.enable);
+        hash_config("StringEncryption.mode", StringEncryption.mode);
+        hash_config("Substitution.enable", Substitution.enable);
+        hash_config("Substitution.prob", Substitution.prob);
+        hash_config("Substitution.depth", Substitution.depth);
+        hash_config("Substitution.budget", Substitution.budget);
+        hash_config("Flattening.enable", Flattening.enable);
+        hash_config("Flattening.hot", Flattening.hot);
+        hash_config("Flattening.mode", Flattening.mode);
+        hash_config("BogusControlFlow.enable", BogusControlFlow.enable);
+        hash_config("BogusControlFlow.prob", BogusControlFlow.prob);
+        hash_config("BogusControlFlow.weights", BogusControlFlow.weights);
+        hash_config("BogusControlFlow.strength", BogusControlFlow.strength);
+        hash_config("IndirectCall.enable", IndirectCall.enable);
+        hash_config("IndirectCall.prob", IndirectCall.prob);
+        hash_config("StructReorder.enable", StructReorder.enable);
+        hash_config("StructReorder.locality", StructReorder.locality);
+        hash_config("GVMerge.enable", GVMerge.enable);
+        hash_config("GVMerge.locality", GVMerge.locality);
+        hash_config("StackLayout.enable", StackLayout.enable);
+        hash_config("StackLayout.padding", StackLayout.padding);
+        hash_config("FunctionOrder.enable", FunctionOrder.enable);
+        hash_config("FunctionOrder.mode", FunctionOrder.mode);
+        hash_config("BlockShuffle.enable", BlockShuffle.enable);
+        hash_config("BlockShuffle.hot", BlockShuffle.hot);
+        hash_config("ApiHiding.enable", ApiHiding.enable);
+        hash_config("ApiHiding.symbols", ApiHiding.symbols);
+        hash_config("SwitchEncoding.enable", SwitchEncoding.enable);
+        hash_config("SwitchEncoding.min", SwitchEncoding.min);
+        hash_config("IntegrityCheck.enable", IntegrityCheck.enable);
+        hash_config("IntegrityCheck.interval", IntegrityCheck.interval);
+        hash_config("IntegrityCheck.chunk", IntegrityCheck.chunk);
+#undef hash_config
+        unsigned char digest[32];
+        CryptoUtils::sha256(ss.str().c_str(), digest);
+        uint64_t hash = 0;
+        for (int i = 0; i < 8; i++) {
+            hash = (hash << 8) | digest[i];
+        }
+        return hash;
+    }
+
     void ObfuscationOptions::dump() const {
         auto red = fmt::fg(fmt::color::red);
         auto pink = fmt::fg(fmt::color::pink);
@@ -287,6 +1049,34 @@ namespace llvm {
         echo_pass("ObfuscationOptions");
         echo_pass("Global");
         echo_config("RandomSeed", seed_hex.str());
+        echo_config("Fingerprint", "{:016x}", fingerprint());
+        echo_config("Report", "{}", report);
+        echo_config("MemProfile", "{}", mem_profile);
+        echo_config("Runtime", "{}", runtime);
+        echo_config("ColdOnly", "{}", cold_only);
+        echo_config("RuntimeProfile", "{}", rt_profile);
+
+        echo_pass("Budget");
+        echo_config("FuncGrowth", "{}%", Budget.func_growth);
+        echo_config("ModuleGrowth", "{}%", Budget.module_growth);
+        echo_config("FuncTime", "{}ms", Budget.func_time);
+        echo_config("ModuleTime", "{}ms", Budget.module_time);
+        echo_config("TextGrowth", "{}%", Budget.text_growth);
+        echo_config("LatencyGrowth", "{}%", Budget.latency_growth);
+
+        echo_pass("Scope");
+        echo_config("LoopDepth", "{}", Scope.loop_depth);
+        echo_config("Innermost", "{}", Scope.innermost);
+        echo_config("Hot", "{}", Scope.hot);
+
+        echo_pass("Tier");
+        echo_config("Enable", "{}", Tier.enable);
+        echo_config("Profile", "{}", Tier.profile);
+        echo_config("None", "{}", Tier.none);
+        echo_config("Light", "{}", Tier.light);
+        echo_config("Prob", "{}%", Tier.prob);
+        echo_config("Repeat", "{}", Tier.repeat);
+        echo_config("Flatten", "{}", Tier.flatten);
 
         echo_pass("HelloWorld");
         echo_enable(HelloWorld.enable);
@@ -310,6 +1100,66 @@ namespace llvm {
         echo_config("Prob", "{}", FunctionWrapper.prob);
         echo_config("Times", "{}", FunctionWrapper.times);
 
+        echo_pass("StringEncryption");
+        echo_enable(StringEncryption.enable);
+        echo_config("Mode", "{}", StringEncryption.mode == 0 ? "lazy" :
+                                  StringEncryption.mode == 1 ? "eager" : "stack");
+
+        echo_pass("Substitution");
+        echo_enable(Substitution.enable);
+        echo_config("Prob", "{}", Substitution.prob);
+        echo_config("Depth", "{}", Substitution.depth);
+        echo_config("Budget", "{}%", Substitution.budget);
+
+        echo_pass("Flattening");
+        echo_enable(Flattening.enable);
+        echo_config("Hot", "{}", Flattening.hot);
+        echo_config("Mode", "{}", Flattening.mode == 0 ? "jump table" : "sparse switch");
+
+        echo_pass("BogusControlFlow");
+        echo_enable(BogusControlFlow.enable);
+        echo_config("Prob", "{}", BogusControlFlow.prob);
+        echo_config("Weights", "{}", BogusControlFlow.weights);
+        echo_config("Strength", "{}", BogusControlFlow.strength == 0 ? "alu" :
+                                      BogusControlFlow.strength == 1 ? "global" : "thread local");
+
+        echo_pass("IndirectCall");
+        echo_enable(IndirectCall.enable);
+        echo_config("Prob", "{}", IndirectCall.prob);
+
+        echo_pass("StructReorder");
+        echo_enable(StructReorder.enable);
+        echo_config("Locality", "{}", StructReorder.locality);
+
+        echo_pass("GVMerge");
+        echo_enable(GVMerge.enable);
+        echo_config("Locality", "{}", GVMerge.locality);
+
+        echo_pass("StackLayout");
+        echo_enable(StackLayout.enable);
+        echo_config("Padding", "{}", StackLayout.padding);
+
+        echo_pass("FunctionOrder");
+        echo_enable(FunctionOrder.enable);
+        echo_config("Mode", "{}", FunctionOrder.mode);
+
+        echo_pass("BlockShuffle");
+        echo_enable(BlockShuffle.enable);
+        echo_config("Hot", "{}", BlockShuffle.hot);
+
+        echo_pass("ApiHiding");
+        echo_enable(ApiHiding.enable);
+        echo_config("Symbols", "{}", ApiHiding.symbols);
+
+        echo_pass("SwitchEncoding");
+        echo_enable(SwitchEncoding.enable);
+        echo_config("Min", "{}", SwitchEncoding.min);
+
+        echo_pass("IntegrityCheck");
+        echo_enable(IntegrityCheck.enable);
+        echo_config("Interval", "{}ms", IntegrityCheck.interval);
+        echo_config("Chunk", "{}KB", IntegrityCheck.chunk);
+
 #undef echo_pass
 #undef echo_config
 #undef enable_value
@@ -4,10 +4,29 @@
 
 #include "Plugin.h"
 #include "ObfuscationOptions.h"
+#include "core/ApiHiding.h"
+#include "core/ColdSplit.h"
+#include "core/ProfileTier.h"
+#include "core/ConfigStamp.h"
 #include "core/HelloWorld.h"
 #include "core/FuncNameObf.h"
 #include "core/GVNameObf.h"
 #include "core/FunctionWrapper.h"
+#include "core/FunctionOrder.h"
+#include "core/OverheadPlanner.h"
+#include "core/ReportWriter.h"
+#include "core/StackLayout.h"
+#include "core/StringEncryption.h"
+#include "core/StructReorder.h"
+#include "core/Substitution.h"
+#include "core/Flattening.h"
+#include "core/BogusControlFlow.h"
+#include "core/BlockShuffle.h"
+#include "core/SwitchEncoding.h"
+#include "core/GVMerge.h"
+#include "core/IndirectCall.h"
+#include "core/IntegrityCheck.h"
+#include "core/RuntimeProfile.h"
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
@@ -47,13 +66,32 @@ void obfuscatePluginCallback(llvm::ModulePassManager &PM,
     if (Options->verbose){
         Options->dump();
     }
+    PM.addPass(ConfigStamp(Options));
+    PM.addPass(ColdSplit(Options));
+    PM.addPass(ProfileTier(Options));
+    PM.addPass(OverheadPlanner(Options));
     FunctionPassManager FPM;
     FPM.addPass(HelloWorld(Options->HelloWorld.enable));
     PM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
     PM.addPass(HelloWorld(Options->HelloWorld.enable));
+    PM.addPass(StructReorder(Options));
+    PM.addPass(StringEncryption(Options));
+    PM.addPass(Substitution(Options));
+    PM.addPass(SwitchEncoding(Options));
+    PM.addPass(Flattening(Options));
+    PM.addPass(BogusControlFlow(Options));
+    PM.addPass(BlockShuffle(Options));
+    PM.addPass(GVMerge(Options));
+    PM.addPass(StackLayout(Options));
     PM.addPass(FuncNameObf(Options));
     PM.addPass(GVNameObf(Options));
+    PM.addPass(ApiHiding(Options));
     PM.addPass(FunctionWrapper(Options));
+    PM.addPass(IndirectCall(Options));
+    PM.addPass(IntegrityCheck(Options));
+    PM.addPass(RuntimeProfile(Options));
+    PM.addPass(FunctionOrder(Options));
+    PM.addPass(ReportWriter(Options));
 }
 
 /* New PM Registration for static plugin */
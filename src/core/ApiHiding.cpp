@@ -0,0 +1,335 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/ApiHiding.h"
+#include "core/FunctionWrapper.h"
+#include "core/StringEncryption.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <map>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+const uint64_t ApiHiding::WrapperCost;
+
+bool ApiHiding::isCandidate(CallBase &CB, const TargetLibraryInfo &TLI, StringRef Symbols) {
+    Function *Callee = CB.getCalledFunction();
+    if (!Callee || !Callee->isDeclaration() || Callee->isIntrinsic() || CB.isInlineAsm() || CB.isMustTailCall() ||
+        CB.hasOperandBundles() || CB.getFunctionType() != Callee->getFunctionType()) {
+        return false;
+    }
+    // setjmp / vfork 一类函数返回两次，第二次返回时包装函数的栈帧已经不存在，必须直接调用；
+    // 声明上不一定带 returns_twice，按名字再检查一次
+    static const StringRef ReturnsTwice[] = {"setjmp", "_setjmp", "__sigsetjmp", "sigsetjmp", "savectx", "vfork",
+                                             "getcontext"};
+    if (CB.hasFnAttr(Attribute::ReturnsTwice) || is_contained(ReturnsTwice, Callee->getName())) {
+        return false;
+    }
+    // dlsym 只能找到默认可见性的全局符号；弱符号可能不存在；dlsym 本身用于解析
+    StringRef Name = Callee->getName();
+    if (!Callee->hasDefaultVisibility() || Callee->hasExternalWeakLinkage() || Callee->hasDLLImportStorageClass() ||
+        Name.startswith("clang.") || Name == "dlsym") {
+        return false;
+    }
+    if (Symbols.empty()) {
+        LibFunc LF;
+        return !TLI.getLibFunc(*Callee, LF);
+    }
+    SmallVector<StringRef, 8> Patterns;
+    Symbols.split(Patterns, ',', -1, false);
+    for (StringRef P: Patterns) {
+        P = P.trim();
+        if (P.endswith("*") ? Name.startswith(P.drop_back()) : Name == P) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// dlsym 的 RTLD_DEFAULT 句柄：Darwin 为 -2，32 位 Android 为 0xffffffff，其余为 0
+static Constant *getDefaultHandle(Module &M, IntegerType *IntPtrTy) {
+    Triple T(M.getTargetTriple());
+    uint64_t Handle = 0;
+    if (T.isOSDarwin()) {
+        Handle = (uint64_t) -2;
+    } else if (T.isAndroid() && !T.isArch64Bit()) {
+        Handle = 0xffffffff;
+    }
+    return ConstantExpr::getIntToPtr(ConstantInt::get(IntPtrTy, Handle), Type::getInt8PtrTy(M.getContext()));
+}
+
+// void ()：用 guard 保证只解析一次，函数名解密到栈上，逐项 dlsym 后把 地址 + Key 写入指针表，最后清空栈上的明文
+// guard: 0 未解析，1 正在解析，2 已解析；Runtime 为 true 时只转发给 buer_rt 中的 __buer_rt_v1_resolve
+// dlsym 找不到时把函数名写到 stderr 后 abort，不会在之后跳到 Key 所在的地址；Offsets 末尾多一项名字的总长度
+static Function *createResolver(Module &M, GlobalVariable *Guard, GlobalVariable *Table, GlobalVariable *Names,
+                                GlobalVariable *NameKey, uint8_t Delta, GlobalVariable *Offsets, uint64_t Key,
+                                bool Runtime) {
+    LLVMContext &Ctx = M.getContext();
+    Type *I8Ty = Type::getInt8Ty(Ctx);
+    Type *I8PtrTy = Type::getInt8PtrTy(Ctx);
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    Type *I64Ty = Type::getInt64Ty(Ctx);
+    IntegerType *IntPtrTy = M.getDataLayout().getIntPtrType(Ctx);
+    auto *NamesTy = cast<ArrayType>(Names->getValueType());
+    auto *TableTy = cast<ArrayType>(Table->getValueType());
+    uint64_t Len = NamesTy->getNumElements();
+
+    Function *F = Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false), GlobalValue::PrivateLinkage,
+                                   "buer.api.resolve", M);
+    F->addFnAttr(Attribute::NoUnwind);
+    F->addFnAttr(Attribute::NoInline);
+    F->addFnAttr(Attribute::Cold);
+    if (Runtime) {
+        FunctionType *FTy = FunctionType::get(Type::getVoidTy(Ctx),
+                                              {I32Ty->getPointerTo(), I8PtrTy->getPointerTo(), I32Ty, I8PtrTy,
+                                               I64Ty, I8PtrTy, I8Ty, I32Ty->getPointerTo(), IntPtrTy}, false);
+        IRBuilder<> IRB(BasicBlock::Create(Ctx, "entry", F));
+        IRB.CreateCall(getRuntimeFunction(M, "__buer_rt_v1_resolve", FTy),
+                       {Guard, IRB.CreateBitCast(Table, I8PtrTy->getPointerTo()),
+                        ConstantInt::get(I32Ty, TableTy->getNumElements()), IRB.CreateBitCast(Names, I8PtrTy),
+                        ConstantInt::get(I64Ty, Len), IRB.CreateBitCast(NameKey, I8PtrTy),
+                        ConstantInt::get(I8Ty, Delta), IRB.CreateBitCast(Offsets, I32Ty->getPointerTo()),
+                        ConstantInt::get(IntPtrTy, Key)});
+        IRB.CreateRetVoid();
+        return F;
+    }
+    FunctionCallee Dlsym = M.getOrInsertFunction("dlsym", FunctionType::get(I8PtrTy, {I8PtrTy, I8PtrTy}, false));
+    BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", F);
+    BasicBlock *Resolve = BasicBlock::Create(Ctx, "resolve", F);
+    BasicBlock *Loop = BasicBlock::Create(Ctx, "loop", F);
+    BasicBlock *Store = BasicBlock::Create(Ctx, "store", F);
+    BasicBlock *Missing = BasicBlock::Create(Ctx, "missing", F);
+    BasicBlock *Done = BasicBlock::Create(Ctx, "done", F);
+    BasicBlock *Wait = BasicBlock::Create(Ctx, "wait", F);
+    BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", F);
+
+    IRBuilder<> IRB(Entry);
+    AllocaInst *Buffer = IRB.CreateAlloca(NamesTy, nullptr, "api.names");
+    Value *Pair = IRB.CreateAtomicCmpXchg(Guard, ConstantInt::get(I32Ty, 0), ConstantInt::get(I32Ty, 1),
+                                          MaybeAlign(4), AtomicOrdering::AcquireRelease,
+                                          AtomicOrdering::Acquire);
+    IRB.CreateCondBr(IRB.CreateExtractValue(Pair, 1), Resolve, Wait);
+
+    IRB.SetInsertPoint(Resolve);
+    Value *Plain = IRB.CreateBitCast(Buffer, I8PtrTy);
+    IRB.CreateCall(StringEncryption::getDecryptFunction(M),
+                   {Plain, IRB.CreateBitCast(Names, I8PtrTy), ConstantInt::get(I64Ty, Len),
+                    IRB.CreateBitCast(NameKey, I8PtrTy), ConstantInt::get(I8Ty, Delta)});
+    IRB.CreateBr(Loop);
+
+    IRB.SetInsertPoint(Loop);
+    PHINode *I = IRB.CreatePHI(I32Ty, 2);
+    Value *Off = IRB.CreateLoad(I32Ty, IRB.CreateInBoundsGEP(Offsets->getValueType(), Offsets,
+                                                            {ConstantInt::get(I32Ty, 0), I}));
+    Value *Name = IRB.CreateInBoundsGEP(I8Ty, Plain, Off);
+    Value *Sym = IRB.CreateCall(Dlsym, {getDefaultHandle(M, IntPtrTy), Name});
+    IRB.CreateCondBr(IRB.CreateIsNull(Sym), Missing, Store,
+                     MDBuilder(Ctx).createBranchWeights(1, (1U << 20) - 1));
+
+    IRB.SetInsertPoint(Store);
+    Value *Encoded = IRB.CreateGEP(I8Ty, Sym, ConstantInt::get(IntPtrTy, Key));
+    IRB.CreateStore(Encoded, IRB.CreateInBoundsGEP(TableTy, Table, {ConstantInt::get(I32Ty, 0), I}));
+    Value *Next = IRB.CreateAdd(I, ConstantInt::get(I32Ty, 1));
+    IRB.CreateCondBr(IRB.CreateICmpULT(Next, ConstantInt::get(I32Ty, TableTy->getNumElements())), Loop, Done);
+    I->addIncoming(ConstantInt::get(I32Ty, 0), Resolve);
+    I->addIncoming(Next, Store);
+
+    // 名字结尾的 \0 换成换行，write(2, 名字) 后 abort
+    IRB.SetInsertPoint(Missing);
+    Value *End = IRB.CreateLoad(I32Ty, IRB.CreateInBoundsGEP(Offsets->getValueType(), Offsets,
+                                                            {ConstantInt::get(I32Ty, 0),
+                                                             IRB.CreateAdd(I, ConstantInt::get(I32Ty, 1))}));
+    IRB.CreateStore(ConstantInt::get(I8Ty, '\n'),
+                    IRB.CreateInBoundsGEP(I8Ty, Plain, IRB.CreateSub(End, ConstantInt::get(I32Ty, 1))));
+    FunctionCallee Write = M.getOrInsertFunction("write", FunctionType::get(IntPtrTy, {I32Ty, I8PtrTy, IntPtrTy},
+                                                                            false));
+    IRB.CreateCall(Write, {ConstantInt::get(I32Ty, 2), Name, IRB.CreateZExt(IRB.CreateSub(End, Off), IntPtrTy)});
+    FunctionCallee Abort = M.getOrInsertFunction("abort", FunctionType::get(Type::getVoidTy(Ctx), false));
+    cast<CallInst>(IRB.CreateCall(Abort))->setDoesNotReturn();
+    IRB.CreateUnreachable();
+
+    IRB.SetInsertPoint(Done);
+    IRB.CreateMemSet(Plain, ConstantInt::get(I8Ty, 0), Len, MaybeAlign(1), true);
+    IRB.CreateAlignedStore(ConstantInt::get(I32Ty, 2), Guard, Align(4))->setAtomic(AtomicOrdering::Release);
+    IRB.CreateRetVoid();
+
+    // 其他线程正在解析，等待完成
+    IRB.SetInsertPoint(Wait);
+    LoadInst *State = IRB.CreateAlignedLoad(I32Ty, Guard, Align(4));
+    State->setAtomic(AtomicOrdering::Acquire);
+    IRB.CreateCondBr(IRB.CreateICmpEQ(State, ConstantInt::get(I32Ty, 2)), Exit, Wait);
+
+    IRB.SetInsertPoint(Exit);
+    IRB.CreateRetVoid();
+    return F;
+}
+
+PreservedAnalyses ApiHiding::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassApiHiding &config = Options->ApiHiding;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "ApiHiding", M);
+    BudgetTracker budget(Options, "ApiHiding", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    LLVMContext &Ctx = M.getContext();
+    Type *I8PtrTy = Type::getInt8PtrTy(Ctx);
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    IntegerType *IntPtrTy = M.getDataLayout().getIntPtrType(Ctx);
+
+    // 每个被调函数与实参类型的组合生成一个包装函数，包装函数的指令计入第一个调用它的函数
+    typedef std::pair<Function *, FunctionType *> WrapperKey;
+    std::map<WrapperKey, CallBase *> Wrappers;
+    vector<std::pair<WrapperKey, CallBase *>> Sites;
+    std::map<Function *, unsigned> Index;
+    vector<Function *> Callees;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "api", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "ApiHiding: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        auto &TLI = FAM.getResult<TargetLibraryAnalysis>(F);
+        size_t skipped = 0;
+        for (auto &BB: F) {
+            for (auto &I: BB) {
+                auto *CB = dyn_cast<CallBase>(&I);
+                if (!CB || !isCandidate(*CB, TLI, config.symbols) || !scope.instruction(*CB)) {
+                    continue;
+                }
+                vector<Type *> Params;
+                for (Value *Arg: CB->args()) {
+                    Params.push_back(Arg->getType());
+                }
+                WrapperKey Key{CB->getCalledFunction(), FunctionType::get(CB->getType(), Params, false)};
+                if (!Wrappers.count(Key)) {
+                    if (budget.remaining(F) < WrapperCost) {
+                        skipped++;
+                        continue;
+                    }
+                    budget.charge(F, WrapperCost);
+                    Wrappers[Key] = CB;
+                }
+                if (Index.emplace(Key.first, 0).second) {
+                    Callees.push_back(Key.first);
+                }
+                Sites.emplace_back(Key, CB);
+            }
+        }
+        if (skipped) {
+            budget.degrade(F, fmt::format("growth budget exceeded, {} calls left direct", skipped));
+        }
+    }
+    if (Callees.empty()) {
+        return PreservedAnalyses::all();
+    }
+
+    // 表项顺序随机，函数名以 \0 分隔后整体加密
+    for (size_t i = Callees.size(); i > 1; i--) {
+        std::swap(Callees[i - 1], Callees[crypto->get_range(i)]);
+    }
+    std::vector<uint8_t> Plain;
+    vector<uint32_t> Offsets;
+    for (unsigned i = 0; i < Callees.size(); i++) {
+        Index[Callees[i]] = i;
+        Offsets.push_back((uint32_t) Plain.size());
+        StringRef Name = Callees[i]->getName();
+        Plain.insert(Plain.end(), Name.bytes_begin(), Name.bytes_end());
+        Plain.push_back(0);
+    }
+    Offsets.push_back((uint32_t) Plain.size());
+    uint8_t NameKey[16];
+    crypto->get_bytes((char *) NameKey, 16);
+    uint8_t Delta = crypto->get_uint8_t() | 1;
+    StringEncryption::encrypt(Plain, NameKey, Delta);
+
+    auto *NamesGV = new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(Ctx), Plain.size()), true,
+                                       GlobalValue::PrivateLinkage,
+                                       ConstantDataArray::get(Ctx, makeArrayRef(Plain)), "buer.api.names");
+    auto *NameKeyGV = new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(Ctx), 16), true,
+                                         GlobalValue::PrivateLinkage,
+                                         ConstantDataArray::get(Ctx, makeArrayRef(NameKey, 16)), "buer.api.key");
+    auto *OffsetsGV = new GlobalVariable(M, ArrayType::get(I32Ty, Offsets.size()), true,
+                                         GlobalValue::PrivateLinkage,
+                                         ConstantDataArray::get(Ctx, makeArrayRef(Offsets)), "buer.api.offsets");
+    ArrayType *TableTy = ArrayType::get(I8PtrTy, Callees.size());
+    auto *Table = new GlobalVariable(M, TableTy, false, GlobalValue::InternalLinkage,
+                                     ConstantAggregateZero::get(TableTy), "buer.api.table");
+    Table->setAlignment(Align(64));
+    auto *Guard = new GlobalVariable(M, I32Ty, false, GlobalValue::PrivateLinkage,
+                                     ConstantInt::get(I32Ty, 0), "buer.api.guard");
+    Guard->setAlignment(Align(4));
+    uint64_t Key = crypto->get_uint32_t() | 0x10;
+    Function *Resolve = createResolver(M, Guard, Table, NamesGV, NameKeyGV, Delta, OffsetsGV, Key,
+                                       Options->runtime);
+
+    // 包装函数沿用 FunctionWrapper 生成的转发函数，把其中的直接调用改为 检查 guard + 读表 + 解码后的间接调用；
+    // 它是解析后的跳板，需要正常优化，也不能再带被调函数的内存属性（第一次调用会写指针表）。
+    // ApiHiding 在 FuncNameObf 之后运行，包装函数不能叫 Wra_<API 名>，否则加密过的名字又以符号名出现
+    MDNode *Unlikely = MDBuilder(Ctx).createBranchWeights(1, (1U << 20) - 1);
+    std::map<WrapperKey, Function *> Created;
+    for (auto &It: Wrappers) {
+        Function *W = FunctionWrapper::CreateWrapper(It.second, "buer.api.stub");
+        for (Attribute::AttrKind Kind: {Attribute::OptimizeNone, Attribute::ReadNone, Attribute::ReadOnly,
+                                        Attribute::WriteOnly, Attribute::ArgMemOnly, Attribute::Speculatable,
+                                        Attribute::InaccessibleMemOnly, Attribute::InaccessibleMemOrArgMemOnly}) {
+            W->removeFnAttr(Kind);
+        }
+        auto *Inner = cast<CallInst>(&W->getEntryBlock().front());
+        IRBuilder<> IRB(Inner);
+        LoadInst *State = IRB.CreateAlignedLoad(I32Ty, Guard, Align(4));
+        State->setAtomic(AtomicOrdering::Acquire);
+        Value *Pending = IRB.CreateICmpNE(State, ConstantInt::get(I32Ty, 2));
+        Instruction *Then = SplitBlockAndInsertIfThen(Pending, Inner, false, Unlikely);
+        IRB.SetInsertPoint(Then);
+        IRB.CreateCall(Resolve);
+        IRB.SetInsertPoint(Inner);
+        Function *Callee = It.first.first;
+        Value *Slot = IRB.CreateConstInBoundsGEP2_64(TableTy, Table, 0, Index[Callee]);
+        Value *Encoded = IRB.CreateLoad(I8PtrTy, Slot, "api.enc");
+        Value *Decoded = IRB.CreateIntToPtr(IRB.CreateSub(IRB.CreatePtrToInt(Encoded, IntPtrTy),
+                                                          ConstantInt::get(IntPtrTy, Key)),
+                                            Callee->getType(), "api.ptr");
+        Inner->setCalledOperand(Decoded);
+        Created[It.first] = W;
+        report->addGenerated("ApiHiding", W, nullptr);
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "ApiHiding: {} -> {}\n", Callee->getName().str(), W->getName().str());
+        }
+    }
+    for (auto &Site: Sites) {
+        FunctionWrapper::Redirect(Site.second, Created[Site.first]);
+    }
+    // 没有其他引用的声明直接删除，目标文件中不再出现对应的未定义符号
+    for (Function *Callee: Callees) {
+        if (Callee->use_empty()) {
+            Callee->eraseFromParent();
+        }
+    }
+    report->addGenerated("ApiHiding", Resolve, nullptr);
+    report->addNote("ApiHiding", M.getName(),
+                    fmt::format("{} functions resolved in one batch through buer.api.table ({} cache lines), "
+                                "{} wrappers, {} call sites, names {} bytes",
+                                Callees.size(), (Callees.size() * M.getDataLayout().getPointerSize() + 63) / 64,
+                                Created.size(), Sites.size(), Plain.size()));
+    return PreservedAnalyses::none();
+}
@@ -0,0 +1,123 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/BlockShuffle.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/BranchProbabilityInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+typedef vector<BasicBlock *> Chain;
+
+PreservedAnalyses BlockShuffle::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassBlockShuffle &config = Options->BlockShuffle;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "BlockShuffle", M);
+    BudgetTracker budget(Options, "BlockShuffle", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    BranchProbability Threshold(config.hot, 100);
+    bool changed = false;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "bs", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "BlockShuffle: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (F.size() < 3) {
+            continue;
+        }
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+        auto &BPI = FAM.getResult<BranchProbabilityAnalysis>(F);
+        auto &LI = FAM.getResult<LoopAnalysis>(F);
+
+        // 从每个还未归属的块开始，沿概率最大的出边延伸链：边的概率和该边占后继执行次数的比例都要达到阈值，
+        // 后继是循环头部时另起一条链，保证头部位于链首，代码生成仍按循环头部对齐
+        vector<Chain> Chains;
+        std::set<BasicBlock *> Placed;
+        for (auto &BB: F) {
+            if (Placed.count(&BB)) {
+                continue;
+            }
+            Chain C{&BB};
+            Placed.insert(&BB);
+            for (BasicBlock *Cur = &BB;;) {
+                BasicBlock *Next = nullptr;
+                BranchProbability Best = Threshold;
+                for (BasicBlock *Succ: successors(Cur)) {
+                    BranchProbability P = BPI.getEdgeProbability(Cur, Succ);
+                    if (P < Best || Placed.count(Succ) || LI.isLoopHeader(Succ) || &F.getEntryBlock() == Succ) {
+                        continue;
+                    }
+                    uint64_t edge = (BFI.getBlockFreq(Cur) * P).getFrequency();
+                    if (edge < (BFI.getBlockFreq(Succ) * Threshold).getFrequency()) {
+                        continue; // 后继主要从其他前驱进入
+                    }
+                    Next = Succ;
+                    Best = P;
+                }
+                if (!Next) {
+                    break;
+                }
+                C.push_back(Next);
+                Placed.insert(Next);
+                Cur = Next;
+            }
+            // 不在混淆范围内的块随前一个单元一起移动，保持原来的相对顺序
+            if (!Chains.empty() && !scope.block(BB)) {
+                Chains.back().insert(Chains.back().end(), C.begin(), C.end());
+            } else {
+                Chains.push_back(std::move(C));
+            }
+        }
+        if (Chains.size() < 3) {
+            continue;
+        }
+
+        // 入口链不动，其余的链整体打乱
+        for (size_t i = Chains.size() - 1; i > 1; i--) {
+            std::swap(Chains[i], Chains[1 + crypto->get_range(i)]);
+        }
+        BasicBlock *Prev = nullptr;
+        size_t pinned = 0;
+        for (Chain &C: Chains) {
+            for (BasicBlock *BB: C) {
+                if (Prev) {
+                    BB->moveAfter(Prev);
+                }
+                Prev = BB;
+            }
+            pinned += C.size() > 1 ? C.size() : 0;
+        }
+        changed = true;
+
+        report->addNote("BlockShuffle", F.getName(),
+                        fmt::format("{} blocks, {} units permuted, {} blocks pinned in fall-through chains",
+                                    F.size(), Chains.size() - 1, pinned));
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "BlockShuffle: {} ({} units, {} pinned blocks)\n",
+                                  F.getName().str(), Chains.size() - 1, pinned);
+        }
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
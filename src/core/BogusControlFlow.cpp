@@ -0,0 +1,177 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/BogusControlFlow.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/OpaquePredicate.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+const uint64_t BogusControlFlow::BlockCost;
+
+// 真实分支的权重，假分支权重为 0
+static const uint32_t TakenWeight = 1 << 20;
+
+// 虚假块调用的垃圾函数：对参数做随机运算后 volatile 写入 sink，不会被当作无副作用调用删除
+static Function *createJunkFunction(Module &M, Function &F, bool Cold) {
+    LLVMContext &Ctx = M.getContext();
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    GlobalVariable *Sink = M.getGlobalVariable("buer.bcf.sink", true);
+    if (!Sink) {
+        Sink = new GlobalVariable(M, I32Ty, false, GlobalValue::PrivateLinkage,
+                                  ConstantInt::get(I32Ty, 0), "buer.bcf.sink");
+    }
+    FunctionType *FT = FunctionType::get(I32Ty, {I32Ty}, false);
+    Function *Junk = Function::Create(FT, GlobalValue::InternalLinkage, "Bcf_" + F.getName(), M);
+    Junk->setDSOLocal(true);
+    Junk->addFnAttr(Attribute::NoInline);
+    Junk->addFnAttr(Attribute::OptimizeForSize);
+    if (Cold) {
+        Junk->addFnAttr(Attribute::Cold);
+        Junk->setSectionPrefix("unlikely");
+    }
+    IRBuilder<> IRB(BasicBlock::Create(Ctx, "entry", Junk));
+    Value *V = Junk->getArg(0);
+    for (uint32_t i = 0, n = 4 + crypto->get_range(5); i < n; i++) {
+        Constant *K = IRB.getInt32(crypto->get_uint32_t());
+        switch (crypto->get_range(4)) {
+            case 0:
+                V = IRB.CreateAdd(V, K);
+                break;
+            case 1:
+                V = IRB.CreateXor(V, K);
+                break;
+            case 2:
+                V = IRB.CreateMul(V, IRB.getInt32(crypto->get_uint32_t() | 1));
+                break;
+            default: {
+                // 循环左移，两个移位量之和为 32，都不会超出位宽而成为 poison
+                uint32_t s = 1 + crypto->get_range(31);
+                V = IRB.CreateOr(IRB.CreateShl(V, s), IRB.CreateLShr(V, 32 - s));
+                break;
+            }
+        }
+    }
+    IRB.CreateStore(V, Sink, true);
+    IRB.CreateRet(V);
+    return Junk;
+}
+
+PreservedAnalyses BogusControlFlow::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassBogusControlFlow &config = Options->BogusControlFlow;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "BogusControlFlow", M);
+    BudgetTracker budget(Options, "BogusControlFlow", M);
+    LLVMContext &Ctx = M.getContext();
+    MDBuilder MDB(Ctx);
+    OpaquePredicateFactory Predicates(M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    bool changed = false;
+    // 混淆过程中会新增垃圾函数，先收集需要处理的函数
+    vector<std::pair<Function *, Eligibility>> Functions;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "bcf", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "BogusControlFlow: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        Functions.emplace_back(&F, scope);
+    }
+    for (auto &Target: Functions) {
+        Function *F = Target.first;
+        Eligibility &scope = Target.second;
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(*F, "module time budget exceeded, skipped");
+            continue;
+        }
+        budget.startFunction();
+        int prob = scope.prob(config.prob);
+        vector<BasicBlock *> Blocks;
+        for (auto &BB: *F) {
+            if (BB.isEHPad() || !scope.block(BB)) {
+                continue;
+            }
+            if (prob == 100 || crypto->get_range(100) < (unsigned int) prob) {
+                Blocks.push_back(&BB);
+            }
+        }
+        if (Blocks.empty()) {
+            continue;
+        }
+        uint64_t allowed = budget.remaining(*F);
+        if (Blocks.size() * BlockCost > allowed) {
+            size_t keep = allowed / BlockCost;
+            for (size_t i = Blocks.size() - 1; i > 0; i--) {
+                std::swap(Blocks[i], Blocks[crypto->get_range(i + 1)]);
+            }
+            budget.degrade(*F, fmt::format("growth budget exceeded, prob {} -> {}", prob,
+                                           prob * keep / Blocks.size()));
+            Blocks.resize(keep);
+            if (Blocks.empty()) {
+                continue;
+            }
+        }
+
+        unsigned before = F->getInstructionCount();
+        Function *Junk = createJunkFunction(M, *F, config.weights);
+        OpaqueTier Tier = OpaquePredicateFactory::choose(*F, (OpaqueTier) config.strength);
+        size_t done = 0;
+        for (BasicBlock *Head: Blocks) {
+            if (budget.functionTimeExceeded()) {
+                budget.degrade(*F, fmt::format("function time budget exceeded, {} of {} blocks", done,
+                                               Blocks.size()));
+                break;
+            }
+            // PHI、landingpad 和入口块的 alloca 留在原块，其余部分作为真实路径
+            auto SplitAt = Head->getFirstInsertionPt();
+            if (Head->isEntryBlock()) {
+                while (isa<AllocaInst>(*SplitAt)) {
+                    ++SplitAt;
+                }
+            }
+            BasicBlock *Body = Head->splitBasicBlock(SplitAt, Head->getName() + ".bcf");
+            BasicBlock *Fake = BasicBlock::Create(Ctx, "bcf.fake", F);
+
+            Instruction *T = Head->getTerminator();
+            IRBuilder<> IRB(T);
+            Value *X;
+            bool Truth = crypto->get_range(2);
+            Value *Cond = Predicates.create(IRB, Tier, Truth, X);
+            BranchInst *Br = Truth ? IRB.CreateCondBr(Cond, Body, Fake) : IRB.CreateCondBr(Cond, Fake, Body);
+            if (config.weights) {
+                Br->setMetadata(LLVMContext::MD_prof, Truth ? MDB.createBranchWeights(TakenWeight, 0)
+                                                            : MDB.createBranchWeights(0, TakenWeight));
+            }
+            T->eraseFromParent();
+
+            IRBuilder<> FB(Fake);
+            FB.CreateCall(Junk, {X});
+            FB.CreateBr(Body);
+            done++;
+        }
+        changed = true;
+        unsigned after = F->getInstructionCount();
+        budget.charge(*F, after > before ? after - before : 0);
+        report->addGenerated("BogusControlFlow", Junk, F);
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "BogusControlFlow: {} ({} blocks)\n", F->getName().str(), done);
+        }
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
@@ -0,0 +1,78 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/ColdSplit.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Transforms/IPO/HotColdSplitting.h>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+PreservedAnalyses ColdSplit::run(Module &M, ModuleAnalysisManager &MAM) const {
+    if (!Options->cold_only) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "ColdSplit", M);
+    std::set<Function *> Existing;
+    for (auto &F: M) {
+        Existing.insert(&F);
+    }
+    // optnone 与 noinline 的函数（包括 -O0 下的所有函数）不会被拆分
+    PreservedAnalyses PA = HotColdSplittingPass().run(M, MAM);
+
+    // 拆分出的函数命名为 <原函数名>.cold.N；原本就是冷函数（cold 属性或 profile 判定）的整体归入冷代码
+    auto &PSI = MAM.getResult<ProfileSummaryAnalysis>(M);
+    std::map<Function *, vector<Function *>> Outlined;
+    vector<Function *> Hot;
+    for (auto &F: M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        if (Existing.count(&F)) {
+            if (F.hasFnAttribute(Attribute::Cold) || PSI.isFunctionEntryCold(&F)) {
+                Outlined[nullptr].push_back(&F);
+            } else {
+                Hot.push_back(&F);
+            }
+            continue;
+        }
+        size_t pos = F.getName().rfind(".cold.");
+        Function *Parent = pos == StringRef::npos ? nullptr : M.getFunction(F.getName().substr(0, pos));
+        Outlined[Parent].push_back(&F);
+    }
+    size_t count = 0;
+    for (auto &Entry: Outlined) {
+        for (Function *F: Entry.second) {
+            // 拆分出的函数沿用原函数的注解（包括 __attribute__((annotate))），显式的 no-<pass> 与 <pass> 优先
+            if (Entry.first) {
+                inheritAnnotate(*F, Entry.first);
+            }
+            addPassAnnotates(*F, true);
+            if (Entry.first) {
+                report->addGenerated("ColdSplit", F, Entry.first);
+            }
+            IF_VERBOSE {
+                outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                      "ColdSplit: {} ({} instructions)\n", F->getName().str(),
+                                      F->getInstructionCount());
+            }
+        }
+        count += Entry.second.size();
+    }
+    // 原函数最后再标注，避免 no-<pass> 被拆分出的函数继承
+    for (Function *F: Hot) {
+        addPassAnnotates(*F, false);
+    }
+    report->addNote("ColdSplit", M.getName(),
+                    fmt::format("{} cold functions, {} functions kept native", count, Hot.size()));
+    // 注解是函数属性，不影响分析结果
+    return PA;
+}
@@ -0,0 +1,35 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/ConfigStamp.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Metadata.h>
+
+using namespace llvm;
+
+PreservedAnalyses ConfigStamp::run(Module &M, ModuleAnalysisManager &) const {
+    if (!Options->HelloWorld.enable && !Options->FuncNameObf.enable &&
+        !Options->GVNameObf.enable && !Options->FunctionWrapper.enable &&
+        !Options->StringEncryption.enable && !Options->Substitution.enable &&
+        !Options->Flattening.enable && !Options->BogusControlFlow.enable &&
+        !Options->IndirectCall.enable && !Options->StructReorder.enable &&
+        !Options->GVMerge.enable && !Options->StackLayout.enable &&
+        !Options->FunctionOrder.enable && !Options->BlockShuffle.enable &&
+        !Options->ApiHiding.enable && !Options->SwitchEncoding.enable &&
+        !Options->IntegrityCheck.enable && !Options->Tier.enable &&
+        !Options->cold_only && !Options->rt_profile) {
+        return PreservedAnalyses::all(); // 未开启混淆时产物不变，不影响缓存
+    }
+    // Max: ThinLTO 导入时合并不同 TU 的 flag 不会报错；setModuleFlag 在已经盖过章的 bitcode 上覆盖原值，flag 名必须唯一
+    uint64_t fingerprint = Options->fingerprint();
+    M.setModuleFlag(Module::Max, "buer.obf.config",
+                    ConstantAsMetadata::get(ConstantInt::get(Type::getInt64Ty(M.getContext()), fingerprint)));
+    IF_VERBOSE {
+        outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                              "ConfigStamp: {} => {:016x}\n", M.getName().str(), fingerprint);
+    }
+    return PreservedAnalyses::all();
+}
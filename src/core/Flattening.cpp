@@ -0,0 +1,242 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/Flattening.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/IRBuilder.h>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+static void collectHotLoops(Loop *L, BlockFrequencyInfo &BFI, double Entry, int Hot,
+                            SmallPtrSetImpl<BasicBlock *> &Result) {
+    double freq = (double) BFI.getBlockFreq(L->getHeader()).getFrequency() / Entry;
+    if (freq >= Hot) {
+        Result.insert(L->block_begin(), L->block_end());
+        return;
+    }
+    for (Loop *Sub: *L) {
+        collectHotLoops(Sub, BFI, Entry, Hot, Result);
+    }
+}
+
+SmallPtrSet<BasicBlock *, 16> Flattening::hotLoopBlocks(LoopInfo &LI, BlockFrequencyInfo &BFI, int Hot) {
+    SmallPtrSet<BasicBlock *, 16> Result;
+    if (!Hot) {
+        return Result;
+    }
+    double entry = (double) BFI.getEntryFreq();
+    for (Loop *L: LI) {
+        collectHotLoops(L, BFI, entry, Hot, Result);
+    }
+    return Result;
+}
+
+bool Flattening::isSupported(Function &F) {
+    for (auto &BB: F) {
+        if (BB.isEHPad() || BB.hasAddressTaken()) {
+            return false;
+        }
+        Instruction *T = BB.getTerminator();
+        if (isa<InvokeInst>(T) || isa<CallBrInst>(T) || isa<IndirectBrInst>(T)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 奇数 K 模 2^32 的乘法逆元，牛顿迭代每轮精度翻倍
+static uint32_t inverse(uint32_t K) {
+    uint32_t x = K;
+    for (int i = 0; i < 5; i++) {
+        x *= 2 - K * x;
+    }
+    return x;
+}
+
+PreservedAnalyses Flattening::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassFlattening &config = Options->Flattening;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "Flattening", M);
+    BudgetTracker budget(Options, "Flattening", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    LLVMContext &Ctx = M.getContext();
+    IntegerType *I32Ty = Type::getInt32Ty(Ctx);
+    bool changed = false;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "fla", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "Flattening: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (!isSupported(F)) {
+            IF_VERBOSE {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "Flattening: Unsupported {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        budget.startFunction();
+        auto &LI = FAM.getResult<LoopAnalysis>(F);
+        auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+        SmallPtrSet<BasicBlock *, 16> Hot = hotLoopBlocks(LI, BFI, config.hot);
+        // 不在混淆范围内的块与热循环一样不经过分发块
+        for (auto &BB: F) {
+            if (!scope.block(BB)) {
+                Hot.insert(&BB);
+            }
+        }
+
+        // 热循环之外、以 br / switch 结尾的块改为经过分发块跳转
+        vector<BasicBlock *> Sources;
+        vector<BasicBlock *> Targets;
+        std::set<BasicBlock *> seen;
+        for (auto &BB: F) {
+            Instruction *T = BB.getTerminator();
+            if (Hot.count(&BB) || !(isa<BranchInst>(T) || isa<SwitchInst>(T))) {
+                continue;
+            }
+            Sources.push_back(&BB);
+            for (BasicBlock *Succ: successors(&BB)) {
+                if (!Hot.count(Succ) && seen.insert(Succ).second) {
+                    Targets.push_back(Succ);
+                }
+            }
+        }
+        if (Targets.size() < 2) {
+            continue;
+        }
+        // 每个源块新增 store + select / 中转块，分发块 load + 解码 + switch
+        uint64_t estimate = Sources.size() * 3 + 4;
+        if (estimate > budget.remaining(F)) {
+            budget.degrade(F, fmt::format("growth budget exceeded, {} blocks not flattened", Sources.size()));
+            continue;
+        }
+        unsigned before = F.getInstructionCount();
+
+        // mode 0: 存储 i * K + A，分发块用 (s - A) * K^-1 还原出连续下标
+        // mode 1: 存储互不相同的随机值，分发块直接比较
+        uint32_t K = crypto->get_uint32_t() | 1;
+        uint32_t A = crypto->get_uint32_t();
+        std::map<BasicBlock *, uint32_t> State;
+        std::map<BasicBlock *, uint32_t> Case;
+        std::set<uint32_t> used;
+        for (size_t i = 0; i < Targets.size(); i++) {
+            if (config.mode == 0) {
+                Case[Targets[i]] = (uint32_t) i;
+                State[Targets[i]] = (uint32_t) i * K + A;
+            } else {
+                uint32_t value;
+                do {
+                    value = crypto->get_uint32_t();
+                } while (!used.insert(value).second);
+                Case[Targets[i]] = State[Targets[i]] = value;
+            }
+        }
+
+        BasicBlock *Entry = &F.getEntryBlock();
+        IRBuilder<> IRB(Entry, Entry->begin());
+        // 状态变量用 volatile 访问，否则 mem2reg 之后状态值变成常量 PHI，会被 jump threading 还原
+        AllocaInst *StateVar = IRB.CreateAlloca(I32Ty, nullptr, "flat.state");
+        BasicBlock *Dispatch = BasicBlock::Create(Ctx, "flat.dispatch", &F, Entry->getNextNode());
+        BasicBlock *Default = BasicBlock::Create(Ctx, "flat.default", &F);
+        new UnreachableInst(Ctx, Default);
+        IRB.SetInsertPoint(Dispatch);
+        Value *Index = IRB.CreateLoad(I32Ty, StateVar, true, "flat.s");
+        if (config.mode == 0) {
+            Index = IRB.CreateMul(IRB.CreateSub(Index, ConstantInt::get(I32Ty, A)),
+                                  ConstantInt::get(I32Ty, inverse(K)), "flat.index");
+        }
+        // default 不可达，跳转表不需要范围检查
+        SwitchInst *SI = IRB.CreateSwitch(Index, Default, Targets.size());
+        for (BasicBlock *BB: Targets) {
+            SI->addCase(ConstantInt::get(I32Ty, Case[BB]), BB);
+        }
+
+        auto Encoded = [&](BasicBlock *BB) {
+            return ConstantInt::get(I32Ty, State[BB]);
+        };
+        // 条件跳转只有一侧需要平坦化时，经过一个中转块写入状态
+        auto Route = [&](BasicBlock *Succ) {
+            BasicBlock *Edge = BasicBlock::Create(Ctx, "flat.edge", &F, Succ);
+            new StoreInst(Encoded(Succ), StateVar, true, Edge);
+            BranchInst::Create(Dispatch, Edge);
+            return Edge;
+        };
+        for (BasicBlock *BB: Sources) {
+            Instruction *T = BB->getTerminator();
+            if (auto *Br = dyn_cast<BranchInst>(T)) {
+                if (Br->isUnconditional()) {
+                    BasicBlock *Succ = Br->getSuccessor(0);
+                    if (Hot.count(Succ)) {
+                        continue;
+                    }
+                    new StoreInst(Encoded(Succ), StateVar, true, Br);
+                    Br->setSuccessor(0, Dispatch);
+                    continue;
+                }
+                BasicBlock *True = Br->getSuccessor(0);
+                BasicBlock *False = Br->getSuccessor(1);
+                if (!Hot.count(True) && !Hot.count(False)) {
+                    Value *Next = SelectInst::Create(Br->getCondition(), Encoded(True), Encoded(False), "", Br);
+                    new StoreInst(Next, StateVar, true, Br);
+                    BranchInst::Create(Dispatch, Br);
+                    Br->eraseFromParent();
+                } else if (!Hot.count(True)) {
+                    Br->setSuccessor(0, Route(True));
+                } else if (!Hot.count(False)) {
+                    Br->setSuccessor(1, Route(False));
+                }
+            } else if (auto *Sw = dyn_cast<SwitchInst>(T)) {
+                std::map<BasicBlock *, BasicBlock *> Routes;
+                for (unsigned i = 0; i < Sw->getNumSuccessors(); i++) {
+                    BasicBlock *Succ = Sw->getSuccessor(i);
+                    if (Hot.count(Succ)) {
+                        continue;
+                    }
+                    BasicBlock *&Edge = Routes[Succ];
+                    if (!Edge) {
+                        Edge = Route(Succ);
+                    }
+                    Sw->setSuccessor(i, Edge);
+                }
+            }
+        }
+
+        // 只降级不再被支配的值，热循环内部的值仍留在寄存器中
+        DominatorTree DT(F);
+        fixStack(F, DT);
+        changed = true;
+
+        unsigned after = F.getInstructionCount();
+        budget.charge(F, after > before ? after - before : 0);
+        report->addNote("Flattening", F.getName(),
+                        fmt::format("dispatcher: {} cases ({}), {} blocks kept in hot loops", SI->getNumCases(),
+                                    config.mode == 0 ? "jump table" : "sparse switch", Hot.size()));
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "Flattening: {} ({} cases, {} blocks kept in hot loops)\n",
+                                  F.getName().str(), SI->getNumCases(), Hot.size());
+        }
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
@@ -5,6 +5,7 @@
 #include "core/FuncNameObf.h"
 #include "utils/Utils.h"
 #include "utils/CryptoUtils.h"
+#include "utils/Report.h"
 #include <fmt/color.h>
 #include <fmt/core.h>
 #include <sstream>
@@ -16,6 +17,7 @@ PreservedAnalyses FuncNameObf::run(Module &M, ModuleAnalysisManager &) const {
     if (!config.enable){
         return PreservedAnalyses::all();
     }
+    PassRecorder recorder(Options, "FuncNameObf", M);
     for (auto &F: M) {
         if (!toObfuscate(config.enable, &F, "fno")){
             IF_VERBOSE2{
@@ -33,14 +35,15 @@ PreservedAnalyses FuncNameObf::run(Module &M, ModuleAnalysisManager &) const {
         }
         ss << config.suffix;
 
-        StringRef origName = F.getName();
+        std::string origName = F.getName().str();
 
         F.setName(Twine(ss.str())); // 重命名
+        report->addRenamed(&F, origName);
 
         StringRef newName = F.getName();
         IF_VERBOSE{
             outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
-                                  "FuncNameObf: {} => {}\n", origName.str(), newName.str());
+                                  "FuncNameObf: {} => {}\n", origName, newName.str());
         }
     }
     return PreservedAnalyses::all();
@@ -0,0 +1,109 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/FunctionOrder.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+// 分组按在 .text 中的先后排列
+enum Bucket {
+    Hot,
+    Normal,
+    Wrapper,
+    Cold,
+    NumBuckets
+};
+
+static const char *BucketNames[NumBuckets] = {"hot", "normal", "wrapper", "cold"};
+
+static Bucket bucketOf(Function &F, ProfileSummaryInfo &PSI) {
+    Optional<StringRef> Prefix = F.getSectionPrefix();
+    if (F.hasFnAttribute(Attribute::Cold) || PSI.isFunctionEntryCold(&F) || (Prefix && *Prefix == "unlikely")) {
+        return Cold;
+    }
+    if (F.hasFnAttribute(Attribute::Hot) || PSI.isFunctionEntryHot(&F) || (Prefix && *Prefix == "hot")) {
+        return Hot;
+    }
+    // FunctionWrapper 与 ApiHiding 生成的包装函数只做转发，单独成组，不插在业务函数之间
+    if (F.getName().startswith("Wra_") || F.getName().startswith("buer.api.stub")) {
+        return Wrapper;
+    }
+    return Normal;
+}
+
+PreservedAnalyses FunctionOrder::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassFunctionOrder &config = Options->FunctionOrder;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "FunctionOrder", M);
+    auto &PSI = MAM.getResult<ProfileSummaryAnalysis>(M);
+
+    // mode 1 不分组，所有函数放进同一组
+    vector<Function *> Buckets[NumBuckets];
+    for (auto &F: M) {
+        if (!F.isDeclaration()) {
+            Buckets[config.mode == 0 ? bucketOf(F, PSI) : Normal].push_back(&F);
+        }
+    }
+
+    // 不允许混淆的函数留在组内原来的位置，其余函数在剩下的位置之间打乱
+    size_t shuffled = 0;
+    for (auto &B: Buckets) {
+        vector<Function *> Selected;
+        vector<size_t> Slots;
+        for (size_t i = 0; i < B.size(); i++) {
+            if (toObfuscate(config.enable, B[i], "fo")) {
+                Selected.push_back(B[i]);
+                Slots.push_back(i);
+            } else {
+                IF_VERBOSE2 {
+                    outs() << fmt::format(fmt::fg(fmt::color::red),
+                                          "FunctionOrder: Ignore {}\n", B[i]->getName().str());
+                }
+            }
+        }
+        for (size_t i = Selected.size(); i > 1; i--) {
+            std::swap(Selected[i - 1], Selected[crypto->get_range(i)]);
+        }
+        for (size_t i = 0; i < Slots.size(); i++) {
+            B[Slots[i]] = Selected[i];
+        }
+        shuffled += Selected.size();
+    }
+    if (shuffled < 2) {
+        return PreservedAnalyses::all();
+    }
+
+    // 函数在 module 中的顺序就是代码生成与链接时的输出顺序，声明不生成代码，留在原处
+    auto &List = M.getFunctionList();
+    for (auto &B: Buckets) {
+        for (Function *F: B) {
+            List.splice(List.end(), List, F->getIterator());
+        }
+    }
+
+    std::string summary;
+    for (int i = 0; i < NumBuckets; i++) {
+        uint64_t size = 0;
+        for (Function *F: Buckets[i]) {
+            size += F->getInstructionCount();
+        }
+        summary += fmt::format("{}{}: {} functions / {} instructions", i ? ", " : "", BucketNames[i],
+                               Buckets[i].size(), size);
+    }
+    report->addNote("FunctionOrder", M.getName(), summary);
+    IF_VERBOSE {
+        outs() << fmt::format(fmt::fg(fmt::color::sky_blue), "FunctionOrder: {}\n", summary);
+    }
+    return PreservedAnalyses::all(); // 只调整顺序，函数内容与分析结果都不变
+}
@@ -3,7 +3,9 @@
 //
 
 #include "core/FunctionWrapper.h"
+#include "utils/Budget.h"
 #include "utils/CryptoUtils.h"
+#include "utils/Report.h"
 #include "utils/Utils.h"
 #include "llvm/Transforms/Utils/ModuleUtils.h"
 #include <fmt/color.h>
@@ -11,29 +13,37 @@
 #include <llvm/IR/IRBuilder.h>
 #include <vector>
 #include <random>
+#include <tuple>
 
 using namespace llvm;
 using std::vector;
 
-PreservedAnalyses FunctionWrapper::run(Module &M, ModuleAnalysisManager &) const {
+PreservedAnalyses FunctionWrapper::run(Module &M, ModuleAnalysisManager &MAM) const {
     PassFunctionWrapper &config = Options->FunctionWrapper;
     if (!config.enable) {
         return PreservedAnalyses::all();
     }
-    vector<CallBase *> CallBases;
+    PassRecorder recorder(Options, "FunctionWrapper", M);
+    BudgetTracker budget(Options, "FunctionWrapper", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    // 调用点与函数所在档位的包装轮数
+    vector<std::tuple<Function *, vector<CallBase *>, int>> Targets;
     for (auto &F: M) {
-        if (!toObfuscate(config.enable, &F, "fw")) {
+        Eligibility scope(Options, config.enable, F, "fw", FAM);
+        if (!scope.function()) {
             IF_VERBOSE2 {
                 outs() << fmt::format(fmt::fg(fmt::color::red),
                                       "FunctionWrapper: Ignore {}\n", F.getName().str());
             }
             continue;
         }
+        int prob = scope.prob(config.prob);
+        vector<CallBase *> CallBases;
         for (auto &BB: F) {
             for (auto &I: BB) {
-                if (isa<CallInst>(I) || isa<InvokeInst>(I)) {
-                    if (config.prob == 100 || crypto->get_range(100) < (unsigned int) config.prob) {
-                        auto &CB = cast<CallInst>(I);
+                if ((isa<CallInst>(I) || isa<InvokeInst>(I)) && scope.instruction(I)) {
+                    if (prob == 100 || crypto->get_range(100) < (unsigned int) prob) {
+                        auto &CB = cast<CallBase>(I);
                         CallBases.push_back(&CB);
                     }
                 }
@@ -43,11 +53,54 @@ PreservedAnalyses FunctionWrapper::run(Module &M, ModuleAnalysisManager &) const
             outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
                                   "FunctionWrapper: {}\n", F.getName().str());
         }
+        Targets.emplace_back(&F, std::move(CallBases), scope.repeat(config.times));
     }
 
-    for (auto &CB: CallBases) {
-        for (int i = 0; i < config.times; i++) {
-            CB = HandleCallBase(CB);
+    for (auto &Target: Targets) {
+        Function &F = *std::get<0>(Target);
+        vector<CallBase *> &CallBases = std::get<1>(Target);
+        if (CallBases.empty()) {
+            continue;
+        }
+        // 每轮为每个调用点新增一个包装函数（call + ret）
+        uint64_t roundCost = CallBases.size() * 2;
+        uint64_t allowed = budget.remaining(F);
+        int times = std::get<2>(Target);
+        if (budget.moduleTimeExceeded() && times > 1) {
+            budget.degrade(F, fmt::format("module time budget exceeded, times {} -> 1", times));
+            times = 1;
+        }
+        if (roundCost * times > allowed) {
+            int fitTimes = (int) (allowed / roundCost);
+            if (fitTimes >= 1) {
+                budget.degrade(F, fmt::format("growth budget exceeded, times {} -> {}", times, fitTimes));
+                times = fitTimes;
+            } else {
+                // 一轮都放不下，随机保留一部分调用点
+                size_t keep = allowed / 2;
+                for (size_t i = CallBases.size() - 1; i > 0; i--) {
+                    std::swap(CallBases[i], CallBases[crypto->get_range(i + 1)]);
+                }
+                budget.degrade(F, fmt::format("growth budget exceeded, times {} -> 1, prob {} -> {}",
+                                              times, config.prob,
+                                              config.prob * keep / CallBases.size()));
+                CallBases.resize(keep);
+                times = 1;
+            }
+        }
+        budget.startFunction();
+        for (int i = 0; i < times; i++) {
+            for (auto &CB: CallBases) {
+                CB = HandleCallBase(CB);
+                if (CB) {
+                    budget.charge(F, 2);
+                    report->addGenerated("FunctionWrapper", CB->getCalledFunction(), &F);
+                }
+            }
+            if (i + 1 < times && budget.functionTimeExceeded()) {
+                budget.degrade(F, fmt::format("function time budget exceeded, times {} -> {}", times, i + 1));
+                break;
+            }
         }
     }
 
@@ -58,6 +111,14 @@ CallBase *FunctionWrapper::HandleCallBase(CallBase *CB) {
     if (CB == nullptr) {
         return nullptr;
     }
+    Function *func = CreateWrapper(CB);
+    if (func == nullptr) {
+        return nullptr;
+    }
+    return Redirect(CB, func);
+}
+
+Function *FunctionWrapper::CreateWrapper(CallBase *CB, StringRef Name) {
     if (CB->isIndirectCall()) {
         return nullptr;
     }
@@ -78,7 +139,9 @@ CallBase *FunctionWrapper::HandleCallBase(CallBase *CB) {
     FunctionType *fTy = FunctionType::get(CB->getType(), ArrayRef<Type *>(types), false);
 
     std::string funcName;
-    if (!calledFunctionName.startswith("Wra_")) {
+    if (!Name.empty()) {
+        funcName = Name.str();
+    } else if (!calledFunctionName.startswith("Wra_")) {
         funcName = "Wra_" + calledFunctionName.str();
     } else {
         funcName = calledFunctionName.str();
@@ -90,7 +153,12 @@ CallBase *FunctionWrapper::HandleCallBase(CallBase *CB) {
     appendToCompilerUsed(*func->getParent(), {func});
 
     func->copyAttributesFrom(cast<Function>(calledFunction));
+    // 被包装的可能是 hidden 函数（如 buer_rt 的辅助函数），internal 函数只能是默认可见性
+    func->setVisibility(GlobalValue::DefaultVisibility);
     func->removeFnAttr(Attribute::AttrKind::AlwaysInline);
+    // optnone 不能与 optsize / minsize 共存，被包装的可能是冷函数或垃圾函数
+    func->removeFnAttr(Attribute::AttrKind::OptimizeForSize);
+    func->removeFnAttr(Attribute::AttrKind::MinSize);
     func->addFnAttr(Attribute::AttrKind::NoInline);
     func->addFnAttr(Attribute::AttrKind::OptimizeNone);
 
@@ -98,21 +166,25 @@ CallBase *FunctionWrapper::HandleCallBase(CallBase *CB) {
     BasicBlock *BB = BasicBlock::Create(func->getContext(), "MainBB", func);
     IRBuilder<> builder(BB);
 
+    vector<Value *> params;
+    for (auto& arg : func->args()) {
+        params.push_back(&arg);
+    }
+    Constant *callee = ConstantExpr::getBitCast(calledFunction, calledFunction->getType());
+    Value *ret = builder.CreateCall(
+            cast<FunctionType>(callee->getType()->getPointerElementType()),
+            callee,
+            ArrayRef<Value *>(params));
     if (fTy->getReturnType()->isVoidTy()) {
         builder.CreateRetVoid();
     } else {
-        vector<Value *> params;
-        for (auto& arg : func->args()) {
-            params.push_back(&arg);
-        }
-        Constant *callee = ConstantExpr::getBitCast(calledFunction, calledFunction->getType());
-        Value *ret = builder.CreateCall(
-                cast<FunctionType>(callee->getType()->getPointerElementType()),
-                callee,
-                ArrayRef<Value *>(params));
         builder.CreateRet(ret);
     }
-    CB->setCalledFunction(func);
-    CB->mutateFunctionType(fTy);
+    return func;
+}
+
+CallBase *FunctionWrapper::Redirect(CallBase *CB, Function *Wrapper) {
+    CB->setCalledFunction(Wrapper);
+    CB->mutateFunctionType(Wrapper->getFunctionType());
     return CB;
 }
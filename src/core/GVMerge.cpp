@@ -0,0 +1,454 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/GVMerge.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+const uint64_t GVMerge::UseCost;
+
+static const uint64_t CacheLine = 64;
+
+// 异常处理要求类型信息是符号本身，不能换成 blob 内的偏移
+static bool usedByEHPad(Value *V) {
+    for (User *U: V->users()) {
+        if (auto *I = dyn_cast<Instruction>(U)) {
+            auto *II = dyn_cast<IntrinsicInst>(I);
+            if (I->isEHPad() || (II && II->getIntrinsicID() == Intrinsic::eh_typeid_for)) {
+                return true;
+            }
+        } else if (isa<ConstantExpr>(U) && usedByEHPad(U)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GVMerge::isCandidate(GlobalVariable &GV) {
+    if (!GV.hasLocalLinkage() || !GV.hasInitializer() || GV.isThreadLocal() || GV.hasSection() ||
+        GV.hasComdat() || GV.isExternallyInitialized() || GV.hasAttributes() || GV.getAddressSpace() != 0) {
+        return false;
+    }
+    // llvm.* 由编译器使用，buer.* 是其他 pass 生成的变量，需要保持独立
+    if (GV.getName().startswith("llvm.") || GV.getName().startswith("buer.")) {
+        return false;
+    }
+    Type *Ty = GV.getValueType();
+    if (!Ty->isSized() || isa<ScalableVectorType>(Ty)) {
+        return false;
+    }
+    return !usedByEHPad(&GV);
+}
+
+// V 直接或经过常量表达式引用的候选变量
+static void collectReferenced(Value *V, const std::map<GlobalVariable *, unsigned> &Index,
+                              std::set<unsigned> &Result) {
+    if (auto *GV = dyn_cast<GlobalVariable>(V)) {
+        auto It = Index.find(GV);
+        if (It != Index.end()) {
+            Result.insert(It->second);
+        }
+    } else if (auto *CE = dyn_cast<ConstantExpr>(V)) {
+        for (Value *Op: CE->operands()) {
+            collectReferenced(Op, Index, Result);
+        }
+    }
+}
+
+// 经过常量表达式引用 C 的指令数，按所在函数统计
+static void countUses(Constant *C, std::map<Function *, uint64_t> &Uses) {
+    for (User *U: C->users()) {
+        if (auto *I = dyn_cast<Instruction>(U)) {
+            Uses[I->getFunction()]++;
+        } else if (auto *CE = dyn_cast<ConstantExpr>(U)) {
+            countUses(CE, Uses);
+        }
+    }
+}
+
+// 其他全局变量初值中对 C 的引用，对应数据段中的重定位
+static uint64_t countDataRefs(Constant *C) {
+    uint64_t count = 0;
+    for (User *U: C->users()) {
+        if (auto *GV = dyn_cast<GlobalVariable>(U)) {
+            count += !GV->getName().startswith("llvm.");
+        } else if (isa<ConstantExpr>(U) || isa<ConstantAggregate>(U)) {
+            count += countDataRefs(cast<Constant>(U));
+        }
+    }
+    return count;
+}
+
+// 把 Allowed 函数中引用 C 的常量表达式展开为指令，展开后这些指令直接引用 C 的底层全局变量
+static void lowerConstantUsers(Constant *C, const std::set<Function *> &Allowed) {
+    vector<User *> Users(C->user_begin(), C->user_end());
+    for (User *U: Users) {
+        if (auto *CE = dyn_cast<ConstantExpr>(U)) {
+            lowerConstantUsers(CE, Allowed);
+        }
+    }
+    auto *CE = dyn_cast<ConstantExpr>(C);
+    if (!CE) {
+        return;
+    }
+    Users.assign(CE->user_begin(), CE->user_end());
+    for (User *U: Users) {
+        auto *I = dyn_cast<Instruction>(U);
+        if (!I || !Allowed.count(I->getFunction())) {
+            continue;
+        }
+        if (auto *PHI = dyn_cast<PHINode>(I)) {
+            for (unsigned i = 0; i < PHI->getNumIncomingValues(); i++) {
+                if (PHI->getIncomingValue(i) == CE) {
+                    Instruction *NewInst = CE->getAsInstruction();
+                    NewInst->insertBefore(PHI->getIncomingBlock(i)->getTerminator());
+                    PHI->setIncomingValue(i, NewInst);
+                }
+            }
+        } else {
+            Instruction *NewInst = CE->getAsInstruction();
+            NewInst->insertBefore(I);
+            I->replaceUsesOfWith(CE, NewInst);
+        }
+    }
+}
+
+// 合并后的 blob 及成员偏移
+struct Blob {
+    const char *name;
+    vector<GlobalVariable *> Members;
+    GlobalVariable *GV = nullptr;
+    std::map<GlobalVariable *, std::pair<unsigned, uint64_t>> Field; // 成员 -> (字段下标, 偏移)
+    uint64_t size = 0;
+    uint64_t padding = 0;
+};
+
+PreservedAnalyses GVMerge::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassGVMerge &config = Options->GVMerge;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "GVMerge", M);
+    BudgetTracker budget(Options, "GVMerge", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    const DataLayout &DL = M.getDataLayout();
+    LLVMContext &Ctx = M.getContext();
+    IntegerType *IntPtrTy = DL.getIntPtrType(Ctx);
+    PointerType *I8PtrTy = Type::getInt8PtrTy(Ctx);
+
+    SmallVector<GlobalValue *, 16> Used;
+    collectUsedGlobalVariables(M, Used, false);
+    collectUsedGlobalVariables(M, Used, true);
+    std::set<GlobalValue *> UsedSet(Used.begin(), Used.end());
+
+    vector<GlobalVariable *> Candidates;
+    for (auto &GV: M.globals()) {
+        if (!isCandidate(GV) || UsedSet.count(&GV) || !toObfuscate(config.enable, &GV, "gvm")) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "GVMerge: Ignore {}\n", GV.getName().str());
+            }
+            continue;
+        }
+        Candidates.push_back(&GV);
+    }
+    if (Candidates.size() < 2) {
+        return PreservedAnalyses::all();
+    }
+    for (size_t i = Candidates.size() - 1; i > 0; i--) {
+        std::swap(Candidates[i], Candidates[crypto->get_range(i + 1)]);
+    }
+    std::map<GlobalVariable *, unsigned> Index;
+    for (unsigned i = 0; i < Candidates.size(); i++) {
+        Index[Candidates[i]] = i;
+    }
+
+    // 访问次数与共同访问权重（同一函数中两个变量访问次数的较小值之和），只记录出现过的变量对
+    vector<double> Count(Candidates.size(), 0);
+    vector<std::map<unsigned, double>> Affinity(Candidates.size());
+    std::map<Function *, std::set<unsigned>> Referenced;
+    for (auto &F: M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+        double entry = (double) BFI.getEntryFreq();
+        // 有 profile 时按实际次数，否则按相对入口的估计频率
+        double scale = F.getEntryCount() ? (double) F.getEntryCount()->getCount() : 1;
+        std::map<unsigned, double> Local;
+        for (auto &BB: F) {
+            double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry * scale;
+            for (auto &I: BB) {
+                std::set<unsigned> Refs;
+                for (Value *Op: I.operands()) {
+                    collectReferenced(Op, Index, Refs);
+                }
+                for (unsigned k: Refs) {
+                    Local[k] += freq;
+                }
+            }
+        }
+        for (auto &A: Local) {
+            Count[A.first] += A.second;
+            Referenced[&F].insert(A.first);
+            for (auto &B: Local) {
+                if (A.first != B.first) {
+                    Affinity[A.first][B.first] += std::min(A.second, B.second);
+                }
+            }
+        }
+    }
+
+    // 只读、已初始化、零初始化的变量分开合并，保持原有的段属性
+    Blob Blobs[3] = {{"buer.gvm.rodata"}, {"buer.gvm.data"}, {"buer.gvm.bss"}};
+    for (GlobalVariable *GV: Candidates) {
+        if (GV->isConstant()) {
+            Blobs[0].Members.push_back(GV);
+        } else if (!GV->getInitializer()->isNullValue()) {
+            Blobs[1].Members.push_back(GV);
+        } else {
+            Blobs[2].Members.push_back(GV);
+        }
+    }
+
+    auto alignOf = [&](GlobalVariable *GV) {
+        return DL.getPreferredAlign(GV);
+    };
+    auto sizeOf = [&](GlobalVariable *GV) {
+        return DL.getTypeAllocSize(GV->getValueType()).getFixedValue();
+    };
+    auto byAlign = [&](GlobalVariable *A, GlobalVariable *B) {
+        return alignOf(A) > alignOf(B);
+    };
+
+    size_t merged = 0;
+    for (Blob &B: Blobs) {
+        if (B.Members.size() < 2) {
+            B.Members.clear();
+            continue;
+        }
+        vector<GlobalVariable *> Order;
+        if (!config.locality) {
+            Order = B.Members;
+            std::stable_sort(Order.begin(), Order.end(), byAlign);
+        } else {
+            // 从最热的变量开始逐条填充 cache line，每次加入与当前行共同访问最多的变量，行内按对齐排列
+            vector<GlobalVariable *> Remaining = B.Members;
+            std::stable_sort(Remaining.begin(), Remaining.end(), [&](GlobalVariable *X, GlobalVariable *Y) {
+                return Count[Index[X]] > Count[Index[Y]];
+            });
+            std::set<unsigned> Members, Placed;
+            for (GlobalVariable *GV: B.Members) {
+                Members.insert(Index[GV]);
+            }
+            auto next = Remaining.begin();
+            while (Order.size() < B.Members.size()) {
+                while (Placed.count(Index[*next])) {
+                    ++next;
+                }
+                vector<GlobalVariable *> Line{*next};
+                Placed.insert(Index[*next]);
+                uint64_t bytes = sizeOf(*next);
+                while (bytes < CacheLine && Placed.size() < B.Members.size()) {
+                    std::map<unsigned, double> Score;
+                    for (GlobalVariable *GV: Line) {
+                        for (auto &A: Affinity[Index[GV]]) {
+                            if (Members.count(A.first) && !Placed.count(A.first)) {
+                                Score[A.first] += A.second;
+                            }
+                        }
+                    }
+                    GlobalVariable *best = nullptr;
+                    double bestScore = 0;
+                    for (auto &S: Score) {
+                        if (S.second > bestScore) {
+                            best = Candidates[S.first];
+                            bestScore = S.second;
+                        }
+                    }
+                    if (!best) {
+                        break; // 与当前行没有共同访问的变量时另起一行
+                    }
+                    Line.push_back(best);
+                    Placed.insert(Index[best]);
+                    bytes += sizeOf(best);
+                }
+                std::stable_sort(Line.begin(), Line.end(), byAlign);
+                Order.insert(Order.end(), Line.begin(), Line.end());
+            }
+        }
+
+        vector<Type *> Fields;
+        vector<Constant *> Inits;
+        uint64_t offset = 0;
+        Align maxAlign(CacheLine);
+        for (GlobalVariable *GV: Order) {
+            Align A = alignOf(GV);
+            maxAlign = std::max(maxAlign, A);
+            uint64_t aligned = alignTo(offset, A);
+            if (aligned > offset) {
+                Type *PadTy = ArrayType::get(Type::getInt8Ty(Ctx), aligned - offset);
+                Fields.push_back(PadTy);
+                Inits.push_back(ConstantAggregateZero::get(PadTy));
+                B.padding += aligned - offset;
+            }
+            B.Field[GV] = {(unsigned) Fields.size(), aligned};
+            Fields.push_back(GV->getValueType());
+            Inits.push_back(GV->getInitializer());
+            offset = aligned + sizeOf(GV);
+        }
+        B.size = offset;
+        // packed 结构体的字段偏移完全由上面插入的填充决定
+        StructType *BlobTy = StructType::get(Ctx, Fields, true);
+        Constant *Init = &B == &Blobs[2] ? ConstantAggregateZero::get(BlobTy) : ConstantStruct::get(BlobTy, Inits);
+        B.GV = new GlobalVariable(M, BlobTy, &B == &Blobs[0], GlobalValue::InternalLinkage, Init, B.name);
+        B.GV->setAlignment(maxAlign);
+        for (GlobalVariable *GV: Order) {
+            B.GV->copyMetadata(GV, B.Field[GV].second); // 调试信息的位置加上偏移
+        }
+        B.Members = Order;
+        merged += Order.size();
+    }
+    if (!merged) {
+        return PreservedAnalyses::all();
+    }
+
+    // 重定位估计：每个函数对每个符号至少取一次地址，合并后同一函数只需取一次 blob 地址
+    std::map<GlobalVariable *, Blob *> Owner;
+    for (Blob &B: Blobs) {
+        for (GlobalVariable *GV: B.Members) {
+            Owner[GV] = &B;
+        }
+    }
+    uint64_t refsBefore = 0, refsAfter = 0, dataRefs = 0;
+    for (auto &R: Referenced) {
+        std::set<Blob *> Targets;
+        for (unsigned k: R.second) {
+            auto It = Owner.find(Candidates[k]);
+            if (It != Owner.end()) {
+                refsBefore++;
+                Targets.insert(It->second);
+            }
+        }
+        refsAfter += Targets.size();
+    }
+
+    // 函数中的访问改为 基址 + (编码偏移 - 密钥)，超出预算或带 no-gvm 注解的函数直接使用 blob 内的常量地址
+    std::map<Function *, uint64_t> Uses;
+    for (auto &It: Owner) {
+        countUses(It.first, Uses);
+        dataRefs += countDataRefs(It.first);
+    }
+    std::set<Function *> Allowed;
+    for (auto &U: Uses) {
+        Function *F = U.first;
+        if (F->hasFnAttribute(Attribute::Naked) || readAnnotate(F).find("no-gvm") != std::string::npos) {
+            continue;
+        }
+        if (U.second * UseCost + 1 > budget.remaining(*F)) {
+            budget.degrade(*F, fmt::format("growth budget exceeded, {} accesses left unencoded", U.second));
+            continue;
+        }
+        Allowed.insert(F);
+    }
+    size_t sites = 0;
+    if (!Allowed.empty()) {
+        uint64_t Key = crypto->get_uint32_t() | 0x10;
+        auto *KeyVar = new GlobalVariable(M, IntPtrTy, false, GlobalValue::InternalLinkage,
+                                          ConstantInt::get(IntPtrTy, Key), "buer.gvm.key");
+        appendToCompilerUsed(M, {KeyVar}); // 密钥不能被 GlobalOpt 折叠
+        MDNode *Invariant = MDNode::get(Ctx, {});
+        std::map<Function *, LoadInst *> Keys;
+        for (auto &It: Owner) {
+            GlobalVariable *GV = It.first;
+            Blob &B = *It.second;
+            lowerConstantUsers(GV, Allowed);
+            vector<Use *> Direct;
+            for (Use &U: GV->uses()) {
+                auto *I = dyn_cast<Instruction>(U.getUser());
+                if (I && Allowed.count(I->getFunction())) {
+                    Direct.push_back(&U);
+                }
+            }
+            for (Use *U: Direct) {
+                auto *I = cast<Instruction>(U->getUser());
+                Function *F = I->getFunction();
+                if (budget.moduleTimeExceeded()) {
+                    break;
+                }
+                LoadInst *&K = Keys[F];
+                if (!K) {
+                    BasicBlock &Entry = F->getEntryBlock();
+                    IRBuilder<> IRB(&Entry, Entry.getFirstInsertionPt());
+                    K = IRB.CreateLoad(IntPtrTy, KeyVar, "gvm.key");
+                    K->setMetadata(LLVMContext::MD_invariant_load, Invariant);
+                    budget.charge(*F, 1);
+                }
+                auto *PHI = dyn_cast<PHINode>(I);
+                IRBuilder<> IRB(PHI ? PHI->getIncomingBlock(*U)->getTerminator() : I);
+                Constant *Encoded = ConstantInt::get(IntPtrTy, B.Field[GV].second + Key);
+                Value *Ptr = IRB.CreateInBoundsGEP(IRB.getInt8Ty(), ConstantExpr::getBitCast(B.GV, I8PtrTy),
+                                                   IRB.CreateSub(Encoded, K), "gvm.ptr");
+                U->set(IRB.CreateBitCast(Ptr, GV->getType()));
+                budget.charge(*F, UseCost);
+                sites++;
+            }
+        }
+        if (budget.moduleTimeExceeded()) {
+            report->addNote("GVMerge", M.getName(), "module time budget exceeded, remaining accesses left unencoded");
+        }
+    }
+
+    // 其余引用（全局变量初值、未编码的函数）指向 blob 中的对应字段
+    for (auto &It: Owner) {
+        GlobalVariable *GV = It.first;
+        Blob &B = *It.second;
+        Constant *Idx[] = {ConstantInt::get(Type::getInt32Ty(Ctx), 0),
+                           ConstantInt::get(Type::getInt32Ty(Ctx), B.Field[GV].first)};
+        GV->replaceAllUsesWith(ConstantExpr::getInBoundsGetElementPtr(B.GV->getValueType(), B.GV, Idx));
+    }
+    for (Blob &B: Blobs) {
+        if (!B.GV) {
+            continue;
+        }
+        uint64_t hot = 0;
+        for (GlobalVariable *GV: B.Members) {
+            hot += B.Field[GV].second < CacheLine;
+        }
+        report->addNote("GVMerge", B.name,
+                        fmt::format("{} globals, {} bytes, padding {}, {} globals in the first cache line",
+                                    B.Members.size(), B.size, B.padding, hot));
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "GVMerge: {} ({} globals, {} bytes)\n", B.name, B.Members.size(), B.size);
+        }
+    }
+    size_t blobs = 0;
+    for (Blob &B: Blobs) {
+        blobs += B.GV != nullptr;
+    }
+    report->addNote("GVMerge", M.getName(),
+                    fmt::format("symbols {} -> {}, text address relocations {} -> {}, "
+                                "data relocations {} (retargeted to blobs), {} encoded accesses",
+                                merged, blobs, refsBefore, refsAfter, dataRefs, sites));
+    for (auto &It: Owner) {
+        It.first->eraseFromParent();
+    }
+    return PreservedAnalyses::none();
+}
@@ -5,6 +5,7 @@
 #include "core/GVNameObf.h"
 #include "utils/Utils.h"
 #include "utils/CryptoUtils.h"
+#include "utils/Report.h"
 #include <fmt/color.h>
 #include <fmt/core.h>
 #include <sstream>
@@ -16,6 +17,7 @@ PreservedAnalyses GVNameObf::run(Module &M, ModuleAnalysisManager &) const {
     if (!config.enable){
         return PreservedAnalyses::all();
     }
+    PassRecorder recorder(Options, "GVNameObf", M);
     for (auto &GV: M.globals()) {
         if (!toObfuscate(config.enable, &GV, "gvn")){
             IF_VERBOSE2{
@@ -0,0 +1,180 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/IndirectCall.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/IR/IRBuilder.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+const uint64_t IndirectCall::CallCost;
+
+bool IndirectCall::isCandidate(CallBase &CB) {
+    Function *Callee = CB.getCalledFunction();
+    if (!Callee || CB.isInlineAsm() || Callee->isIntrinsic() || Callee->getName().startswith("clang.")) {
+        return false;
+    }
+    // dllimport 的地址不能出现在静态初始化中；arc attachedcall 要求直接调用
+    if (Callee->hasDLLImportStorageClass() ||
+        CB.countOperandBundlesOfType(LLVMContext::OB_clang_arc_attachedcall)) {
+        return false;
+    }
+    return CB.getFunctionType() == Callee->getFunctionType();
+}
+
+// 表与密钥都不是常量且加入 llvm.compiler.used，GlobalOpt 无法把读取折叠回直接调用
+static GlobalVariable *createHiddenGlobal(Module &M, Type *Ty, Constant *Init, StringRef Name) {
+    auto *GV = new GlobalVariable(M, Ty, false, GlobalValue::InternalLinkage, Init, Name);
+    appendToCompilerUsed(M, {GV});
+    return GV;
+}
+
+PreservedAnalyses IndirectCall::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassIndirectCall &config = Options->IndirectCall;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "IndirectCall", M);
+    BudgetTracker budget(Options, "IndirectCall", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    LLVMContext &Ctx = M.getContext();
+    IntegerType *IntPtrTy = M.getDataLayout().getIntPtrType(Ctx);
+    PointerType *I8PtrTy = Type::getInt8PtrTy(Ctx);
+
+    // 收集调用点，同时按块频率累计每个被调函数的调用次数
+    vector<std::pair<Function *, vector<CallBase *>>> Targets;
+    std::map<Function *, double> Weight;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "icall", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "IndirectCall: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+        double entry = (double) BFI.getEntryFreq();
+        // 有 profile 时按实际次数，否则按相对入口的估计频率
+        double scale = F.getEntryCount() ? (double) F.getEntryCount()->getCount() : 1;
+        int prob = scope.prob(config.prob);
+        vector<CallBase *> CallBases;
+        for (auto &BB: F) {
+            for (auto &I: BB) {
+                auto *CB = dyn_cast<CallBase>(&I);
+                if (!CB || !isCandidate(*CB) || !scope.instruction(*CB)) {
+                    continue;
+                }
+                if (prob == 100 || crypto->get_range(100) < (unsigned int) prob) {
+                    CallBases.push_back(CB);
+                }
+            }
+        }
+        if (CallBases.empty()) {
+            continue;
+        }
+        uint64_t allowed = budget.remaining(F);
+        if (CallBases.size() * CallCost > allowed) {
+            size_t keep = allowed / CallCost;
+            for (size_t i = CallBases.size() - 1; i > 0; i--) {
+                std::swap(CallBases[i], CallBases[crypto->get_range(i + 1)]);
+            }
+            budget.degrade(F, fmt::format("growth budget exceeded, prob {} -> {}", prob,
+                                          prob * keep / CallBases.size()));
+            CallBases.resize(keep);
+            if (CallBases.empty()) {
+                continue;
+            }
+        }
+        for (CallBase *CB: CallBases) {
+            Weight[CB->getCalledFunction()] += BFI.getBlockFreq(CB->getParent()).getFrequency() / entry * scale;
+        }
+        Targets.emplace_back(&F, std::move(CallBases));
+    }
+    if (Targets.empty()) {
+        return PreservedAnalyses::all();
+    }
+
+    // 调用越频繁的函数排在越前面，稳定排序保证同一输入生成同一张表
+    vector<Function *> Callees;
+    for (auto &F: M) {
+        if (Weight.count(&F)) {
+            Callees.push_back(&F);
+        }
+    }
+    std::stable_sort(Callees.begin(), Callees.end(), [&](Function *A, Function *B) {
+        return Weight[A] > Weight[B];
+    });
+
+    // 表项存放 F + Key，重定位带 addend 即可表示，调用前减去 Key 还原
+    uint64_t Key = crypto->get_uint32_t() | 0x10;
+    std::map<Function *, uint64_t> Index;
+    vector<Constant *> Entries;
+    for (Function *Callee: Callees) {
+        Index[Callee] = Entries.size();
+        Entries.push_back(ConstantExpr::getGetElementPtr(
+                Type::getInt8Ty(Ctx), ConstantExpr::getBitCast(Callee, I8PtrTy), ConstantInt::get(IntPtrTy, Key)));
+    }
+    ArrayType *TableTy = ArrayType::get(I8PtrTy, Entries.size());
+    GlobalVariable *Table = createHiddenGlobal(M, TableTy, ConstantArray::get(TableTy, Entries), "buer.icall.table");
+    Table->setAlignment(Align(64));
+    GlobalVariable *KeyVar = createHiddenGlobal(M, IntPtrTy, ConstantInt::get(IntPtrTy, Key), "buer.icall.key");
+    // 表和密钥在运行期不会被写入，invariant.load 让 LICM / GVN 可以把读取提到循环外并合并
+    MDNode *Invariant = MDNode::get(Ctx, {});
+
+    size_t sites = 0;
+    for (auto &Target: Targets) {
+        Function &F = *Target.first;
+        vector<CallBase *> &CallBases = Target.second;
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        budget.startFunction();
+        unsigned before = F.getInstructionCount();
+        BasicBlock &Entry = F.getEntryBlock();
+        IRBuilder<> IRB(&Entry, Entry.getFirstInsertionPt());
+        LoadInst *K = IRB.CreateLoad(IntPtrTy, KeyVar, "icall.key");
+        K->setMetadata(LLVMContext::MD_invariant_load, Invariant);
+        size_t done = 0;
+        for (CallBase *CB: CallBases) {
+            if (budget.functionTimeExceeded()) {
+                budget.degrade(F, fmt::format("function time budget exceeded, {} of {} calls", done,
+                                              CallBases.size()));
+                break;
+            }
+            Function *Callee = CB->getCalledFunction();
+            IRB.SetInsertPoint(CB);
+            Value *Slot = IRB.CreateConstInBoundsGEP2_64(TableTy, Table, 0, Index[Callee]);
+            LoadInst *Encoded = IRB.CreateLoad(I8PtrTy, Slot, "icall.enc");
+            Encoded->setMetadata(LLVMContext::MD_invariant_load, Invariant);
+            Value *Decoded = IRB.CreateIntToPtr(IRB.CreateSub(IRB.CreatePtrToInt(Encoded, IntPtrTy), K),
+                                                Callee->getType(), "icall.ptr");
+            CB->setCalledOperand(Decoded);
+            done++;
+        }
+        sites += done;
+        unsigned after = F.getInstructionCount();
+        budget.charge(F, after > before ? after - before : 0);
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "IndirectCall: {} ({} calls)\n", F.getName().str(), done);
+        }
+    }
+    report->addNote("IndirectCall", M.getName(),
+                    fmt::format("table: {} entries in {} cache lines, {} call sites", Entries.size(),
+                                (Entries.size() * M.getDataLayout().getPointerSize() + 63) / 64, sites));
+    return PreservedAnalyses::none();
+}
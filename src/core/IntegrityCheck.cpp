@@ -0,0 +1,91 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/IntegrityCheck.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/ADT/Triple.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+
+using namespace llvm;
+
+// C++14 下 odr-use（如与 Twine 拼接时绑定到引用）需要类外定义
+constexpr const char *IntegrityCheck::TextSection;
+constexpr const char *IntegrityCheck::SumSection;
+
+// 链接器生成的段边界，每个 so 各自一份
+static GlobalVariable *getSectionBound(Module &M, const Twine &Name) {
+    if (GlobalVariable *GV = M.getNamedGlobal(Name.str())) {
+        return GV;
+    }
+    auto *GV = new GlobalVariable(M, Type::getInt8Ty(M.getContext()), false, GlobalValue::ExternalLinkage,
+                                  nullptr, Name);
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+    GV->setDSOLocal(true);
+    return GV;
+}
+
+PreservedAnalyses IntegrityCheck::run(Module &M, ModuleAnalysisManager &) const {
+    PassIntegrityCheck &config = Options->IntegrityCheck;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "IntegrityCheck", M);
+    if (!Triple(M.getTargetTriple()).isOSBinFormatELF()) {
+        report->addNote("IntegrityCheck", M.getName(), "not an ELF target, skipped");
+        return PreservedAnalyses::all();
+    }
+    size_t count = 0;
+    for (auto &F: M) {
+        // 已经指定了段的函数（包括 buer_rt 需要的构造函数）保持原样
+        if (!toObfuscate(config.enable, &F, "ic") || F.hasSection()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "IntegrityCheck: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        F.setSection(TextSection);
+        count++;
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "IntegrityCheck: {}\n", F.getName().str());
+        }
+    }
+    if (!count) {
+        return PreservedAnalyses::all();
+    }
+
+    LLVMContext &Ctx = M.getContext();
+    Type *I8PtrTy = Type::getInt8PtrTy(Ctx);
+    IntegerType *I32Ty = Type::getInt32Ty(Ctx);
+    // 不能是常量：链接后才写入真实值，编译期的 0 不能被折叠
+    auto *Sum = new GlobalVariable(M, I32Ty, false, GlobalValue::WeakAnyLinkage, ConstantInt::get(I32Ty, 0),
+                                   "buer.ic.sum");
+    Sum->setComdat(M.getOrInsertComdat(Sum->getName()));
+    Sum->setSection(SumSection);
+    Sum->setVisibility(GlobalValue::HiddenVisibility);
+    Sum->setAlignment(Align(4));
+
+    Function *Init = Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false),
+                                      GlobalValue::PrivateLinkage, "buer.ic.init", M);
+    Init->addFnAttr(Attribute::NoUnwind);
+    Init->addFnAttr(Attribute::Cold);
+    IRBuilder<> IRB(BasicBlock::Create(Ctx, "entry", Init));
+    FunctionType *FTy = FunctionType::get(Type::getVoidTy(Ctx),
+                                          {I8PtrTy, I8PtrTy, I32Ty->getPointerTo(), I32Ty, I32Ty}, false);
+    IRB.CreateCall(getRuntimeFunction(M, "__buer_rt_v1_ic_register", FTy),
+                   {getSectionBound(M, Twine("__start_") + TextSection),
+                    getSectionBound(M, Twine("__stop_") + TextSection), Sum,
+                    ConstantInt::get(I32Ty, config.interval), ConstantInt::get(I32Ty, config.chunk)});
+    IRB.CreateRetVoid();
+    // 默认优先级，排在其他初始化之后；登记本身只加锁写表，第一次登记时创建线程
+    appendToGlobalCtors(M, Init, 65535);
+    report->addGenerated("IntegrityCheck", Init, nullptr);
+    report->addNote("IntegrityCheck", M.getName(), fmt::format("{} functions moved to {}", count, TextSection));
+    return PreservedAnalyses::none();
+}
@@ -0,0 +1,150 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/OverheadPlanner.h"
+#include "utils/Overhead.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/ADT/StringExtras.h>
+#include <algorithm>
+#include <map>
+#include <set>
+
+using namespace llvm;
+
+// pass 名到注解名的映射
+static StringRef annotationOf(StringRef Pass) {
+    if (Pass == "FunctionWrapper") {
+        return "fw";
+    }
+    if (Pass == "StringEncryption") {
+        return "se";
+    }
+    if (Pass == "Substitution") {
+        return "sub";
+    }
+    if (Pass == "Flattening") {
+        return "fla";
+    }
+    if (Pass == "BogusControlFlow") {
+        return "bcf";
+    }
+    if (Pass == "IndirectCall") {
+        return "icall";
+    }
+    if (Pass == "GVMerge") {
+        return "gvm";
+    }
+    if (Pass == "ApiHiding") {
+        return "api";
+    }
+    if (Pass == "SwitchEncoding") {
+        return "swe";
+    }
+    return "";
+}
+
+PreservedAnalyses OverheadPlanner::run(Module &M, ModuleAnalysisManager &MAM) const {
+    ObfuscationBudget &config = Options->Budget;
+    if (!config.text_growth && !config.latency_growth && Options->report.empty()) {
+        return PreservedAnalyses::all();
+    }
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    OverheadEstimator estimator(Options, FAM);
+
+    uint64_t moduleSize = 0;
+    std::vector<PlanEntry> entries;
+    for (auto &F: M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        uint64_t size = estimator.size(F);
+        moduleSize += size;
+        double latency = -1;
+        for (auto &overhead: estimator.estimate(F)) {
+            if (latency < 0) {
+                latency = estimator.latency(F);
+            }
+            PlanEntry entry;
+            entry.function = F.getName().str();
+            entry.pass = overhead.pass;
+            entry.F = &F;
+            entry.baseSize = size;
+            entry.baseLatency = latency;
+            entry.size = overhead.size;
+            entry.latency = overhead.latency;
+            entry.selected = true;
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    // 优先级：显式注解的对象优先，其次是单位延迟开销低的，再其次是体积小的
+    // 注解按词比较：no-fw 中含有 fw，不能当作显式开启
+    std::set<std::pair<Function *, std::string>> requested;
+    for (auto &E: entries) {
+        std::string annotate = readAnnotate(E.F);
+        SmallVector<StringRef, 8> tokens;
+        SplitString(annotate, tokens, StringRef(" ,\t\n\0", 5));
+        if (is_contained(tokens, annotationOf(E.pass))) {
+            requested.emplace(E.F, E.pass);
+        }
+    }
+    auto explicitly = [&](const PlanEntry &E) {
+        return requested.count({E.F, E.pass}) != 0;
+    };
+    auto relativeLatency = [](const PlanEntry &E) {
+        return E.baseLatency > 0 ? E.latency / E.baseLatency : E.latency;
+    };
+    std::stable_sort(entries.begin(), entries.end(), [&](const PlanEntry &A, const PlanEntry &B) {
+        bool a = explicitly(A), b = explicitly(B);
+        if (a != b) {
+            return a;
+        }
+        double la = relativeLatency(A), lb = relativeLatency(B);
+        if (la != lb) {
+            return la < lb;
+        }
+        return A.size < B.size;
+    });
+
+    uint64_t allowed = config.text_growth ? moduleSize * config.text_growth / 100 : UINT64_MAX;
+    uint64_t used = 0;
+    // latency_growth 是整个函数的上限，按已选中的 pass 累加
+    std::map<Function *, double> latencyUsed;
+    for (auto &E: entries) {
+        std::string reason;
+        double &latency = latencyUsed[E.F];
+        if (config.latency_growth && (latency + relativeLatency(E)) * 100 > config.latency_growth) {
+            reason = fmt::format("latency budget exceeded, +{:.1f}% on top of +{:.1f}%", relativeLatency(E) * 100,
+                                 latency * 100);
+        } else if (used + E.size > allowed) {
+            reason = fmt::format("text budget exhausted, {}/{}", used, allowed);
+        }
+        if (reason.empty()) {
+            used += E.size;
+            latency += relativeLatency(E);
+        } else {
+            E.selected = false;
+            addAnnotate(*E.F, "no-" + annotationOf(E.pass).str());
+            report->addNote("OverheadPlanner", E.function, E.pass + ": " + reason);
+            IF_VERBOSE {
+                outs() << fmt::format(fmt::fg(fmt::color::yellow),
+                                      "OverheadPlanner: Skip {} for {}: {}\n", E.pass, E.function, reason);
+            }
+        }
+        IF_VERBOSE2 {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "OverheadPlanner: {} {} size +{}/{} latency +{:.1f}/{:.1f}\n",
+                                  E.function, E.pass, E.size, E.baseSize, E.latency, E.baseLatency);
+        }
+        report->addPlan(std::move(E));
+    }
+    IF_VERBOSE {
+        outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                              "OverheadPlanner: predicted text growth {}/{}\n", used, moduleSize);
+    }
+    return PreservedAnalyses::all();
+}
@@ -0,0 +1,162 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/ProfileTier.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/IR/ProfileSummary.h>
+#include <llvm/ProfileData/InstrProf.h>
+#include <llvm/ProfileData/InstrProfReader.h>
+#include <llvm/ProfileData/ProfileCommon.h>
+#include <llvm/ProfileData/SampleProfReader.h>
+
+using namespace llvm;
+
+namespace {
+
+    // 函数热度与两档阈值；热度取函数内最大的计数，与 ProfileSummary 的统计口径（块 / 行计数）一致
+    struct TierProfile {
+        std::string source;
+        uint64_t none = UINT64_MAX;
+        uint64_t light = UINT64_MAX;
+        bool sample = false;
+        StringMap<uint64_t> Counts; // 仅从文件读取时使用
+    };
+
+}
+
+// 覆盖 Cutoff 所需的最小计数；DetailedSummary 只有固定的几个分位，取不小于 Cutoff 的最近一个
+static uint64_t threshold(const SummaryEntryVector &DS, int Cutoff) {
+    if (!Cutoff || DS.empty()) {
+        return UINT64_MAX;
+    }
+    uint64_t Percentile = std::min<uint64_t>(Cutoff, DS.back().Cutoff);
+    return std::max<uint64_t>(ProfileSummaryBuilder::getEntryForPercentile(DS, Percentile).MinCount, 1);
+}
+
+static bool loadProfile(const ObfuscationTier &config, LLVMContext &Ctx, TierProfile &Profile) {
+    auto IndexedReader = IndexedInstrProfReader::create(config.profile);
+    if (IndexedReader) {
+        auto &Reader = *IndexedReader;
+        for (const NamedInstrProfRecord &Record: *Reader) {
+            uint64_t &count = Profile.Counts[Record.Name];
+            for (uint64_t c: Record.Counts) {
+                count = std::max(count, c);
+            }
+        }
+        if (Error E = Reader->getError()) {
+            errs() << fmt::format(fmt::fg(fmt::color::red), "ProfileTier: 无法读取 {}: {}\n",
+                                  config.profile, toString(std::move(E)));
+            return false;
+        }
+        auto &DS = Reader->getSummary(false).getDetailedSummary();
+        Profile.none = threshold(DS, config.none);
+        Profile.light = threshold(DS, config.light);
+        Profile.source = "instr profile " + config.profile;
+        return true;
+    }
+    consumeError(IndexedReader.takeError());
+    auto SampleReader = SampleProfileReader::create(config.profile, Ctx);
+    if (!SampleReader || (*SampleReader)->read()) {
+        errs() << fmt::format(fmt::fg(fmt::color::red),
+                              "ProfileTier: {} 不是 indexed instr profile 或 sample profile\n", config.profile);
+        return false;
+    }
+    auto &Reader = *SampleReader;
+    for (auto &Entry: Reader->getProfiles()) {
+        const FunctionSamples &FS = Entry.second;
+        uint64_t &count = Profile.Counts[FS.getName()];
+        count = std::max({count, FS.getHeadSamples(), FS.getMaxCountInside()});
+    }
+    auto &DS = Reader->getSummary().getDetailedSummary();
+    Profile.none = threshold(DS, config.none);
+    Profile.light = threshold(DS, config.light);
+    Profile.sample = true;
+    Profile.source = "sample profile " + config.profile;
+    return true;
+}
+
+static uint64_t hotness(Function &F, const TierProfile &Profile, bool FromFile, FunctionAnalysisManager &FAM) {
+    if (FromFile) {
+        std::string Name = Profile.sample ? FunctionSamples::getCanonicalFnName(F).str() : getPGOFuncName(F);
+        auto It = Profile.Counts.find(Name);
+        return It == Profile.Counts.end() ? 0 : It->second;
+    }
+    if (!F.getEntryCount()) {
+        return 0;
+    }
+    uint64_t count = F.getEntryCount()->getCount();
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    for (auto &BB: F) {
+        if (auto BlockCount = BFI.getBlockProfileCount(&BB)) {
+            count = std::max(count, *BlockCount);
+        }
+    }
+    return count;
+}
+
+PreservedAnalyses ProfileTier::run(Module &M, ModuleAnalysisManager &MAM) const {
+    ObfuscationTier &config = Options->Tier;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "ProfileTier", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    // 指定了 profile 文件时只读取热度，不修改 IR 中的 profile 信息；否则使用 -fprofile-use 写入的 summary
+    TierProfile Profile;
+    bool FromFile = !config.profile.empty();
+    if (FromFile) {
+        if (!loadProfile(config, M.getContext(), Profile)) {
+            return PreservedAnalyses::all();
+        }
+    } else if (Metadata *MD = M.getProfileSummary(false)) {
+        std::unique_ptr<ProfileSummary> Summary(ProfileSummary::getFromMD(MD));
+        Profile.none = threshold(Summary->getDetailedSummary(), config.none);
+        Profile.light = threshold(Summary->getDetailedSummary(), config.light);
+        Profile.source = "module profile summary";
+    } else {
+        Profile.source = "no profile";
+    }
+
+    size_t count[3] = {};
+    for (auto &F: M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        uint64_t hot = hotness(F, Profile, FromFile, FAM);
+        StringRef Tier = hot >= Profile.none ? "none" : hot >= Profile.light ? "light" : "full";
+        std::string annotate = readAnnotate(&F);
+        for (StringRef Override: {"none", "light", "full"}) {
+            if (annotate.find(("tier-" + Override).str()) != std::string::npos) {
+                Tier = Override;
+            }
+        }
+        writeTier(F, Tier);
+        if (Tier == "none") {
+            addPassAnnotates(F, false);
+            count[0]++;
+        } else if (Tier == "light") {
+            if (!config.flatten && annotate.find("fla") == std::string::npos) {
+                addAnnotate(F, "no-fla");
+            }
+            count[1]++;
+        } else {
+            count[2]++;
+        }
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "ProfileTier: {} (count {}) => {}\n", F.getName().str(), hot, Tier.str());
+        }
+    }
+    report->addNote("ProfileTier", M.getName(),
+                    fmt::format("{}, thresholds none >= {} light >= {}, {} none, {} light, {} full",
+                                Profile.source, Profile.none, Profile.light, count[0], count[1], count[2]));
+    // 档位与注解都是函数属性，不影响分析结果
+    return PreservedAnalyses::all();
+}
@@ -0,0 +1,49 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/ReportWriter.h"
+#include "utils/Overhead.h"
+#include "utils/Report.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+using namespace llvm;
+
+PreservedAnalyses ReportWriter::run(Module &M, ModuleAnalysisManager &MAM) const {
+    if (Options->report.empty()) {
+        report->clear();
+        return PreservedAnalyses::all();
+    }
+    if (std::error_code EC = sys::fs::create_directories(Options->report)) {
+        errs() << fmt::format(fmt::fg(fmt::color::red),
+                              "ReportWriter: 无法创建目录 {}: {}\n", Options->report, EC.message());
+        report->clear();
+        return PreservedAnalyses::all();
+    }
+    // 不同目录下的同名源文件用 module id 的 hash 区分
+    SmallString<128> Path(Options->report);
+    sys::path::append(Path, fmt::format("{}.{:08x}.json",
+                                        sys::path::stem(M.getSourceFileName()).str(),
+                                        ObfuscationReport::moduleId(M)));
+    std::error_code EC;
+    // 计划中的预测值旁边写上混淆后的实际值
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    OverheadEstimator estimator(Options, FAM);
+    report->measure([&](Function &F) { return estimator.size(F); });
+    raw_fd_ostream OS(Path, EC, sys::fs::OF_Text);
+    if (EC) {
+        errs() << fmt::format(fmt::fg(fmt::color::red),
+                              "ReportWriter: 无法写入 {}: {}\n", Path.str().str(), EC.message());
+    } else {
+        report->write(OS, M, Options);
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "ReportWriter: {}\n", Path.str().str());
+        }
+    }
+    report->clear();
+    return PreservedAnalyses::all();
+}
@@ -0,0 +1,111 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/RuntimeProfile.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/ADT/SetVector.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+
+using namespace llvm;
+
+// 静态 alloca 集中到入口块开头，返回其后第一条指令，拆分入口块后它们仍留在入口块
+static Instruction *hoistStaticAllocas(BasicBlock &Entry) {
+    Instruction *First = nullptr;
+    for (Instruction &I: make_early_inc_range(Entry)) {
+        auto *AI = dyn_cast<AllocaInst>(&I);
+        if (!AI || !AI->isStaticAlloca()) {
+            if (!First) {
+                First = &I;
+            }
+        } else if (First) {
+            AI->moveBefore(First);
+        }
+    }
+    return First;
+}
+
+PreservedAnalyses RuntimeProfile::run(Module &M, ModuleAnalysisManager &) const {
+    if (!Options->rt_profile) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "RuntimeProfile", M);
+    SetVector<Function *> Targets;
+    for (auto &G: report->getGenerated()) {
+        if (!G.F->isDeclaration() && !G.F->hasFnAttribute(Attribute::Naked)) {
+            Targets.insert(G.F);
+        }
+    }
+    if (Targets.empty()) {
+        return PreservedAnalyses::all();
+    }
+
+    LLVMContext &Ctx = M.getContext();
+    IntegerType *I32Ty = Type::getInt32Ty(Ctx);
+    IntegerType *I64Ty = Type::getInt64Ty(Ctx);
+    // 每行补齐到 8 个计数器即 64 字节，不同线程的行不共享 cache line
+    uint64_t Stride = alignTo(Targets.size(), 8);
+    ArrayType *TableTy = ArrayType::get(ArrayType::get(I64Ty, Stride), Slots);
+    auto *Table = new GlobalVariable(M, TableTy, false, GlobalValue::InternalLinkage,
+                                     ConstantAggregateZero::get(TableTy), "buer.prof.counters");
+    Table->setAlignment(Align(64));
+    auto *Slot = M.getNamedGlobal("__buer_rt_v1_prof_slot");
+    if (!Slot) {
+        Slot = new GlobalVariable(M, I32Ty, false, GlobalValue::ExternalLinkage, nullptr, "__buer_rt_v1_prof_slot",
+                                  nullptr, GlobalValue::InitialExecTLSModel);
+        Slot->setVisibility(GlobalValue::HiddenVisibility);
+        Slot->setDSOLocal(true);
+    }
+    Function *Thread = getRuntimeFunction(M, "__buer_rt_v1_prof_thread", FunctionType::get(I32Ty, false));
+    MDNode *Unlikely = MDBuilder(Ctx).createBranchWeights(1, (1u << 20) - 1);
+
+    for (unsigned Index = 0; Index < Targets.size(); Index++) {
+        Function *F = Targets[Index];
+        Instruction *SplitBefore = hoistStaticAllocas(F->getEntryBlock());
+        IRBuilder<> IRB(SplitBefore);
+        LoadInst *Current = IRB.CreateLoad(I32Ty, Slot);
+        // 线程第一次进入时分配行
+        Instruction *Assign = SplitBlockAndInsertIfThen(IRB.CreateICmpEQ(Current, IRB.getInt32(0)), SplitBefore,
+                                                        false, Unlikely);
+        IRB.SetInsertPoint(Assign);
+        CallInst *Assigned = IRB.CreateCall(Thread);
+        IRB.SetInsertPoint(SplitBefore);
+        PHINode *Row = IRB.CreatePHI(I32Ty, 2);
+        Row->addIncoming(Current, Current->getParent());
+        Row->addIncoming(Assigned, Assigned->getParent());
+        Value *Ptr = IRB.CreateInBoundsGEP(TableTy, Table,
+                                           {IRB.getInt64(0), IRB.CreateZExt(IRB.CreateSub(Row, IRB.getInt32(1)), I64Ty),
+                                            IRB.getInt64(Index)});
+        // 行归当前线程所有，不需要原子加；monotonic 只为了与析构时的读取不构成数据竞争，仍是普通的 load / store
+        LoadInst *Old = IRB.CreateAlignedLoad(I64Ty, Ptr, Align(8));
+        Old->setAtomic(AtomicOrdering::Monotonic);
+        StoreInst *New = IRB.CreateAlignedStore(IRB.CreateAdd(Old, IRB.getInt64(1)), Ptr, Align(8));
+        New->setAtomic(AtomicOrdering::Monotonic);
+        report->addCounter(F, Index);
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "RuntimeProfile: {} => counter {}\n", F->getName().str(), Index);
+        }
+    }
+
+    Function *Dump = Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false),
+                                      GlobalValue::PrivateLinkage, "buer.prof.dump", M);
+    Dump->addFnAttr(Attribute::NoUnwind);
+    Dump->addFnAttr(Attribute::Cold);
+    IRBuilder<> IRB(BasicBlock::Create(Ctx, "entry", Dump));
+    FunctionType *FTy = FunctionType::get(Type::getVoidTy(Ctx), {I32Ty, I64Ty->getPointerTo(), I32Ty, I32Ty}, false);
+    IRB.CreateCall(getRuntimeFunction(M, "__buer_rt_v1_prof_dump", FTy),
+                   {IRB.getInt32(ObfuscationReport::moduleId(M)), IRB.CreateBitCast(Table, I64Ty->getPointerTo()),
+                    IRB.getInt32(Targets.size()), IRB.getInt32(Stride)});
+    IRB.CreateRetVoid();
+    appendToGlobalDtors(M, Dump, 65535);
+    report->addNote("RuntimeProfile", M.getName(),
+                    fmt::format("{} counters, {} KiB table", Targets.size(), Slots * Stride * 8 / 1024));
+    return PreservedAnalyses::none();
+}
@@ -0,0 +1,210 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/StackLayout.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/CaptureTracking.h>
+#include <llvm/IR/DIBuilder.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+static const uint64_t CacheLine = 64;
+
+// 填充以 8 字节为单位，单个槽位前最多 4 个单位
+static const uint64_t PadUnit = 8;
+
+struct Slot {
+    AllocaInst *AI;
+    uint64_t size;
+    double count;
+    bool escapes; // 地址被捕获（传给调用、存入内存、返回），只有这类槽位的填充会留在栈帧中
+};
+
+// 可以移动和加填充的 alloca：localescape 按值引用 alloca，不能替换为 GEP
+static bool isCandidate(AllocaInst &AI) {
+    if (!AI.isStaticAlloca() || AI.isSwiftError() || AI.isUsedWithInAlloca() ||
+        isa<ScalableVectorType>(AI.getAllocatedType())) {
+        return false;
+    }
+    for (User *U: AI.users()) {
+        auto *II = dyn_cast<IntrinsicInst>(U);
+        if (II && II->getIntrinsicID() == Intrinsic::localescape) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 经过 GEP / 类型转换的访问按所在块相对入口的频率累计，lifetime 与调试信息不计入
+static double accessCount(Value *V, BlockFrequencyInfo &BFI, double entry) {
+    double count = 0;
+    for (User *U: V->users()) {
+        auto *I = dyn_cast<Instruction>(U);
+        if (!I || isa<DbgInfoIntrinsic>(I) || I->isLifetimeStartOrEnd()) {
+            continue;
+        }
+        if (isa<GetElementPtrInst>(I) || isa<BitCastInst>(I) || isa<AddrSpaceCastInst>(I)) {
+            count += accessCount(I, BFI, entry);
+        } else {
+            count += (double) BFI.getBlockFreq(I->getParent()).getFrequency() / entry;
+        }
+    }
+    return count;
+}
+
+// 槽位的类型，数组分配换成数组类型
+static Type *slotType(AllocaInst *AI) {
+    Type *SlotTy = AI->getAllocatedType();
+    if (AI->isArrayAllocation()) {
+        SlotTy = ArrayType::get(SlotTy, cast<ConstantInt>(AI->getArraySize())->getZExtValue());
+    }
+    return SlotTy;
+}
+
+// 填充后槽位相对新 alloca 的偏移：T 放在 alignTo(Pad, T 的对齐) 处，alloca 上更大的对齐也要保持，
+// 所以按两者中较大的对齐向上取整，得到的值就是实际占用的栈空间
+static uint64_t padOffset(AllocaInst *AI, uint64_t Pad, const DataLayout &DL) {
+    return alignTo(Pad, std::max(AI->getAlign(), DL.getABITypeAlign(slotType(AI))));
+}
+
+// 把 AI 换成 { [Pad x i8], T } 的第二个字段，地址逃逸时 SROA 不会拆开，填充保留在栈帧中；Pad 须由 padOffset 对齐
+static AllocaInst *padSlot(AllocaInst *AI, uint64_t Pad, const DataLayout &DL, DIBuilder &DIB) {
+    LLVMContext &Ctx = AI->getContext();
+    Type *SlotTy = slotType(AI);
+    StructType *Ty = StructType::get(Ctx, {ArrayType::get(Type::getInt8Ty(Ctx), Pad), SlotTy});
+    auto *NewAI = new AllocaInst(Ty, AI->getType()->getAddressSpace(), nullptr, AI->getAlign(),
+                                 AI->getName() + ".pad", AI);
+    Value *Idx[] = {ConstantInt::get(Type::getInt32Ty(Ctx), 0), ConstantInt::get(Type::getInt32Ty(Ctx), 1)};
+    Instruction *Ptr = GetElementPtrInst::CreateInBounds(Ty, NewAI, Idx, "", AI);
+    if (Ptr->getType() != AI->getType()) {
+        Ptr = new BitCastInst(Ptr, AI->getType(), "", AI);
+    }
+    Ptr->takeName(AI);
+    // 调试信息中的位置加上字段偏移
+    replaceDbgDeclare(AI, NewAI, DIB, DIExpression::ApplyOffset,
+                      (int) DL.getStructLayout(Ty)->getElementOffset(1));
+    AI->replaceAllUsesWith(Ptr);
+    AI->eraseFromParent();
+    return NewAI;
+}
+
+PreservedAnalyses StackLayout::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassStackLayout &config = Options->StackLayout;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "StackLayout", M);
+    BudgetTracker budget(Options, "StackLayout", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    const DataLayout &DL = M.getDataLayout();
+    DIBuilder DIB(M, false);
+    bool changed = false;
+    for (auto &F: M) {
+        if (!toObfuscate(config.enable, &F, "sl") || F.hasFnAttribute(Attribute::Naked)) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "StackLayout: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        budget.startFunction();
+        auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+        double entry = (double) BFI.getEntryFreq();
+        BasicBlock &Entry = F.getEntryBlock();
+        vector<Slot> Slots;
+        for (auto &I: Entry) {
+            auto *AI = dyn_cast<AllocaInst>(&I);
+            if (AI && isCandidate(*AI)) {
+                uint64_t size = AI->getAllocationSizeInBits(DL)->getFixedSize() / 8;
+                Slots.push_back({AI, size, accessCount(AI, BFI, entry), PointerMayBeCaptured(AI, true, true)});
+            }
+        }
+        if (Slots.size() < 2) {
+            continue;
+        }
+
+        // 按 访问次数 / 大小 从高到低挑选热槽位，直到填满第一条 cache line；放不下的槽位跳过，继续尝试更小的
+        std::stable_sort(Slots.begin(), Slots.end(), [](const Slot &A, const Slot &B) {
+            return A.count * (double) std::max<uint64_t>(B.size, 1) > B.count * (double) std::max<uint64_t>(A.size, 1);
+        });
+        vector<Slot> Hot, Cold;
+        uint64_t hotBytes = 0;
+        for (Slot &S: Slots) {
+            uint64_t aligned = alignTo(hotBytes, S.AI->getAlign()) + S.size;
+            if (S.count > 0 && aligned <= CacheLine) {
+                Hot.push_back(S);
+                hotBytes = aligned;
+            } else {
+                Cold.push_back(S);
+            }
+        }
+        for (vector<Slot> *Tier: {&Hot, &Cold}) {
+            for (size_t i = Tier->size(); i > 1; i--) {
+                std::swap((*Tier)[i - 1], (*Tier)[crypto->get_range(i)]);
+            }
+        }
+
+        // 热槽位之间不加填充；地址逃逸的冷槽位随机选一半在前面加填充，总量不超过 padding，每个填充新增一条 GEP。
+        // 不逃逸的槽位会被 SROA 提升为寄存器，填充随之消失，加了只会多一条 GEP
+        uint64_t padded = 0, padding = 0;
+        uint64_t allowed = budget.remaining(F);
+        for (Slot &S: Cold) {
+            uint64_t left = (uint64_t) config.padding - padding;
+            if (left < PadUnit || padded >= allowed) {
+                break;
+            }
+            if (!S.escapes || !crypto->get_range(2)) {
+                continue;
+            }
+            // 对齐到 16 字节及以上的槽位实际填充可能大于请求的量，放不下时跳过
+            uint64_t pad = padOffset(S.AI, std::min<uint64_t>(PadUnit * (1 + crypto->get_range(4)),
+                                                              left / PadUnit * PadUnit), DL);
+            if (pad > left) {
+                continue;
+            }
+            S.AI = padSlot(S.AI, pad, DL, DIB);
+            padding += DL.getStructLayout(cast<StructType>(S.AI->getAllocatedType()))->getElementOffset(1);
+            padded++;
+        }
+        if (padded < Cold.size() && padded >= allowed && config.padding > 0) {
+            budget.degrade(F, fmt::format("growth budget exceeded, {} slots padded", padded));
+        }
+        budget.charge(F, padded);
+
+        // 入口块中 alloca 的顺序就是栈对象的编号顺序，PEI 按编号从栈帧基址开始分配偏移，
+        // 热槽位放在最前面即落在基址附近，偏移可以用短编码
+        vector<Slot> Order = Hot;
+        Order.insert(Order.end(), Cold.begin(), Cold.end());
+        for (auto It = Order.rbegin(); It != Order.rend(); ++It) {
+            if (&Entry.front() != It->AI) {
+                It->AI->moveBefore(&Entry.front());
+            }
+        }
+        changed = true;
+
+        report->addNote("StackLayout", F.getName(),
+                        fmt::format("{} slots, {} hot ({} bytes), padding {}/{} bytes", Order.size(), Hot.size(),
+                                    hotBytes, padding, config.padding));
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "StackLayout: {} ({} slots, {} hot, padding {})\n",
+                                  F.getName().str(), Order.size(), Hot.size(), padding);
+        }
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
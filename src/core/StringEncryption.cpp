@@ -0,0 +1,447 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/StringEncryption.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/CaptureTracking.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/BuildLibCalls.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+namespace {
+
+    enum StringEncryptionMode {
+        ModeLazy = 0,
+        ModeEager = 1,
+        ModeStack = 2,
+    };
+
+    struct EncryptedString {
+        GlobalVariable *GV;
+        GlobalVariable *Key;
+        uint64_t length;
+        uint8_t delta;
+    };
+
+} // namespace
+
+void StringEncryption::encrypt(std::vector<uint8_t> &data, const uint8_t key[16], uint8_t delta) {
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] ^= (uint8_t) (key[i % 16] + (i / 16) * delta);
+    }
+}
+
+Function *StringEncryption::getDecryptFunction(Module &M, bool Runtime) {
+    const char *name = "buer.se.decrypt";
+    if (Function *F = M.getFunction(name)) {
+        return F;
+    }
+    LLVMContext &Ctx = M.getContext();
+    Type *I8Ty = Type::getInt8Ty(Ctx);
+    Type *I8PtrTy = Type::getInt8PtrTy(Ctx);
+    Type *I64Ty = Type::getInt64Ty(Ctx);
+    auto *VecTy = FixedVectorType::get(I8Ty, 16);
+    FunctionType *FTy = FunctionType::get(Type::getVoidTy(Ctx), {I8PtrTy, I8PtrTy, I64Ty, I8PtrTy, I8Ty}, false);
+    if (Runtime) {
+        return getRuntimeFunction(M, "__buer_rt_v1_decrypt", FTy);
+    }
+    Function *F = Function::Create(FTy, GlobalValue::PrivateLinkage, name, M);
+    F->addFnAttr(Attribute::NoUnwind);
+    F->addFnAttr(Attribute::NoInline);
+    auto arg = F->arg_begin();
+    Value *Dst = arg++, *Src = arg++, *Len = arg++, *Key = arg++, *Delta = arg;
+
+    BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", F);
+    BasicBlock *VecCond = BasicBlock::Create(Ctx, "vec.cond", F);
+    BasicBlock *VecBody = BasicBlock::Create(Ctx, "vec.body", F);
+    BasicBlock *TailCond = BasicBlock::Create(Ctx, "tail.cond", F);
+    BasicBlock *TailBody = BasicBlock::Create(Ctx, "tail.body", F);
+    BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", F);
+
+    // 16 字节一块，xor / add 在 x86 上是 pxor / paddb，在 arm 上是 veor / vadd
+    IRBuilder<> IRB(Entry);
+    Value *K0 = IRB.CreateAlignedLoad(VecTy, IRB.CreateBitCast(Key, VecTy->getPointerTo()), Align(1));
+    Value *DeltaVec = IRB.CreateVectorSplat(16, Delta);
+    Value *Blocks = IRB.CreateLShr(Len, 4);
+    IRB.CreateBr(VecCond);
+
+    IRB.SetInsertPoint(VecCond);
+    PHINode *I = IRB.CreatePHI(I64Ty, 2);
+    PHINode *KS = IRB.CreatePHI(VecTy, 2);
+    IRB.CreateCondBr(IRB.CreateICmpULT(I, Blocks), VecBody, TailCond);
+
+    IRB.SetInsertPoint(VecBody);
+    Value *Off = IRB.CreateShl(I, 4);
+    Value *SrcVec = IRB.CreateBitCast(IRB.CreateGEP(I8Ty, Src, Off), VecTy->getPointerTo());
+    Value *DstVec = IRB.CreateBitCast(IRB.CreateGEP(I8Ty, Dst, Off), VecTy->getPointerTo());
+    Value *Plain = IRB.CreateXor(IRB.CreateAlignedLoad(VecTy, SrcVec, Align(1)), KS);
+    IRB.CreateAlignedStore(Plain, DstVec, Align(1));
+    Value *NextKS = IRB.CreateAdd(KS, DeltaVec);
+    Value *NextI = IRB.CreateAdd(I, ConstantInt::get(I64Ty, 1));
+    IRB.CreateBr(VecCond);
+    I->addIncoming(ConstantInt::get(I64Ty, 0), Entry);
+    I->addIncoming(NextI, VecBody);
+    KS->addIncoming(K0, Entry);
+    KS->addIncoming(NextKS, VecBody);
+
+    // 剩余不足 16 字节的部分逐字节处理，密钥流仍取当前块的 KS
+    IRB.SetInsertPoint(TailCond);
+    PHINode *J = IRB.CreatePHI(I64Ty, 2);
+    IRB.CreateCondBr(IRB.CreateICmpULT(J, Len), TailBody, Exit);
+
+    IRB.SetInsertPoint(TailBody);
+    Value *KB = IRB.CreateExtractElement(KS, IRB.CreateAnd(J, ConstantInt::get(I64Ty, 15)));
+    Value *SrcByte = IRB.CreateLoad(I8Ty, IRB.CreateGEP(I8Ty, Src, J));
+    IRB.CreateStore(IRB.CreateXor(SrcByte, KB), IRB.CreateGEP(I8Ty, Dst, J));
+    Value *NextJ = IRB.CreateAdd(J, ConstantInt::get(I64Ty, 1));
+    IRB.CreateBr(TailCond);
+    J->addIncoming(IRB.CreateShl(Blocks, 4), VecCond);
+    J->addIncoming(NextJ, TailBody);
+    cast<Instruction>(J->getIncomingValue(0))->moveBefore(VecCond->getTerminator());
+
+    IRB.SetInsertPoint(Exit);
+    IRB.CreateRetVoid();
+    return F;
+}
+
+// void (i32* guard, i8* data, i64 len, i8* key, i8 delta)
+// guard: 0 未解密，1 正在解密，2 已解密
+static Function *getOnceFunction(Module &M, bool Runtime) {
+    const char *name = "buer.se.once";
+    if (Function *F = M.getFunction(name)) {
+        return F;
+    }
+    LLVMContext &Ctx = M.getContext();
+    Type *I8Ty = Type::getInt8Ty(Ctx);
+    Type *I8PtrTy = Type::getInt8PtrTy(Ctx);
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    Type *I64Ty = Type::getInt64Ty(Ctx);
+    FunctionType *FTy = FunctionType::get(Type::getVoidTy(Ctx),
+                                          {I32Ty->getPointerTo(), I8PtrTy, I64Ty, I8PtrTy, I8Ty}, false);
+    if (Runtime) {
+        return getRuntimeFunction(M, "__buer_rt_v1_once", FTy);
+    }
+    Function *F = Function::Create(FTy, GlobalValue::PrivateLinkage, name, M);
+    F->addFnAttr(Attribute::NoUnwind);
+    F->addFnAttr(Attribute::NoInline);
+    F->addFnAttr(Attribute::Cold);
+    auto arg = F->arg_begin();
+    Value *Guard = arg++, *Data = arg++, *Len = arg++, *Key = arg++, *Delta = arg;
+
+    BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", F);
+    BasicBlock *Decrypt = BasicBlock::Create(Ctx, "decrypt", F);
+    BasicBlock *Wait = BasicBlock::Create(Ctx, "wait", F);
+    BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", F);
+
+    IRBuilder<> IRB(Entry);
+    Value *Pair = IRB.CreateAtomicCmpXchg(Guard, ConstantInt::get(I32Ty, 0), ConstantInt::get(I32Ty, 1),
+                                          MaybeAlign(4), AtomicOrdering::AcquireRelease,
+                                          AtomicOrdering::Acquire);
+    IRB.CreateCondBr(IRB.CreateExtractValue(Pair, 1), Decrypt, Wait);
+
+    IRB.SetInsertPoint(Decrypt);
+    IRB.CreateCall(StringEncryption::getDecryptFunction(M), {Data, Data, Len, Key, Delta});
+    IRB.CreateAlignedStore(ConstantInt::get(I32Ty, 2), Guard, Align(4))->setAtomic(AtomicOrdering::Release);
+    IRB.CreateRetVoid();
+
+    // 其他线程正在解密，等待完成
+    IRB.SetInsertPoint(Wait);
+    LoadInst *State = IRB.CreateAlignedLoad(I32Ty, Guard, Align(4));
+    State->setAtomic(AtomicOrdering::Acquire);
+    IRB.CreateCondBr(IRB.CreateICmpEQ(State, ConstantInt::get(I32Ty, 2)), Exit, Wait);
+
+    IRB.SetInsertPoint(Exit);
+    IRB.CreateRetVoid();
+    return F;
+}
+
+// 只加密整数数组形式的私有常量字符串
+static bool isCandidate(GlobalVariable &GV) {
+    if (!GV.isConstant() || !GV.hasInitializer() || !GV.hasLocalLinkage() || GV.isThreadLocal()) {
+        return false;
+    }
+    if (GV.getName().startswith("llvm.") || GV.hasSection()) {
+        return false;
+    }
+    auto *CDS = dyn_cast<ConstantDataArray>(GV.getInitializer());
+    return CDS && CDS->getElementType()->isIntegerTy() && CDS->getNumElements() > 0;
+}
+
+// 收集 C 的所有指令使用者（穿过 ConstantExpr），遇到无法处理的使用者返回 false
+static bool collectUses(Constant *C, bool AllowGlobalUsers, vector<Use *> &Uses,
+                        const std::function<bool(Function *)> &Eligible) {
+    for (auto &U: C->uses()) {
+        User *Usr = U.getUser();
+        if (auto *I = dyn_cast<Instruction>(Usr)) {
+            if (isa<PHINode>(I) || isa<LandingPadInst>(I) || !Eligible(I->getFunction())) {
+                return false;
+            }
+            Uses.push_back(&U);
+        } else if (auto *CE = dyn_cast<ConstantExpr>(Usr)) {
+            if (!collectUses(CE, AllowGlobalUsers, Uses, Eligible)) {
+                return false;
+            }
+        } else if (!AllowGlobalUsers) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 把依赖 GV 的常量表达式在 At 之前展开为指令，并将 GV 替换为 Replacement
+static Value *materialize(Constant *C, GlobalVariable *GV, Value *Replacement, Instruction *At) {
+    if (C == GV) {
+        return Replacement;
+    }
+    auto *CE = cast<ConstantExpr>(C);
+    Instruction *NewInst = CE->getAsInstruction();
+    for (unsigned i = 0; i < NewInst->getNumOperands(); i++) {
+        auto *Op = dyn_cast<Constant>(NewInst->getOperand(i));
+        if (Op && (Op == GV || isa<ConstantExpr>(Op))) {
+            NewInst->setOperand(i, materialize(Op, GV, Replacement, At));
+        }
+    }
+    NewInst->insertBefore(At);
+    return NewInst;
+}
+
+// CaptureTracking 把 volatile / atomic load 也算作捕获，这里只关心指针是否活过当前栈帧
+namespace {
+    struct StackEscapeTracker : public CaptureTracker {
+        bool Escaped = false;
+
+        void tooManyUses() override {
+            Escaped = true;
+        }
+
+        bool captured(const Use *U) override {
+            if (isa<LoadInst>(U->getUser())) {
+                return false;
+            }
+            Escaped = true;
+            return true;
+        }
+    };
+}
+
+// 栈模式下指针不能逃逸出函数：返回、存入内存、传给可能保存它的函数，或者经 GEP / select / phi 等派生后再逃逸
+// pass 在 InferFunctionAttrs 之前运行，库函数声明上还没有 nocapture，先按 TargetLibraryInfo 补上
+static bool escapes(const vector<Use *> &Uses, function_ref<const TargetLibraryInfo &(Function &)> GetTLI) {
+    for (Use *U: Uses) {
+        auto *I = cast<Instruction>(U->getUser());
+        if (auto *CB = dyn_cast<CallBase>(I)) {
+            if (!CB->isArgOperand(U)) {
+                return true;
+            }
+            Function *Callee = CB->getCalledFunction();
+            LibFunc LF;
+            if (Callee && Callee->isDeclaration() &&
+                GetTLI(*CB->getFunction()).getLibFunc(*Callee, LF)) {
+                inferLibFuncAttributes(*Callee, GetTLI(*CB->getFunction()));
+            }
+            if (!CB->doesNotCapture(CB->getArgOperandNo(U))) {
+                return true;
+            }
+            continue;
+        }
+        if (auto *SI = dyn_cast<StoreInst>(I)) {
+            if (SI->getValueOperand() == U->get()) {
+                return true;
+            }
+            continue;
+        }
+        if (isa<LoadInst>(I) || isa<CmpInst>(I)) {
+            continue;
+        }
+        // 其余使用者（GEP、bitcast、select、ret 等）的结果按指针继续追踪，ptrtoint 之类无法追踪的一律视为逃逸
+        if (isa<ReturnInst>(I) || !I->getType()->isPointerTy()) {
+            return true;
+        }
+        StackEscapeTracker Tracker;
+        PointerMayBeCaptured(I, &Tracker);
+        if (Tracker.Escaped) {
+            return true;
+        }
+    }
+    return false;
+}
+
+PreservedAnalyses StringEncryption::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassStringEncryption &config = Options->StringEncryption;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "StringEncryption", M);
+    LLVMContext &Ctx = M.getContext();
+    Type *I8PtrTy = Type::getInt8PtrTy(Ctx);
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    Type *I64Ty = Type::getInt64Ty(Ctx);
+
+    std::map<Function *, bool> eligibleCache;
+    auto Eligible = [&](Function *F) {
+        auto it = eligibleCache.find(F);
+        if (it != eligibleCache.end()) {
+            return it->second;
+        }
+        bool result = toObfuscate(config.enable, F, "se");
+        IF_VERBOSE2 {
+            if (!result) {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "StringEncryption: Ignore {}\n", F->getName().str());
+            }
+        }
+        return eligibleCache[F] = result;
+    };
+
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    auto GetTLI = [&FAM](Function &F) -> const TargetLibraryInfo & {
+        return FAM.getResult<TargetLibraryAnalysis>(F);
+    };
+
+    vector<std::pair<EncryptedString, vector<Use *>>> Strings;
+    for (auto &GV: M.globals()) {
+        if (!isCandidate(GV)) {
+            continue;
+        }
+        vector<Use *> Uses;
+        if (!collectUses(&GV, config.mode == ModeEager, Uses, Eligible) || Uses.empty()) {
+            continue;
+        }
+        if (config.mode == ModeStack && escapes(Uses, GetTLI)) {
+            continue;
+        }
+        auto *CDS = cast<ConstantDataSequential>(GV.getInitializer());
+        StringRef raw = CDS->getRawDataValues();
+        std::vector<uint8_t> data(raw.bytes_begin(), raw.bytes_end());
+        uint8_t key[16];
+        crypto->get_bytes((char *) key, 16);
+        uint8_t delta = crypto->get_uint8_t() | 1;
+        encrypt(data, key, delta);
+
+        auto *KeyGV = new GlobalVariable(M, ArrayType::get(Type::getInt8Ty(Ctx), 16), true,
+                                         GlobalValue::PrivateLinkage,
+                                         ConstantDataArray::get(Ctx, makeArrayRef(key, 16)),
+                                         GV.getName() + ".key");
+        Constant *Cipher = ConstantDataArray::getRaw(
+                StringRef((const char *) data.data(), data.size()), CDS->getNumElements(), CDS->getElementType());
+        GV.setInitializer(Cipher);
+        if (config.mode != ModeStack) {
+            GV.setConstant(false); // 原地解密
+        }
+        Strings.push_back({{&GV, KeyGV, data.size(), delta}, std::move(Uses)});
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "StringEncryption: {} ({} bytes)\n", GV.getName().str(), data.size());
+        }
+    }
+    if (Strings.empty()) {
+        return PreservedAnalyses::all();
+    }
+
+    auto Args = [&](IRBuilder<> &IRB, const EncryptedString &S) {
+        return std::make_tuple(IRB.CreateBitCast(S.GV, I8PtrTy), ConstantInt::get(I64Ty, S.length),
+                               IRB.CreateBitCast(S.Key, I8PtrTy), ConstantInt::get(Type::getInt8Ty(Ctx), S.delta));
+    };
+
+    if (config.mode == ModeEager) {
+        Function *Decrypt = getDecryptFunction(M, Options->runtime);
+        Function *Init = Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false),
+                                          GlobalValue::PrivateLinkage, "buer.se.init", M);
+        IRBuilder<> IRB(BasicBlock::Create(Ctx, "entry", Init));
+        for (auto &S: Strings) {
+            Value *Data, *Len, *Key, *Delta;
+            std::tie(Data, Len, Key, Delta) = Args(IRB, S.first);
+            IRB.CreateCall(Decrypt, {Data, Data, Len, Key, Delta});
+        }
+        IRB.CreateRetVoid();
+        appendToGlobalCtors(M, Init, 0);
+        report->addGenerated("StringEncryption", Init, nullptr);
+    } else if (config.mode == ModeLazy) {
+        Function *Once = getOnceFunction(M, Options->runtime);
+        MDNode *Unlikely = MDBuilder(Ctx).createBranchWeights(1, (1U << 20) - 1);
+        for (auto &S: Strings) {
+            auto *Guard = new GlobalVariable(M, I32Ty, false, GlobalValue::PrivateLinkage,
+                                             ConstantInt::get(I32Ty, 0), S.first.GV->getName() + ".guard");
+            Guard->setAlignment(Align(4));
+            // 同一个基本块内只在第一次使用前检查
+            std::set<BasicBlock *> Guarded;
+            vector<Instruction *> Points;
+            for (Use *U: S.second) {
+                auto *I = cast<Instruction>(U->getUser());
+                if (Guarded.insert(I->getParent()).second) {
+                    Points.push_back(I);
+                }
+            }
+            SmallPtrSet<User *, 16> Users;
+            for (Use *U: S.second) {
+                Users.insert(U->getUser());
+            }
+            for (Instruction *I: Points) {
+                // 移到块内第一个使用者之前
+                for (Instruction &Prev: *I->getParent()) {
+                    if (Users.count(&Prev)) {
+                        I = &Prev;
+                        break;
+                    }
+                }
+                IRBuilder<> IRB(I);
+                LoadInst *State = IRB.CreateAlignedLoad(I32Ty, Guard, Align(4));
+                State->setAtomic(AtomicOrdering::Acquire);
+                Value *Pending = IRB.CreateICmpNE(State, ConstantInt::get(I32Ty, 2));
+                Instruction *Then = SplitBlockAndInsertIfThen(Pending, I, false, Unlikely);
+                IRB.SetInsertPoint(Then);
+                Value *Data, *Len, *Key, *Delta;
+                std::tie(Data, Len, Key, Delta) = Args(IRB, S.first);
+                IRB.CreateCall(Once, {Guard, Data, Len, Key, Delta});
+            }
+        }
+        if (!Once->isDeclaration()) {
+            report->addGenerated("StringEncryption", Once, nullptr);
+        }
+    } else {
+        Function *Decrypt = getDecryptFunction(M, Options->runtime);
+        // 每个函数在入口处把用到的字符串解密到栈上
+        std::map<Function *, std::map<GlobalVariable *, Value *>> Buffers;
+        for (auto &S: Strings) {
+            GlobalVariable *GV = S.first.GV;
+            for (Use *U: S.second) {
+                auto *I = cast<Instruction>(U->getUser());
+                Function *F = I->getFunction();
+                Value *&Buffer = Buffers[F][GV];
+                if (!Buffer) {
+                    IRBuilder<> IRB(&*F->getEntryBlock().getFirstInsertionPt());
+                    AllocaInst *AI = IRB.CreateAlloca(GV->getValueType(), nullptr, GV->getName() + ".stack");
+                    AI->setAlignment(GV->getAlign().valueOrOne());
+                    Buffer = AI;
+                    Value *Data, *Len, *Key, *Delta;
+                    std::tie(Data, Len, Key, Delta) = Args(IRB, S.first);
+                    IRB.CreateCall(Decrypt, {IRB.CreateBitCast(AI, I8PtrTy), Data, Len, Key, Delta});
+                }
+            }
+            for (Use *U: S.second) {
+                auto *I = cast<Instruction>(U->getUser());
+                U->set(materialize(cast<Constant>(U->get()), GV, Buffers[I->getFunction()][GV], I));
+            }
+            GV->removeDeadConstantUsers();
+        }
+    }
+    if (Function *Decrypt = M.getFunction("buer.se.decrypt")) {
+        report->addGenerated("StringEncryption", Decrypt, nullptr);
+    }
+    return PreservedAnalyses::none();
+}
@@ -0,0 +1,736 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/StructReorder.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Operator.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+// 新字段顺序：NewIndex[旧下标] = 新下标
+typedef vector<unsigned> Permutation;
+
+static const uint64_t CacheLine = 64;
+
+// 布局会被外部观察到的结构体（Escaped），以及大小必须保持不变的结构体（Locked）
+class LayoutAnalysis {
+public:
+    std::set<StructType *> Escaped;
+    std::set<StructType *> Locked;
+
+    // Ty 中出现的所有结构体（包括经过指针、数组、函数类型）都不能重排
+    void escape(Type *Ty) {
+        if (!Seen.insert(Ty).second) {
+            return;
+        }
+        if (auto *ST = dyn_cast<StructType>(Ty)) {
+            Escaped.insert(ST);
+        }
+        for (Type *Sub: Ty->subtypes()) {
+            escape(Sub);
+        }
+    }
+
+    // Ty 及按值包含的结构体大小不能改变
+    void lock(Type *Ty) {
+        if (auto *ST = dyn_cast<StructType>(Ty)) {
+            if (!Locked.insert(ST).second) {
+                return;
+            }
+        }
+        if (Ty->isStructTy() || Ty->isArrayTy() || Ty->isVectorTy()) {
+            for (Type *Sub: Ty->subtypes()) {
+                lock(Sub);
+            }
+        }
+    }
+
+    void scanModule(Module &M) {
+        for (auto &GV: M.globals()) {
+            if (!GV.hasLocalLinkage()) {
+                escape(GV.getValueType());
+            }
+            if (GV.hasInitializer()) {
+                scanConstant(GV.getInitializer());
+            }
+        }
+        for (auto &GA: M.aliases()) {
+            escape(GA.getValueType());
+        }
+        for (auto &GI: M.ifuncs()) {
+            escape(GI.getValueType());
+        }
+        for (auto &F: M) {
+            if (!F.hasLocalLinkage() || F.isDeclaration()) {
+                escape(F.getFunctionType());
+            }
+            scanAttributes(F.getAttributes(), F.getFunctionType());
+            for (auto &BB: F) {
+                for (auto &I: BB) {
+                    scanInstruction(I);
+                }
+            }
+        }
+    }
+
+private:
+    std::set<Type *> Seen;
+    std::set<Constant *> SeenConstants;
+
+    // 带类型的参数属性无法随类型一起改写；dereferenceable 记录的是旧大小
+    void scanAttributes(AttributeList AL, FunctionType *FT) {
+        static const Attribute::AttrKind TypeAttrs[] = {
+                Attribute::ByVal, Attribute::StructRet, Attribute::ByRef,
+                Attribute::Preallocated, Attribute::InAlloca, Attribute::ElementType,
+        };
+        for (unsigned i = 0; i < FT->getNumParams(); i++) {
+            for (Attribute::AttrKind Kind: TypeAttrs) {
+                if (Type *Ty = AL.getParamAttr(i, Kind).getValueAsType()) {
+                    escape(Ty);
+                }
+            }
+            if (AL.getParamDereferenceableBytes(i) || AL.getParamDereferenceableOrNullBytes(i)) {
+                lockPointee(FT->getParamType(i));
+            }
+        }
+        if (AL.getRetDereferenceableBytes() || AL.getRetDereferenceableOrNullBytes()) {
+            lockPointee(FT->getReturnType());
+        }
+    }
+
+    void lockPointee(Type *Ty) {
+        if (Ty->isPointerTy() && !Ty->isOpaquePointerTy()) {
+            lock(Ty->getPointerElementType());
+        }
+    }
+
+    static bool isBytePointer(Type *Ty) {
+        return Ty->isPointerTy() && !Ty->isOpaquePointerTy() && Ty->getPointerElementType()->isIntegerTy(8);
+    }
+
+    // 转为 i8* 后只交给 lifetime / mem* / free 使用时不依赖字段布局，mem* / free 依赖大小
+    bool scanBytePointerUsers(BitCastInst &BC) {
+        bool sized = false;
+        for (User *U: BC.users()) {
+            auto *CB = dyn_cast<CallBase>(U);
+            Function *Callee = CB ? CB->getCalledFunction() : nullptr;
+            if (!Callee) {
+                return false;
+            }
+            if (Callee->getIntrinsicID() == Intrinsic::lifetime_start ||
+                Callee->getIntrinsicID() == Intrinsic::lifetime_end) {
+                continue;
+            }
+            if (isa<MemIntrinsic>(CB) || Callee->getName() == "free" || Callee->getName() == "_ZdlPv" ||
+                Callee->getName() == "_ZdlPvm") {
+                sized = true;
+                continue;
+            }
+            return false;
+        }
+        if (sized) {
+            lockPointee(BC.getSrcTy());
+        }
+        return true;
+    }
+
+    void scanCast(CastInst &CI) {
+        if (auto *BC = dyn_cast<BitCastInst>(&CI)) {
+            Type *Src = BC->getSrcTy();
+            Type *Dst = BC->getDestTy();
+            if (isBytePointer(Dst) && Src->isPointerTy() && Src->getPointerElementType()->isStructTy() &&
+                scanBytePointerUsers(*BC)) {
+                return;
+            }
+            // malloc / new 的返回值按 sizeof 分配
+            if (isBytePointer(Src) && Dst->isPointerTy() && Dst->getPointerElementType()->isStructTy() &&
+                isa<CallBase>(BC->getOperand(0))) {
+                lockPointee(Dst);
+                return;
+            }
+        }
+        escape(CI.getSrcTy());
+        escape(CI.getDestTy());
+    }
+
+    void scanInstruction(Instruction &I) {
+        for (Value *Op: I.operands()) {
+            if (auto *C = dyn_cast<Constant>(Op)) {
+                scanConstant(C);
+            }
+        }
+        if (auto *CI = dyn_cast<CastInst>(&I)) {
+            scanCast(*CI);
+        } else if (auto *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+            if (GEP->getType()->isVectorTy()) {
+                escape(GEP->getSourceElementType());
+            }
+        } else if (auto *LI = dyn_cast<LoadInst>(&I)) {
+            if (LI->getType()->isAggregateType()) {
+                escape(LI->getType());
+            }
+        } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+            if (SI->getValueOperand()->getType()->isAggregateType()) {
+                escape(SI->getValueOperand()->getType());
+            }
+        } else if (auto *CB = dyn_cast<CallBase>(&I)) {
+            FunctionType *FT = CB->getFunctionType();
+            if (!CB->getCalledFunction() || CB->isInlineAsm()) {
+                escape(FT);
+            }
+            for (unsigned i = FT->getNumParams(); i < CB->arg_size(); i++) {
+                escape(CB->getArgOperand(i)->getType());
+            }
+            scanAttributes(CB->getAttributes(), FT);
+        } else if (isa<ExtractValueInst>(I) || isa<InsertValueInst>(I) || isa<VAArgInst>(I) ||
+                   isa<LandingPadInst>(I) || isa<AtomicCmpXchgInst>(I)) {
+            escape(I.getType());
+            for (Value *Op: I.operands()) {
+                escape(Op->getType());
+            }
+        }
+    }
+
+    void scanConstant(Constant *C) {
+        if (isa<GlobalValue>(C) || !SeenConstants.insert(C).second) {
+            return;
+        }
+        if (auto *CE = dyn_cast<ConstantExpr>(C)) {
+            if (CE->isCast()) {
+                escape(CE->getType());
+                escape(CE->getOperand(0)->getType());
+            } else if (CE->getOpcode() == Instruction::GetElementPtr && CE->getType()->isVectorTy()) {
+                escape(cast<GEPOperator>(CE)->getSourceElementType());
+            }
+        }
+        for (Value *Op: C->operands()) {
+            if (auto *OpC = dyn_cast<Constant>(Op)) {
+                scanConstant(OpC);
+            }
+        }
+    }
+};
+
+// 按新顺序计算结构体大小与填充，与 DataLayout 对非 packed 结构体的布局规则一致
+static std::pair<uint64_t, uint64_t> layoutOf(const DataLayout &DL, StructType *ST, const vector<unsigned> &Order) {
+    uint64_t offset = 0;
+    uint64_t payload = 0;
+    Align maxAlign(1);
+    for (unsigned k: Order) {
+        Type *Ty = ST->getElementType(k);
+        Align A = DL.getABITypeAlign(Ty);
+        offset = alignTo(offset, A) + DL.getTypeAllocSize(Ty);
+        payload += DL.getTypeAllocSize(Ty);
+        maxAlign = std::max(maxAlign, A);
+    }
+    uint64_t size = alignTo(offset, maxAlign);
+    return {size, size - payload};
+}
+
+static void shuffle(vector<unsigned> &V) {
+    for (size_t i = V.size(); i > 1; i--) {
+        std::swap(V[i - 1], V[crypto->get_range(i)]);
+    }
+}
+
+// 字段访问次数与字段之间的共同访问权重（同一函数中两个字段访问次数的较小值之和）
+struct FieldProfile {
+    vector<double> Count;
+    vector<vector<double>> Affinity;
+};
+
+static Permutation choosePermutation(const DataLayout &DL, StructType *ST, const FieldProfile &P,
+                                     bool Locked, bool Locality) {
+    unsigned n = ST->getNumElements();
+    vector<unsigned> Fields(n);
+    for (unsigned k = 0; k < n; k++) {
+        Fields[k] = k;
+    }
+    shuffle(Fields);
+    auto hotter = [&](unsigned a, unsigned b) {
+        return Locality && P.Count[a] > P.Count[b];
+    };
+    auto alignOf = [&](unsigned k) {
+        return DL.getABITypeAlign(ST->getElementType(k));
+    };
+    vector<unsigned> Order;
+    if (Locked) {
+        // 大小和对齐相同的字段互换位置不改变任何偏移，同组中更热的字段占用更靠前的位置
+        Order.resize(n);
+        std::map<std::pair<uint64_t, uint64_t>, vector<unsigned>> Groups;
+        for (unsigned k = 0; k < n; k++) {
+            Groups[{DL.getTypeAllocSize(ST->getElementType(k)), alignOf(k).value()}].push_back(k);
+        }
+        for (auto &G: Groups) {
+            vector<unsigned> Slots = G.second;
+            vector<unsigned> Members = G.second;
+            shuffle(Members);
+            std::stable_sort(Members.begin(), Members.end(), hotter);
+            for (size_t i = 0; i < Slots.size(); i++) {
+                Order[Slots[i]] = Members[i];
+            }
+        }
+    } else {
+        // 对齐从大到小排列时填充最少，相同对齐的字段热的在前
+        vector<unsigned> Compact = Fields;
+        std::stable_sort(Compact.begin(), Compact.end(), hotter);
+        std::stable_sort(Compact.begin(), Compact.end(), [&](unsigned a, unsigned b) {
+            return alignOf(a) > alignOf(b);
+        });
+        Order = Compact;
+        if (Locality && layoutOf(DL, ST, Fields).first > CacheLine) {
+            // 从最热的字段开始逐条填充 cache line，每次加入与当前行共同访问最多的字段，行内按对齐排列
+            vector<unsigned> Remaining = Fields;
+            std::stable_sort(Remaining.begin(), Remaining.end(), hotter);
+            vector<unsigned> Clustered;
+            while (!Remaining.empty()) {
+                vector<unsigned> Line{Remaining.front()};
+                Remaining.erase(Remaining.begin());
+                uint64_t bytes = DL.getTypeAllocSize(ST->getElementType(Line[0]));
+                while (!Remaining.empty() && bytes < CacheLine) {
+                    size_t best = 0;
+                    double bestAffinity = -1;
+                    for (size_t i = 0; i < Remaining.size(); i++) {
+                        double affinity = 0;
+                        for (unsigned l: Line) {
+                            affinity += P.Affinity[Remaining[i]][l];
+                        }
+                        if (affinity > bestAffinity) {
+                            best = i;
+                            bestAffinity = affinity;
+                        }
+                    }
+                    bytes += DL.getTypeAllocSize(ST->getElementType(Remaining[best]));
+                    Line.push_back(Remaining[best]);
+                    Remaining.erase(Remaining.begin() + (long) best);
+                }
+                std::stable_sort(Line.begin(), Line.end(), [&](unsigned a, unsigned b) {
+                    return alignOf(a) > alignOf(b);
+                });
+                Clustered.insert(Clustered.end(), Line.begin(), Line.end());
+            }
+            // 分行带来额外填充时退回紧凑顺序
+            if (layoutOf(DL, ST, Clustered).first <= layoutOf(DL, ST, Compact).first) {
+                Order = Clustered;
+            }
+        }
+    }
+    Permutation NewIndex(n);
+    for (unsigned i = 0; i < n; i++) {
+        NewIndex[Order[i]] = i;
+    }
+    return NewIndex;
+}
+
+// 对 GEP 中落在结构体上的下标调用 Callback(结构体, 字段, 操作数位置)
+template<typename CallbackT>
+static void forEachStructIndex(Type *SourceTy, User *GEP, CallbackT Callback) {
+    Type *Cur = SourceTy;
+    for (unsigned i = 2; i < GEP->getNumOperands(); i++) {
+        Value *Idx = GEP->getOperand(i);
+        if (auto *ST = dyn_cast<StructType>(Cur)) {
+            unsigned k = (unsigned) cast<ConstantInt>(Idx)->getZExtValue();
+            Callback(ST, k, i);
+            Cur = ST->getElementType(k);
+        } else {
+            Cur = GetElementPtrInst::getTypeAtIndex(Cur, Idx);
+        }
+    }
+}
+
+// 把重排的结构体及引用它们的结构体映射为新类型，并改写常量
+class LayoutRewriter {
+public:
+    LayoutRewriter(Module &M, std::map<StructType *, Permutation> &Reordered) : M(M), Reordered(Reordered) {
+        // 引用了需要重建的结构体（包括经过指针）的命名结构体同样需要重建
+        for (auto &It: Reordered) {
+            Rebuild.insert(It.first);
+        }
+        vector<StructType *> All = M.getIdentifiedStructTypes();
+        bool changed;
+        do {
+            changed = false;
+            for (StructType *ST: All) {
+                if (!Rebuild.count(ST) && !ST->isOpaque() && mentions(ST)) {
+                    Rebuild.insert(ST);
+                    changed = true;
+                }
+            }
+        } while (changed);
+    }
+
+    Type *remap(Type *Ty) {
+        auto It = Types.find(Ty);
+        if (It != Types.end()) {
+            return It->second;
+        }
+        if (auto *ST = dyn_cast<StructType>(Ty)) {
+            if (!ST->isLiteral()) {
+                if (!Rebuild.count(ST)) {
+                    return Types[Ty] = Ty;
+                }
+                std::string Name = ST->getName().str();
+                ST->setName(Name + ".orig");
+                StructType *New = StructType::create(M.getContext(), Name);
+                Types[Ty] = New;
+                vector<Type *> Body(ST->getNumElements());
+                auto P = Reordered.find(ST);
+                for (unsigned k = 0; k < ST->getNumElements(); k++) {
+                    Body[P == Reordered.end() ? k : P->second[k]] = remap(ST->getElementType(k));
+                }
+                New->setBody(Body, ST->isPacked());
+                return New;
+            }
+        }
+        vector<Type *> Subs;
+        bool changed = false;
+        for (Type *Sub: Ty->subtypes()) {
+            Subs.push_back(remap(Sub));
+            changed |= Subs.back() != Sub;
+        }
+        Type *Result = Ty;
+        if (changed) {
+            if (auto *PT = dyn_cast<PointerType>(Ty)) {
+                Result = PointerType::get(Subs[0], PT->getAddressSpace());
+            } else if (auto *AT = dyn_cast<ArrayType>(Ty)) {
+                Result = ArrayType::get(Subs[0], AT->getNumElements());
+            } else if (auto *VT = dyn_cast<VectorType>(Ty)) {
+                Result = VectorType::get(Subs[0], VT->getElementCount());
+            } else if (auto *FT = dyn_cast<FunctionType>(Ty)) {
+                Result = FunctionType::get(Subs[0], ArrayRef<Type *>(Subs).drop_front(), FT->isVarArg());
+            } else if (auto *LT = dyn_cast<StructType>(Ty)) {
+                Result = StructType::get(M.getContext(), Subs, LT->isPacked());
+            }
+        }
+        return Types[Ty] = Result;
+    }
+
+    // GEP 中的结构体下标按新顺序改写，Ops 与 GEP 的操作数一一对应
+    void permuteIndices(Type *SourceTy, User *GEP, vector<Value *> &Ops) {
+        forEachStructIndex(SourceTy, GEP, [&](StructType *ST, unsigned k, unsigned i) {
+            auto P = Reordered.find(ST);
+            if (P != Reordered.end()) {
+                Ops[i] = ConstantInt::get(Type::getInt32Ty(M.getContext()), P->second[k]);
+            }
+        });
+    }
+
+    Constant *map(Constant *C) {
+        auto It = Constants.find(C);
+        if (It != Constants.end()) {
+            return It->second;
+        }
+        Constant *Result = C;
+        Type *Ty = remap(C->getType());
+        if (auto *GV = dyn_cast<GlobalValue>(C)) {
+            auto R = Values.find(GV);
+            Result = R == Values.end() ? C : cast<Constant>(R->second);
+        } else if (isa<ConstantAggregateZero>(C)) {
+            Result = ConstantAggregateZero::get(Ty);
+        } else if (isa<PoisonValue>(C)) {
+            Result = PoisonValue::get(Ty);
+        } else if (isa<UndefValue>(C)) {
+            Result = UndefValue::get(Ty);
+        } else if (isa<ConstantPointerNull>(C)) {
+            Result = ConstantPointerNull::get(cast<PointerType>(Ty));
+        } else if (auto *BA = dyn_cast<BlockAddress>(C)) {
+            Result = BlockAddress::get(cast<Function>(map(BA->getFunction())), BA->getBasicBlock());
+        } else if (isa<ConstantAggregate>(C) || isa<ConstantExpr>(C)) {
+            vector<Value *> Ops;
+            vector<Constant *> Mapped;
+            for (Value *Op: C->operands()) {
+                Ops.push_back(map(cast<Constant>(Op)));
+            }
+            if (auto *CS = dyn_cast<ConstantStruct>(C)) {
+                auto P = Reordered.find(CS->getType());
+                for (unsigned k = 0; k < Ops.size(); k++) {
+                    Mapped.push_back(nullptr);
+                }
+                for (unsigned k = 0; k < Ops.size(); k++) {
+                    Mapped[P == Reordered.end() ? k : P->second[k]] = cast<Constant>(Ops[k]);
+                }
+                Result = ConstantStruct::get(cast<StructType>(Ty), Mapped);
+            } else if (isa<ConstantArray>(C)) {
+                for (Value *Op: Ops) {
+                    Mapped.push_back(cast<Constant>(Op));
+                }
+                Result = ConstantArray::get(cast<ArrayType>(Ty), Mapped);
+            } else if (isa<ConstantVector>(C)) {
+                for (Value *Op: Ops) {
+                    Mapped.push_back(cast<Constant>(Op));
+                }
+                Result = ConstantVector::get(Mapped);
+            } else if (auto *GEP = dyn_cast<GEPOperator>(C)) {
+                permuteIndices(GEP->getSourceElementType(), GEP, Ops);
+                vector<Constant *> Idx;
+                for (size_t i = 1; i < Ops.size(); i++) {
+                    Idx.push_back(cast<Constant>(Ops[i]));
+                }
+                Result = ConstantExpr::getGetElementPtr(remap(GEP->getSourceElementType()), cast<Constant>(Ops[0]),
+                                                        Idx, GEP->isInBounds(), GEP->getInRangeIndex());
+            } else {
+                for (Value *Op: Ops) {
+                    Mapped.push_back(cast<Constant>(Op));
+                }
+                Result = cast<ConstantExpr>(C)->getWithOperands(Mapped, Ty);
+            }
+        }
+        return Constants[C] = Result;
+    }
+
+    void rewriteInstruction(Instruction &I) {
+        if (auto *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+            vector<Value *> Ops(GEP->op_begin(), GEP->op_end());
+            permuteIndices(GEP->getSourceElementType(), GEP, Ops);
+            for (unsigned i = 0; i < Ops.size(); i++) {
+                GEP->setOperand(i, Ops[i]);
+            }
+            GEP->setSourceElementType(remap(GEP->getSourceElementType()));
+            GEP->setResultElementType(remap(GEP->getResultElementType()));
+        } else if (auto *AI = dyn_cast<AllocaInst>(&I)) {
+            AI->setAllocatedType(remap(AI->getAllocatedType()));
+        } else if (auto *CB = dyn_cast<CallBase>(&I)) {
+            CB->mutateFunctionType(cast<FunctionType>(remap(CB->getFunctionType())));
+        }
+        for (Use &U: I.operands()) {
+            auto R = Values.find(U.get());
+            if (R != Values.end()) {
+                U.set(R->second);
+            } else if (auto *C = dyn_cast<Constant>(U.get())) {
+                U.set(map(C));
+            }
+        }
+        I.mutateType(remap(I.getType()));
+    }
+
+    // 旧值到新值（全局变量、函数、参数）
+    std::map<Value *, Value *> Values;
+
+private:
+    Module &M;
+    std::map<StructType *, Permutation> &Reordered;
+    std::set<StructType *> Rebuild;
+    std::map<Type *, Type *> Types;
+    std::map<Constant *, Constant *> Constants;
+
+    // Ty 的定义中是否出现需要重建的命名结构体
+    bool mentions(Type *Ty) {
+        for (Type *Sub: Ty->subtypes()) {
+            auto *ST = dyn_cast<StructType>(Sub);
+            if (ST && !ST->isLiteral()) {
+                if (Rebuild.count(ST)) {
+                    return true;
+                }
+                continue;
+            }
+            if (mentions(Sub)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+PreservedAnalyses StructReorder::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassStructReorder &config = Options->StructReorder;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "StructReorder", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    const DataLayout &DL = M.getDataLayout();
+
+    LayoutAnalysis Layout;
+    Layout.scanModule(M);
+    std::set<StructType *> Candidates;
+    for (StructType *ST: M.getIdentifiedStructTypes()) {
+        if (ST->isOpaque() || ST->isPacked() || ST->getNumElements() < 2 || !ST->isSized() ||
+            Layout.Escaped.count(ST)) {
+            continue;
+        }
+        bool fixed = true;
+        for (Type *Ty: ST->elements()) {
+            fixed &= !isa<ScalableVectorType>(Ty);
+        }
+        if (fixed) {
+            Candidates.insert(ST);
+        }
+    }
+
+    // 统计字段访问次数，访问了结构体的函数全部允许混淆时才重排
+    std::map<StructType *, FieldProfile> Profiles;
+    for (StructType *ST: Candidates) {
+        FieldProfile &P = Profiles[ST];
+        P.Count.assign(ST->getNumElements(), 0);
+        P.Affinity.assign(ST->getNumElements(), vector<double>(ST->getNumElements(), 0));
+    }
+    for (auto &F: M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        bool allowed = toObfuscate(config.enable, &F, "sr");
+        auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+        double entry = (double) BFI.getEntryFreq();
+        double scale = F.getEntryCount() ? (double) F.getEntryCount()->getCount() : 1;
+        std::map<StructType *, vector<double>> Local;
+        auto record = [&](Type *SourceTy, User *GEP, double freq) {
+            forEachStructIndex(SourceTy, GEP, [&](StructType *ST, unsigned k, unsigned) {
+                if (!Candidates.count(ST)) {
+                    return;
+                }
+                if (!allowed) {
+                    Candidates.erase(ST);
+                    return;
+                }
+                vector<double> &Counts = Local[ST];
+                Counts.resize(ST->getNumElements());
+                Counts[k] += freq;
+            });
+        };
+        for (auto &BB: F) {
+            double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry * scale;
+            for (auto &I: BB) {
+                if (auto *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+                    record(GEP->getSourceElementType(), GEP, freq);
+                }
+                for (Value *Op: I.operands()) {
+                    if (auto *GEP = dyn_cast<GEPOperator>(Op)) {
+                        if (isa<ConstantExpr>(GEP)) {
+                            record(GEP->getSourceElementType(), GEP, freq);
+                        }
+                    }
+                }
+            }
+        }
+        for (auto &It: Local) {
+            if (!Candidates.count(It.first)) {
+                continue;
+            }
+            FieldProfile &P = Profiles[It.first];
+            vector<double> &Counts = It.second;
+            for (size_t a = 0; a < Counts.size(); a++) {
+                P.Count[a] += Counts[a];
+                for (size_t b = 0; b < Counts.size(); b++) {
+                    if (a != b) {
+                        P.Affinity[a][b] += std::min(Counts[a], Counts[b]);
+                    }
+                }
+            }
+        }
+    }
+
+    std::map<StructType *, Permutation> Reordered;
+    for (StructType *ST: Candidates) {
+        bool locked = Layout.Locked.count(ST);
+        Permutation NewIndex = choosePermutation(DL, ST, Profiles[ST], locked, config.locality);
+        vector<unsigned> Original(ST->getNumElements());
+        vector<unsigned> Order(ST->getNumElements());
+        bool identity = true;
+        for (unsigned k = 0; k < ST->getNumElements(); k++) {
+            Original[k] = k;
+            Order[NewIndex[k]] = k;
+            identity &= NewIndex[k] == k;
+        }
+        auto before = layoutOf(DL, ST, Original);
+        auto after = layoutOf(DL, ST, Order);
+        report->addNote("StructReorder", ST->getName(),
+                        fmt::format("size {} -> {}, padding {} -> {}, order [{}]{}", before.first, after.first,
+                                    before.second, after.second, fmt::join(Order, ", "),
+                                    locked ? ", size locked" : ""));
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "StructReorder: {} (size {} -> {}, padding {} -> {})\n", ST->getName().str(),
+                                  before.first, after.first, before.second, after.second);
+        }
+        if (!identity) {
+            Reordered[ST] = NewIndex;
+        }
+    }
+    if (Reordered.empty()) {
+        return PreservedAnalyses::all();
+    }
+
+    LayoutRewriter Rewriter(M, Reordered);
+    // 类型发生变化的全局变量与函数需要重新创建
+    vector<GlobalVariable *> OldGlobals;
+    for (auto &GV: M.globals()) {
+        if (Rewriter.remap(GV.getValueType()) != GV.getValueType()) {
+            OldGlobals.push_back(&GV);
+        }
+    }
+    for (GlobalVariable *GV: OldGlobals) {
+        auto *New = new GlobalVariable(M, Rewriter.remap(GV->getValueType()), GV->isConstant(), GV->getLinkage(),
+                                       nullptr, "", GV, GV->getThreadLocalMode(), GV->getAddressSpace());
+        New->copyAttributesFrom(GV);
+        New->copyMetadata(GV, 0);
+        New->takeName(GV);
+        Rewriter.Values[GV] = New;
+    }
+    vector<Function *> OldFunctions;
+    for (auto &F: M) {
+        if (Rewriter.remap(F.getFunctionType()) != F.getFunctionType()) {
+            OldFunctions.push_back(&F);
+        }
+    }
+    for (Function *F: OldFunctions) {
+        Function *New = Function::Create(cast<FunctionType>(Rewriter.remap(F->getFunctionType())),
+                                         F->getLinkage(), F->getAddressSpace(), "");
+        M.getFunctionList().insert(F->getIterator(), New);
+        New->copyAttributesFrom(F);
+        New->copyMetadata(F, 0);
+        New->takeName(F);
+        New->getBasicBlockList().splice(New->begin(), F->getBasicBlockList());
+        for (unsigned i = 0; i < F->arg_size(); i++) {
+            New->getArg(i)->takeName(F->getArg(i));
+            Rewriter.Values[F->getArg(i)] = New->getArg(i);
+        }
+        Rewriter.Values[F] = New;
+    }
+
+    for (auto &F: M) {
+        for (auto &BB: F) {
+            for (auto &I: BB) {
+                Rewriter.rewriteInstruction(I);
+            }
+        }
+    }
+    // 新建的全局变量此时还没有初值，不会被重复映射
+    for (auto &GV: M.globals()) {
+        if (GV.hasInitializer() && !Rewriter.Values.count(&GV)) {
+            GV.setInitializer(Rewriter.map(GV.getInitializer()));
+        }
+    }
+    for (GlobalVariable *GV: OldGlobals) {
+        if (GV->hasInitializer()) {
+            cast<GlobalVariable>(Rewriter.Values[GV])->setInitializer(Rewriter.map(GV->getInitializer()));
+        }
+    }
+    for (auto &GA: M.aliases()) {
+        GA.setAliasee(Rewriter.map(GA.getAliasee()));
+    }
+
+    for (Function *F: OldFunctions) {
+        F->removeDeadConstantUsers();
+        // 计划项和生成函数记录仍指向旧函数，删除前换成重建的函数
+        report->replaceFunction(F, cast<Function>(Rewriter.Values[F]));
+        F->eraseFromParent();
+    }
+    for (GlobalVariable *GV: OldGlobals) {
+        GV->removeDeadConstantUsers();
+        GV->eraseFromParent();
+    }
+    return PreservedAnalyses::none();
+}
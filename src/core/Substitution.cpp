@@ -0,0 +1,290 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/Substitution.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/IRBuilder.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+// 循环内的指令按每层 8 次迭代估算执行次数
+static const unsigned LoopTripCount = 8;
+static const unsigned MaxLoopDepth = 4;
+
+// 指令很少的函数按此值计算延迟预算，避免小函数一条都改写不了
+static const double MinLatencyBase = 16;
+
+struct SubstitutionCandidate {
+    BinaryOperator *BO;
+    double weight;   // 循环深度折算的执行次数
+    double unitCost; // 一条同类型 ALU 指令的吞吐代价
+    double benefit;
+    int depth = 0;   // 实际改写深度，0 表示未选中
+};
+
+static double throughput(TargetTransformInfo &TTI, Instruction &I) {
+    InstructionCost C = TTI.getInstructionCost(&I, TargetTransformInfo::TCK_RecipThroughput);
+    if (!C.isValid()) {
+        return 1;
+    }
+    return (double) std::max<int64_t>(*C.getValue(), 0);
+}
+
+// 混淆收益：xor 多见于密钥混合，其次是 add/sub；带常量操作数的运算更容易被还原
+static double benefitOf(BinaryOperator *BO) {
+    double benefit;
+    switch (BO->getOpcode()) {
+        case Instruction::Xor:
+            benefit = 3;
+            break;
+        case Instruction::Add:
+        case Instruction::Sub:
+            benefit = 2;
+            break;
+        default:
+            benefit = 1;
+            break;
+    }
+    if (isa<Constant>(BO->getOperand(0)) || isa<Constant>(BO->getOperand(1))) {
+        benefit /= 2;
+    }
+    return benefit;
+}
+
+bool Substitution::isCandidate(Instruction &I) {
+    auto *BO = dyn_cast<BinaryOperator>(&I);
+    if (!BO || !BO->getType()->isIntegerTy() || BO->getType()->isIntegerTy(1)) {
+        return false;
+    }
+    if (isa<Constant>(BO->getOperand(0)) && isa<Constant>(BO->getOperand(1))) {
+        return false;
+    }
+    switch (BO->getOpcode()) {
+        case Instruction::Add:
+        case Instruction::Sub:
+        case Instruction::Xor:
+        case Instruction::And:
+        case Instruction::Or:
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint64_t Substitution::expansion(int depth) {
+    // 每次改写最多生成 3 条可继续改写的运算和 2 条辅助指令（取反、移位）
+    uint64_t n = 1;
+    for (int i = 0; i < depth; i++) {
+        n = n * 3 + 2;
+    }
+    return n;
+}
+
+// 用一个随机选择的恒等式替换 BO，并继续改写新生成的运算
+// 只使用 -O2 的 InstCombine 不会折叠回原指令的恒等式
+static void substitute(BinaryOperator *BO, int depth) {
+    IRBuilder<> IRB(BO);
+    Value *A = BO->getOperand(0);
+    Value *B = BO->getOperand(1);
+    Constant *One = ConstantInt::get(BO->getType(), 1);
+    vector<Value *> Children;
+    Value *R;
+    switch (BO->getOpcode()) {
+        case Instruction::Add:
+            if (crypto->get_range(2)) {
+                // a + b = (a ^ b) + ((a & b) << 1)
+                Value *X = IRB.CreateXor(A, B);
+                Value *N = IRB.CreateAnd(A, B);
+                R = IRB.CreateAdd(X, IRB.CreateShl(N, One));
+                Children = {X, N, R};
+            } else {
+                // a + b = ((a | b) << 1) - (a ^ b)
+                Value *O = IRB.CreateOr(A, B);
+                Value *X = IRB.CreateXor(A, B);
+                R = IRB.CreateSub(IRB.CreateShl(O, One), X);
+                Children = {O, X, R};
+            }
+            break;
+        case Instruction::Sub:
+            if (crypto->get_range(2)) {
+                // a - b = (a & ~b) - (~a & b)
+                Value *L = IRB.CreateAnd(A, IRB.CreateNot(B));
+                Value *N = IRB.CreateAnd(IRB.CreateNot(A), B);
+                R = IRB.CreateSub(L, N);
+                Children = {L, N, R};
+            } else {
+                // a - b = ((a & ~b) << 1) - (a ^ b)
+                Value *L = IRB.CreateAnd(A, IRB.CreateNot(B));
+                Value *X = IRB.CreateXor(A, B);
+                R = IRB.CreateSub(IRB.CreateShl(L, One), X);
+                Children = {L, X, R};
+            }
+            break;
+        case Instruction::Xor:
+            if (crypto->get_range(2)) {
+                // a ^ b = (a + b) - ((a & b) << 1)
+                Value *S = IRB.CreateAdd(A, B);
+                Value *N = IRB.CreateAnd(A, B);
+                R = IRB.CreateSub(S, IRB.CreateShl(N, One));
+                Children = {S, N, R};
+            } else {
+                // a ^ b = ((a | b) << 1) - (a + b)
+                Value *O = IRB.CreateOr(A, B);
+                Value *S = IRB.CreateAdd(A, B);
+                R = IRB.CreateSub(IRB.CreateShl(O, One), S);
+                Children = {O, S, R};
+            }
+            break;
+        case Instruction::And: {
+            // a & b = ((a | ~b) + b) + 1
+            Value *O = IRB.CreateOr(A, IRB.CreateNot(B));
+            Value *S = IRB.CreateAdd(O, B);
+            R = IRB.CreateAdd(S, One);
+            Children = {O, S, R};
+            break;
+        }
+        case Instruction::Or:
+            if (crypto->get_range(2)) {
+                // a | b = (a & ~b) + b
+                Value *L = IRB.CreateAnd(A, IRB.CreateNot(B));
+                R = IRB.CreateAdd(L, B);
+                Children = {L, R};
+            } else {
+                // a | b = a + (~a & b)
+                Value *N = IRB.CreateAnd(IRB.CreateNot(A), B);
+                R = IRB.CreateAdd(A, N);
+                Children = {N, R};
+            }
+            break;
+        default:
+            return;
+    }
+    R->takeName(BO);
+    BO->replaceAllUsesWith(R);
+    BO->eraseFromParent();
+    if (depth <= 1) {
+        return;
+    }
+    for (Value *V: Children) {
+        auto *Child = dyn_cast<BinaryOperator>(V);
+        if (Child && Substitution::isCandidate(*Child)) {
+            substitute(Child, depth - 1);
+        }
+    }
+}
+
+PreservedAnalyses Substitution::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassSubstitution &config = Options->Substitution;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "Substitution", M);
+    BudgetTracker budget(Options, "Substitution", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    bool changed = false;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "sub", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "Substitution: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        budget.startFunction();
+        auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+        auto &LI = FAM.getResult<LoopAnalysis>(F);
+
+        int prob = scope.prob(config.prob);
+        int maxDepth = scope.repeat(config.depth);
+        double base = 0;
+        vector<SubstitutionCandidate> Candidates;
+        for (auto &BB: F) {
+            double weight = std::pow((double) LoopTripCount,
+                                     (double) std::min(LI.getLoopDepth(&BB), MaxLoopDepth));
+            for (auto &I: BB) {
+                base += throughput(TTI, I) * weight;
+                if (!isCandidate(I) || !scope.instruction(I)) {
+                    continue;
+                }
+                if (prob != 100 && crypto->get_range(100) >= (unsigned int) prob) {
+                    continue;
+                }
+                auto *BO = cast<BinaryOperator>(&I);
+                double unitCost = std::max(throughput(TTI, I), 1.0);
+                Candidates.push_back({BO, weight, unitCost, benefitOf(BO)});
+            }
+        }
+        if (Candidates.empty()) {
+            continue;
+        }
+
+        // 改写深度相同时新增指令数相同，收益 / 代价 只取决于指令本身的代价和执行次数
+        std::stable_sort(Candidates.begin(), Candidates.end(),
+                         [](const SubstitutionCandidate &A, const SubstitutionCandidate &B) {
+                             return A.benefit / (A.unitCost * A.weight) > B.benefit / (B.unitCost * B.weight);
+                         });
+        double allowed = config.budget ? std::max(base, MinLatencyBase) * config.budget / 100 : INFINITY;
+        double used = 0;
+        uint64_t growth = budget.remaining(F);
+        uint64_t remaining = growth;
+        size_t selected = 0, reduced = 0;
+        for (auto &C: Candidates) {
+            // 预算不足时降低深度，仍然放不下就跳过
+            for (int depth = maxDepth; depth >= 1; depth--) {
+                uint64_t added = expansion(depth) - 1;
+                double cost = (double) added * C.unitCost * C.weight;
+                if (used + cost <= allowed && added <= remaining) {
+                    C.depth = depth;
+                    used += cost;
+                    remaining -= added;
+                    selected++;
+                    reduced += depth != maxDepth;
+                    break;
+                }
+            }
+        }
+        if (selected < Candidates.size() || reduced) {
+            budget.degrade(F, fmt::format("latency {:.1f}/{:.1f}, growth {}/{}, {} of {} rewritten, "
+                                          "{} at reduced depth", used, allowed, growth - remaining, growth,
+                                          selected, Candidates.size(), reduced));
+        }
+
+        unsigned before = F.getInstructionCount();
+        for (auto &C: Candidates) {
+            if (!C.depth) {
+                continue;
+            }
+            if (budget.functionTimeExceeded()) {
+                budget.degrade(F, "function time budget exceeded, stopped");
+                break;
+            }
+            substitute(C.BO, C.depth);
+            changed = true;
+        }
+        unsigned after = F.getInstructionCount();
+        budget.charge(F, after > before ? after - before : 0);
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "Substitution: {} ({} of {} rewritten, cost {:.1f}/{:.1f})\n",
+                                  F.getName().str(), selected, Candidates.size(), used, allowed);
+        }
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
@@ -0,0 +1,500 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "core/SwitchEncoding.h"
+#include "utils/Budget.h"
+#include "utils/CryptoUtils.h"
+#include "utils/Report.h"
+#include "utils/Utils.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <algorithm>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+using std::vector;
+
+const uint64_t SwitchEncoding::DispatchCost;
+
+// 槽位数上限，位移表元素用 i16 保存
+static const unsigned MaxSlotBits = 16;
+
+// 每个槽位数下尝试的随机参数组数，全部失败时槽位数翻倍
+static const unsigned Attempts = 32;
+
+// 不分桶时尝试的随机参数组数，case 数在 32 以内时通常能找到
+static const unsigned DirectAttempts = 4096;
+
+// case 值所在区间的密度不低于此值 [%] 时视为稠密 switch，后端本来就会生成跳转表（与 -Os 下的跳转表密度阈值相同）
+static const uint64_t DenseDensity = 40;
+
+// p = (x ^ k1) * mul，桶 = p 的高 bucketBits 位，槽位 = (p 接下来的 slotBits 位 + disp[桶]) mod 2^slotBits；
+// bucketBits 为 0 时槽位直接取 p 的高 slotBits 位，不需要位移表
+struct PerfectHash {
+    uint64_t k1;
+    uint64_t mul;
+    unsigned bucketBits;
+    unsigned slotBits;
+    vector<uint16_t> disp;
+    vector<uint32_t> slots; // 每个 key 所在的槽位
+};
+
+static void hashKey(const PerfectHash &H, uint64_t Key, uint64_t &Bucket, uint64_t &Base) {
+    uint64_t p = (Key ^ H.k1) * H.mul;
+    Bucket = H.bucketBits ? p >> (64 - H.bucketBits) : 0;
+    Base = (p >> (64 - H.bucketBits - H.slotBits)) & ((1ull << H.slotBits) - 1);
+}
+
+// 分桶位移：按桶大小从大到小依次放入，为每个桶找到一个让桶内所有 key 都落在空槽位的位移
+static bool tryBuild(const vector<uint64_t> &Keys, PerfectHash &H) {
+    uint64_t T = 1ull << H.slotBits;
+    vector<vector<std::pair<uint64_t, unsigned>>> Buckets(1ull << H.bucketBits);
+    for (unsigned i = 0; i < Keys.size(); i++) {
+        uint64_t bucket, base;
+        hashKey(H, Keys[i], bucket, base);
+        Buckets[bucket].emplace_back(base, i);
+    }
+    vector<unsigned> Order(Buckets.size());
+    for (unsigned i = 0; i < Order.size(); i++) {
+        Order[i] = i;
+    }
+    std::stable_sort(Order.begin(), Order.end(), [&](unsigned A, unsigned B) {
+        return Buckets[A].size() > Buckets[B].size();
+    });
+    H.disp.assign(Buckets.size(), 0);
+    H.slots.assign(Keys.size(), 0);
+    vector<bool> Used(T, false);
+    for (unsigned b: Order) {
+        auto &Bucket = Buckets[b];
+        if (Bucket.empty()) {
+            break;
+        }
+        // 桶内基址相同的 key 无论位移多少都会冲突
+        for (unsigned i = 0; i < Bucket.size(); i++) {
+            for (unsigned j = i + 1; j < Bucket.size(); j++) {
+                if (Bucket[i].first == Bucket[j].first) {
+                    return false;
+                }
+            }
+        }
+        bool placed = false;
+        uint64_t start = crypto->get_range(T);
+        for (uint64_t k = 0; k < T && !placed; k++) {
+            uint64_t d = (start + k) & (T - 1);
+            placed = true;
+            for (auto &E: Bucket) {
+                if (Used[(E.first + d) & (T - 1)]) {
+                    placed = false;
+                    break;
+                }
+            }
+            if (placed) {
+                H.disp[b] = (uint16_t) d;
+                for (auto &E: Bucket) {
+                    H.slots[E.second] = (uint32_t) ((E.first + d) & (T - 1));
+                    Used[H.slots[E.second]] = true;
+                }
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 不分桶的乘移位：所有 key 的高 slotBits 位互不相同
+static bool tryDirect(const vector<uint64_t> &Keys, PerfectHash &H) {
+    vector<bool> Used(1ull << H.slotBits, false);
+    H.slots.assign(Keys.size(), 0);
+    for (unsigned i = 0; i < Keys.size(); i++) {
+        uint64_t bucket, base;
+        hashKey(H, Keys[i], bucket, base);
+        if (Used[base]) {
+            return false;
+        }
+        Used[base] = true;
+        H.slots[i] = (uint32_t) base;
+    }
+    H.disp.clear();
+    return true;
+}
+
+static bool buildPerfectHash(const vector<uint64_t> &Keys, PerfectHash &H) {
+    unsigned bits = Log2_64_Ceil(std::max<uint64_t>(Keys.size(), 2));
+    // 小 switch 先尝试不分桶，省掉一次查表；槽位数最多为 case 数的两倍，保证跳转表密度不低于 50%
+    unsigned directBits = Log2_64(Keys.size()) + 1;
+    for (unsigned i = 0; i < DirectAttempts && Keys.size() <= 64; i++) {
+        H.k1 = crypto->get_uint64_t();
+        H.mul = crypto->get_uint64_t() | 1;
+        H.slotBits = directBits;
+        H.bucketBits = 0;
+        if (tryDirect(Keys, H)) {
+            return true;
+        }
+    }
+    for (; bits <= MaxSlotBits; bits++) {
+        for (unsigned i = 0; i < Attempts; i++) {
+            H.k1 = crypto->get_uint64_t();
+            H.mul = crypto->get_uint64_t() | 1;
+            H.slotBits = bits;
+            // 平均每个桶两个 key
+            H.bucketBits = std::max(bits, 2u) - 1;
+            if (tryBuild(Keys, H)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// 编码表元素的宽度：不小于条件值宽度的 8 / 16 / 32 / 64 位
+static IntegerType *keyType(LLVMContext &Ctx, unsigned Bits) {
+    return Type::getIntNTy(Ctx, std::max(8u, (unsigned) PowerOf2Ceil(Bits)));
+}
+
+bool SwitchEncoding::isCandidate(SwitchInst &SI) {
+    auto *Ty = dyn_cast<IntegerType>(SI.getCondition()->getType());
+    return Ty && Ty->getBitWidth() <= 64 && !SI.getDefaultDest()->isEHPad();
+}
+
+// switch 上的 !prof 权重，第一个是 default
+static bool getWeights(SwitchInst *SI, vector<uint64_t> &Weights) {
+    MDNode *MD = SI->getMetadata(LLVMContext::MD_prof);
+    if (!MD || MD->getNumOperands() != SI->getNumSuccessors() + 1) {
+        return false;
+    }
+    auto *Name = dyn_cast<MDString>(MD->getOperand(0));
+    if (!Name || Name->getString() != "branch_weights") {
+        return false;
+    }
+    for (unsigned i = 1; i < MD->getNumOperands(); i++) {
+        auto *W = mdconst::dyn_extract<ConstantInt>(MD->getOperand(i));
+        if (!W) {
+            return false;
+        }
+        Weights.push_back(W->getZExtValue());
+    }
+    return true;
+}
+
+// 分别以无符号最小值和有符号最小值为起点计算 case 值跨越的区间，取较小的一个；区间足够密时返回 true
+static bool denseRange(const vector<uint64_t> &Keys, unsigned Bits, uint64_t &Lo, uint64_t &Range) {
+    uint64_t Mask = Bits == 64 ? ~0ull : (1ull << Bits) - 1;
+    uint64_t UMin = *std::min_element(Keys.begin(), Keys.end());
+    uint64_t SMin = *std::min_element(Keys.begin(), Keys.end(), [&](uint64_t A, uint64_t B) {
+        return SignExtend64(A, Bits) < SignExtend64(B, Bits);
+    });
+    Range = ~0ull;
+    for (uint64_t Start: {UMin, SMin}) {
+        uint64_t Span = 0;
+        for (uint64_t K: Keys) {
+            Span = std::max(Span, (K - Start) & Mask);
+        }
+        if (Span < Range) {
+            Lo = Start;
+            Range = Span;
+        }
+    }
+    if (Range >= (1ull << MaxSlotBits)) {
+        return false;
+    }
+    Range++;
+    return Range * DenseDensity <= Keys.size() * 100;
+}
+
+// 稠密 switch：idx = x - Lo，超出 [0, Range) 时跳到 default，否则按 idx ^ k 跳转。后端原本就生成跳转表，
+// 完美哈希在这里只会多出乘法和两次查表；异或让跳转表项的顺序与 case 值无关，区间内的空洞作为显式 case 跳到 default。
+// Range 等于 2^位宽（如覆盖 0 ~ 255 的 i8、两个值都有的 i1）时不存在区间外的值，Range 本身也无法用条件值的类型表示，不做范围检查
+static void encodeDenseSwitch(SwitchInst *SI, const vector<SwitchInst::CaseHandle> &Cases, uint64_t Lo,
+                              uint64_t Range) {
+    BasicBlock *BB = SI->getParent();
+    BasicBlock *Default = SI->getDefaultDest();
+    Function *F = BB->getParent();
+    LLVMContext &Ctx = F->getContext();
+    Value *X = SI->getCondition();
+    auto *XTy = cast<IntegerType>(X->getType());
+    IntegerType *I32Ty = Type::getInt32Ty(Ctx);
+    uint64_t k = crypto->get_range(PowerOf2Ceil(Range));
+    uint64_t Mask = XTy->getBitMask();
+    bool Full = Range - 1 == Mask;
+
+    vector<BasicBlock *> Dest(Range, Default);
+    vector<uint64_t> Weights;
+    bool hasWeights = getWeights(SI, Weights);
+    vector<uint64_t> DestWeight(Range, 0);
+    uint64_t defaultWeight = hasWeights ? Weights[0] : 0, caseWeight = 0;
+    for (auto &Case: Cases) {
+        uint64_t Idx = (Case.getCaseValue()->getZExtValue() - Lo) & Mask;
+        Dest[Idx] = Case.getCaseSuccessor();
+        if (hasWeights) {
+            DestWeight[Idx] = Weights[Case.getSuccessorIndex()];
+            caseWeight += DestWeight[Idx];
+        }
+    }
+
+    BasicBlock *Dispatch = BasicBlock::Create(Ctx, BB->getName() + ".swe", F, BB->getNextNode());
+    BasicBlock *Unreachable = BasicBlock::Create(Ctx, BB->getName() + ".swe.unreachable", F, Dispatch->getNextNode());
+    new UnreachableInst(Ctx, Unreachable);
+
+    IRBuilder<> IRB(SI);
+    Value *Idx = IRB.CreateSub(X, ConstantInt::get(XTy, Lo));
+    IRBuilder<> DB(Dispatch);
+    Value *Slot = DB.CreateZExtOrTrunc(DB.CreateXor(Idx, ConstantInt::get(XTy, k)), I32Ty);
+    SwitchInst *NewSI = DB.CreateSwitch(Slot, Unreachable, Range);
+    vector<uint32_t> NewWeights{0};
+    unsigned holes = 0;
+    for (uint64_t i = 0; i < Range; i++) {
+        NewSI->addCase(ConstantInt::get(I32Ty, i ^ k), Dest[i]);
+        NewWeights.push_back((uint32_t) std::min<uint64_t>(DestWeight[i], UINT32_MAX));
+        holes += Dest[i] == Default;
+    }
+    MDBuilder MDB(Ctx);
+    if (hasWeights) {
+        NewSI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(NewWeights));
+    }
+
+    // default 的 phi 保留一条来自 BB 的边（Full 时不保留），每个空洞再加一条来自分发块的边；其余后继的边改为来自分发块
+    unsigned defaultEdges = 0;
+    for (unsigned i = 0; i < SI->getNumSuccessors(); i++) {
+        defaultEdges += SI->getSuccessor(i) == Default;
+    }
+    for (auto &PN: Default->phis()) {
+        Value *V = PN.getIncomingValueForBlock(BB);
+        for (unsigned i = Full ? 0 : 1; i < defaultEdges; i++) {
+            PN.removeIncomingValue(BB, false);
+        }
+        for (unsigned i = 0; i < holes; i++) {
+            PN.addIncoming(V, Dispatch);
+        }
+    }
+    std::set<BasicBlock *> Fixed;
+    for (auto &Case: Cases) {
+        BasicBlock *Succ = Case.getCaseSuccessor();
+        if (Fixed.insert(Succ).second) {
+            for (auto &PN: Succ->phis()) {
+                PN.replaceIncomingBlockWith(BB, Dispatch);
+            }
+        }
+    }
+    if (Full) {
+        IRB.CreateBr(Dispatch);
+        SI->eraseFromParent();
+        return;
+    }
+    Value *InRange = IRB.CreateICmpULT(Idx, ConstantInt::get(XTy, Range));
+    BranchInst *Br = IRB.CreateCondBr(InRange, Dispatch, Default);
+    if (hasWeights) {
+        Br->setMetadata(LLVMContext::MD_prof,
+                        MDB.createBranchWeights((uint32_t) std::min<uint64_t>(caseWeight, UINT32_MAX),
+                                                (uint32_t) std::min<uint64_t>(defaultWeight, UINT32_MAX)));
+    }
+    SI->eraseFromParent();
+}
+
+// 把 SI 改写为 哈希 + 查表比较，返回编码表与位移表的总字节数，无法构造完美哈希时返回 0
+static uint64_t encodeSwitch(SwitchInst *SI, const vector<SwitchInst::CaseHandle> &Cases) {
+    BasicBlock *BB = SI->getParent();
+    BasicBlock *Default = SI->getDefaultDest();
+    Function *F = BB->getParent();
+    Module &M = *F->getParent();
+    LLVMContext &Ctx = M.getContext();
+    Value *X = SI->getCondition();
+    unsigned Bits = X->getType()->getIntegerBitWidth();
+
+    vector<uint64_t> Keys;
+    for (auto &Case: Cases) {
+        Keys.push_back(Case.getCaseValue()->getZExtValue());
+    }
+    PerfectHash H;
+    if (!buildPerfectHash(Keys, H)) {
+        return 0;
+    }
+    uint64_t T = 1ull << H.slotBits;
+
+    // 编码表：槽位 -> case 值 ^ k2；空槽位填入某个映射到其他槽位的 case 值，任何输入都不会在这里比较成功
+    IntegerType *I64Ty = Type::getInt64Ty(Ctx);
+    IntegerType *I32Ty = Type::getInt32Ty(Ctx);
+    IntegerType *I16Ty = Type::getInt16Ty(Ctx);
+    IntegerType *KeyTy = keyType(Ctx, Bits);
+    uint64_t KeyMask = KeyTy->getBitMask();
+    uint64_t k2 = crypto->get_uint64_t() & KeyMask;
+    vector<uint64_t> Table(T, (Keys[crypto->get_range(Keys.size())] ^ k2) & KeyMask);
+    for (unsigned i = 0; i < Keys.size(); i++) {
+        Table[H.slots[i]] = (Keys[i] ^ k2) & KeyMask;
+    }
+    vector<Constant *> KeyInit;
+    for (uint64_t V: Table) {
+        KeyInit.push_back(ConstantInt::get(KeyTy, V));
+    }
+    auto *KeysTy = ArrayType::get(KeyTy, T);
+    auto *KeysGV = new GlobalVariable(M, KeysTy, true, GlobalValue::PrivateLinkage,
+                                      ConstantArray::get(KeysTy, KeyInit), "buer.swe.keys");
+    KeysGV->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+
+    // 哈希与比较留在原来的块中，按槽位跳转的 switch 放进新块
+    BasicBlock *Dispatch = BasicBlock::Create(Ctx, BB->getName() + ".swe", F, BB->getNextNode());
+    BasicBlock *Unreachable = BasicBlock::Create(Ctx, BB->getName() + ".swe.unreachable", F, Dispatch->getNextNode());
+    new UnreachableInst(Ctx, Unreachable);
+
+    IRBuilder<> IRB(SI);
+    Value *P = IRB.CreateMul(IRB.CreateXor(IRB.CreateZExt(X, I64Ty), H.k1), ConstantInt::get(I64Ty, H.mul));
+    Value *Slot;
+    if (H.bucketBits) {
+        vector<Constant *> DispInit;
+        for (uint16_t D: H.disp) {
+            DispInit.push_back(ConstantInt::get(I16Ty, D));
+        }
+        auto *DispTy = ArrayType::get(I16Ty, H.disp.size());
+        auto *DispGV = new GlobalVariable(M, DispTy, true, GlobalValue::PrivateLinkage,
+                                          ConstantArray::get(DispTy, DispInit), "buer.swe.disp");
+        DispGV->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+        Value *Bucket = IRB.CreateLShr(P, 64 - H.bucketBits);
+        Value *Base = IRB.CreateAnd(IRB.CreateLShr(P, 64 - H.bucketBits - H.slotBits), T - 1);
+        Value *D = IRB.CreateLoad(I16Ty, IRB.CreateInBoundsGEP(DispTy, DispGV, {ConstantInt::get(I64Ty, 0), Bucket}));
+        Slot = IRB.CreateAnd(IRB.CreateAdd(Base, IRB.CreateZExt(D, I64Ty)), T - 1);
+    } else {
+        Slot = IRB.CreateLShr(P, 64 - H.slotBits);
+    }
+    Value *Expected = IRB.CreateLoad(KeyTy, IRB.CreateInBoundsGEP(KeysTy, KeysGV, {ConstantInt::get(I64Ty, 0), Slot}));
+    Value *Encoded = IRB.CreateXor(IRB.CreateZExt(X, KeyTy), ConstantInt::get(KeyTy, k2));
+    Value *Match = IRB.CreateICmpEQ(Encoded, Expected);
+
+    vector<uint64_t> Weights;
+    bool hasWeights = getWeights(SI, Weights);
+    uint64_t defaultWeight = hasWeights ? Weights[0] : 0, caseWeight = 0;
+    IRBuilder<> DB(Dispatch);
+    SwitchInst *NewSI = DB.CreateSwitch(DB.CreateTrunc(Slot, I32Ty), Unreachable, Cases.size());
+    vector<uint32_t> NewWeights{0};
+    for (unsigned i = 0; i < Cases.size(); i++) {
+        NewSI->addCase(ConstantInt::get(I32Ty, H.slots[i]), Cases[i].getCaseSuccessor());
+        if (hasWeights) {
+            uint64_t W = Weights[Cases[i].getSuccessorIndex()];
+            caseWeight += W;
+            NewWeights.push_back((uint32_t) std::min<uint64_t>(W, UINT32_MAX));
+        }
+    }
+    MDBuilder MDB(Ctx);
+    if (hasWeights) {
+        NewSI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(NewWeights));
+    }
+
+    // 指向 default 的 case 已经丢弃，default 的 phi 只保留一条来自 BB 的边；其余后继的边改为来自分发块
+    unsigned defaultEdges = 0;
+    for (unsigned i = 0; i < SI->getNumSuccessors(); i++) {
+        defaultEdges += SI->getSuccessor(i) == Default;
+    }
+    for (auto &PN: Default->phis()) {
+        for (unsigned i = 1; i < defaultEdges; i++) {
+            PN.removeIncomingValue(BB, false);
+        }
+    }
+    std::set<BasicBlock *> Fixed;
+    for (auto &Case: Cases) {
+        BasicBlock *Succ = Case.getCaseSuccessor();
+        if (Fixed.insert(Succ).second) {
+            for (auto &PN: Succ->phis()) {
+                PN.replaceIncomingBlockWith(BB, Dispatch);
+            }
+        }
+    }
+    BranchInst *Br = IRB.CreateCondBr(Match, Dispatch, Default);
+    if (hasWeights) {
+        Br->setMetadata(LLVMContext::MD_prof,
+                        MDB.createBranchWeights((uint32_t) std::min<uint64_t>(caseWeight, UINT32_MAX),
+                                                (uint32_t) std::min<uint64_t>(defaultWeight, UINT32_MAX)));
+    }
+    SI->eraseFromParent();
+    return T * KeyTy->getBitWidth() / 8 + H.disp.size() * 2;
+}
+
+PreservedAnalyses SwitchEncoding::run(Module &M, ModuleAnalysisManager &MAM) const {
+    PassSwitchEncoding &config = Options->SwitchEncoding;
+    if (!config.enable) {
+        return PreservedAnalyses::all();
+    }
+    PassRecorder recorder(Options, "SwitchEncoding", M);
+    BudgetTracker budget(Options, "SwitchEncoding", M);
+    auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+    bool changed = false;
+    for (auto &F: M) {
+        Eligibility scope(Options, config.enable, F, "swe", FAM);
+        if (!scope.function()) {
+            IF_VERBOSE2 {
+                outs() << fmt::format(fmt::fg(fmt::color::red),
+                                      "SwitchEncoding: Ignore {}\n", F.getName().str());
+            }
+            continue;
+        }
+        if (budget.moduleTimeExceeded()) {
+            budget.degrade(F, "module time budget exceeded, skipped");
+            continue;
+        }
+        budget.startFunction();
+        vector<SwitchInst *> Switches;
+        for (auto &BB: F) {
+            auto *SI = dyn_cast<SwitchInst>(BB.getTerminator());
+            if (SI && isCandidate(*SI) && scope.instruction(*SI)) {
+                Switches.push_back(SI);
+            }
+        }
+        unsigned encoded = 0, dense = 0, cases = 0, failed = 0;
+        uint64_t tableBytes = 0;
+        for (SwitchInst *SI: Switches) {
+            // 跳转到 default 的 case 与 default 等价，不进入哈希表
+            vector<SwitchInst::CaseHandle> Cases;
+            for (auto Case: SI->cases()) {
+                if (Case.getCaseSuccessor() != SI->getDefaultDest()) {
+                    Cases.push_back(Case);
+                }
+            }
+            if (Cases.size() < (size_t) std::max(config.min, 1) || Cases.size() > (1u << MaxSlotBits)) {
+                continue;
+            }
+            if (budget.remaining(F) < DispatchCost) {
+                budget.degrade(F, fmt::format("growth budget exceeded, {} switches encoded", encoded));
+                break;
+            }
+            if (budget.functionTimeExceeded()) {
+                budget.degrade(F, fmt::format("function time budget exceeded, {} switches encoded", encoded));
+                break;
+            }
+            vector<uint64_t> Keys;
+            for (auto &Case: Cases) {
+                Keys.push_back(Case.getCaseValue()->getZExtValue());
+            }
+            uint64_t Lo, Range;
+            if (denseRange(Keys, SI->getCondition()->getType()->getIntegerBitWidth(), Lo, Range)) {
+                encodeDenseSwitch(SI, Cases, Lo, Range);
+                dense++;
+            } else {
+                uint64_t bytes = encodeSwitch(SI, Cases);
+                if (!bytes) {
+                    failed++;
+                    continue;
+                }
+                tableBytes += bytes;
+            }
+            budget.charge(F, DispatchCost);
+            cases += Cases.size();
+            encoded++;
+        }
+        if (!encoded && !failed) {
+            continue;
+        }
+        changed |= encoded > 0;
+        report->addNote("SwitchEncoding", F.getName(),
+                        fmt::format("{} switches ({} dense), {} cases, tables {} bytes, {} failed", encoded,
+                                    dense, cases, tableBytes, failed));
+        IF_VERBOSE {
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "SwitchEncoding: {} ({} switches, {} cases)\n",
+                                  F.getName().str(), encoded, cases);
+        }
+    }
+    return changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
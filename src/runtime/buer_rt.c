@@ -0,0 +1,582 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // RTLD_DEFAULT, SCHED_IDLE
+#endif
+
+#include "buer_rt.h"
+#include <dlfcn.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BUER_RT_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#define BUER_RT_API __attribute__((visibility("hidden")))
+
+// ---------------------------------------------------------------- 解密
+
+// 处理前若干个整块，返回已处理的字节数
+typedef uint64_t (*wide_decrypt_fn)(uint8_t *dst, const uint8_t *src, uint64_t len, const uint8_t *key,
+                                    uint8_t delta);
+
+static uint64_t decrypt_none(uint8_t *dst, const uint8_t *src, uint64_t len, const uint8_t *key, uint8_t delta) {
+    (void) dst, (void) src, (void) len, (void) key, (void) delta;
+    return 0;
+}
+
+#if defined(BUER_RT_X86)
+// 一次处理两个 16 字节块，低半部分为偶数块的密钥流
+__attribute__((target("avx2")))
+static uint64_t decrypt_avx2(uint8_t *dst, const uint8_t *src, uint64_t len, const uint8_t *key, uint8_t delta) {
+    __m128i k = _mm_loadu_si128((const __m128i *) key);
+    __m256i ks = _mm256_set_m128i(_mm_add_epi8(k, _mm_set1_epi8((char) delta)), k);
+    __m256i step = _mm256_set1_epi8((char) (uint8_t) (delta * 2));
+    uint64_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_xor_si256(v, ks));
+        ks = _mm256_add_epi8(ks, step);
+    }
+    return i;
+}
+#endif
+
+static wide_decrypt_fn select_wide_decrypt(void) {
+#if defined(BUER_RT_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return decrypt_avx2;
+    }
+#endif
+    return decrypt_none;
+}
+
+// 从第 i 个字节（16 的倍数）开始按 16 字节块处理，剩余不足 16 字节的部分逐字节处理
+static void decrypt_rest(uint8_t *dst, const uint8_t *src, uint64_t len, const uint8_t *key, uint8_t delta,
+                         uint64_t i) {
+    uint8_t ks[16];
+    uint8_t base = (uint8_t) ((i / 16) * delta);
+    for (int j = 0; j < 16; j++) {
+        ks[j] = (uint8_t) (key[j] + base);
+    }
+#if defined(__SSE2__)
+    __m128i k = _mm_loadu_si128((const __m128i *) ks);
+    __m128i d = _mm_set1_epi8((char) delta);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_xor_si128(v, k));
+        k = _mm_add_epi8(k, d);
+    }
+    _mm_storeu_si128((__m128i *) ks, k);
+#elif defined(__ARM_NEON)
+    uint8x16_t k = vld1q_u8(ks);
+    uint8x16_t d = vdupq_n_u8(delta);
+    for (; i + 16 <= len; i += 16) {
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(src + i), k));
+        k = vaddq_u8(k, d);
+    }
+    vst1q_u8(ks, k);
+#else
+    for (; i + 16 <= len; i += 16) {
+        for (int j = 0; j < 16; j++) {
+            dst[i + j] = src[i + j] ^ ks[j];
+            ks[j] = (uint8_t) (ks[j] + delta);
+        }
+    }
+#endif
+    for (int j = 0; i < len; i++, j++) {
+        dst[i] = src[i] ^ ks[j];
+    }
+}
+
+static _Atomic(wide_decrypt_fn) wide_decrypt;
+
+BUER_RT_API
+void __buer_rt_v1_decrypt(uint8_t *dst, const uint8_t *src, uint64_t len, const uint8_t *key, uint8_t delta) {
+    // 多个线程同时选择实现时结果相同，relaxed 即可
+    wide_decrypt_fn fn = atomic_load_explicit(&wide_decrypt, memory_order_relaxed);
+    if (!fn) {
+        fn = select_wide_decrypt();
+        atomic_store_explicit(&wide_decrypt, fn, memory_order_relaxed);
+    }
+    uint64_t i = len >= 64 ? fn(dst, src, len, key, delta) : 0;
+    decrypt_rest(dst, src, len, key, delta, i);
+}
+
+// ---------------------------------------------------------------- once
+
+static void futex_wait(_Atomic uint32_t *addr, uint32_t val) {
+#if defined(__linux__)
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+    (void) addr, (void) val;
+    sched_yield();
+#endif
+}
+
+static void futex_wake(_Atomic uint32_t *addr) {
+#if defined(__linux__)
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void) addr;
+#endif
+}
+
+// 返回 1 表示由当前线程执行初始化，返回 0 表示已经由其他线程完成
+static int once_begin(uint32_t *guard) {
+    _Atomic uint32_t *g = (_Atomic uint32_t *) guard;
+    uint32_t state = BUER_RT_UNINIT;
+    if (atomic_compare_exchange_strong_explicit(g, &state, BUER_RT_RUNNING, memory_order_acq_rel,
+                                                memory_order_acquire)) {
+        return 1;
+    }
+    while (state != BUER_RT_DONE) {
+        // 先标记有等待者，执行者结束时才需要 futex_wake
+        if (state == BUER_RT_RUNNING &&
+            !atomic_compare_exchange_weak_explicit(g, &state, BUER_RT_WAITING, memory_order_acquire,
+                                                   memory_order_acquire)) {
+            continue;
+        }
+        futex_wait(g, BUER_RT_WAITING);
+        state = atomic_load_explicit(g, memory_order_acquire);
+    }
+    return 0;
+}
+
+static void once_end(uint32_t *guard) {
+    _Atomic uint32_t *g = (_Atomic uint32_t *) guard;
+    if (atomic_exchange_explicit(g, BUER_RT_DONE, memory_order_acq_rel) == BUER_RT_WAITING) {
+        futex_wake(g);
+    }
+}
+
+BUER_RT_API
+void __buer_rt_v1_once(uint32_t *guard, uint8_t *data, uint64_t len, const uint8_t *key, uint8_t delta) {
+    if (once_begin(guard)) {
+        __buer_rt_v1_decrypt(data, data, len, key, delta);
+        once_end(guard);
+    }
+}
+
+// ---------------------------------------------------------------- resolve
+
+BUER_RT_API
+void __buer_rt_v1_resolve(uint32_t *guard, void **table, uint32_t count, const uint8_t *names, uint64_t len,
+                          const uint8_t *key, uint8_t delta, const uint32_t *offsets, uintptr_t enc_key) {
+    if (!once_begin(guard)) {
+        return;
+    }
+    uint8_t stack[4096];
+    uint8_t *plain = len <= sizeof(stack) ? stack : (uint8_t *) malloc(len);
+    if (!plain) {
+        abort();
+    }
+    __buer_rt_v1_decrypt(plain, names, len, key, delta);
+    for (uint32_t i = 0; i < count; i++) {
+        const char *name = (const char *) plain + offsets[i];
+        void *sym = dlsym(RTLD_DEFAULT, name);
+        // 找不到时表项只剩 enc_key，调用会跳到无意义的地址，在这里终止并给出名字
+        if (!sym) {
+            fprintf(stderr, "buer_rt: cannot resolve %s\n", name);
+            abort();
+        }
+        table[i] = (void *) ((uintptr_t) sym + enc_key);
+    }
+    // 明文不能留在栈上或堆上，内存屏障阻止编译器删除 memset
+    memset(plain, 0, len);
+    __asm__ __volatile__("" : : "r"(plain) : "memory");
+    if (plain != stack) {
+        free(plain);
+    }
+    once_end(guard);
+}
+
+// ---------------------------------------------------------------- crc32c
+
+#define CRC32C_POLY 0x82f63b78u // 反射形式
+#define CRC32C_LONG 8192        // 三路并行的段长，必须是 2 的幂
+#define CRC32C_SHORT 256
+
+static uint32_t crc32c_table[8][256];       // 查表实现，slice-by-8
+static uint32_t crc32c_long[4][256];        // 在 crc 后追加 CRC32C_LONG 个 0 字节的变换
+static uint32_t crc32c_short[4][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    for (; vec; vec >>= 1, mat++) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+    }
+    return sum;
+}
+
+static void gf2_matrix_square(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+// 追加 len（2 的幂）个 0 字节的线性变换，按字节展开成 4 张表
+static void crc32c_zeros(uint32_t zeros[4][256], uint64_t len) {
+    uint32_t even[32], odd[32];
+    odd[0] = CRC32C_POLY; // 1 个 0 bit
+    for (int n = 1; n < 32; n++) {
+        odd[n] = 1u << (n - 1);
+    }
+    gf2_matrix_square(even, odd); // 2 bit
+    gf2_matrix_square(odd, even); // 4 bit
+    const uint32_t *op = odd;
+    for (;;) {
+        gf2_matrix_square(even, odd); // 第一次平方后为 1 字节
+        len >>= 1;
+        if (!len) {
+            op = even;
+            break;
+        }
+        gf2_matrix_square(odd, even);
+        len >>= 1;
+        if (!len) {
+            op = odd;
+            break;
+        }
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        zeros[0][n] = gf2_matrix_times(op, n);
+        zeros[1][n] = gf2_matrix_times(op, n << 8);
+        zeros[2][n] = gf2_matrix_times(op, n << 16);
+        zeros[3][n] = gf2_matrix_times(op, n << 24);
+    }
+}
+
+static void crc32c_init(void) {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+        }
+        crc32c_table[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t c = crc32c_table[k - 1][n];
+            crc32c_table[k][n] = (c >> 8) ^ crc32c_table[0][c & 0xff];
+        }
+    }
+    crc32c_zeros(crc32c_long, CRC32C_LONG);
+    crc32c_zeros(crc32c_short, CRC32C_SHORT);
+}
+
+static inline uint32_t crc32c_shift(uint32_t zeros[4][256], uint32_t crc) {
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^ zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+static uint32_t load32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// crc 为取反后的中间状态
+static uint32_t crc32c_soft(uint32_t crc, const uint8_t *p, uint64_t len) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; len >= 8; len -= 8, p += 8) {
+        uint32_t lo = crc ^ load32(p), hi = load32(p + 4);
+        crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+              crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+              crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+              crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+    }
+#endif
+    for (; len; len--) {
+        crc = (crc >> 8) ^ crc32c_table[0][(crc ^ *p++) & 0xff];
+    }
+    return crc;
+}
+
+// 三条独立的 crc 指令链分别计算相邻的三段，再用 0 字节变换合并，避开 crc 指令 3 个周期的延迟
+#define CRC32C_HW_BLOCKS(CRC64, block, zeros)                                   \
+    for (; len >= (block) * 3; len -= (block) * 3, p += (block) * 2) {          \
+        uint64_t crc1 = 0, crc2 = 0;                                            \
+        for (const uint8_t *end = p + (block); p < end; p += 8) {               \
+            uint64_t v0, v1, v2;                                                \
+            memcpy(&v0, p, 8);                                                  \
+            memcpy(&v1, p + (block), 8);                                        \
+            memcpy(&v2, p + (block) * 2, 8);                                    \
+            crc0 = CRC64(crc0, v0);                                             \
+            crc1 = CRC64(crc1, v1);                                             \
+            crc2 = CRC64(crc2, v2);                                             \
+        }                                                                       \
+        crc0 = crc32c_shift(zeros, (uint32_t) crc0) ^ (uint32_t) crc1;          \
+        crc0 = crc32c_shift(zeros, (uint32_t) crc0) ^ (uint32_t) crc2;          \
+    }
+
+#define CRC32C_HW_BODY(CRC8, CRC64)                                             \
+    uint64_t crc0 = crc;                                                        \
+    for (; len && ((uintptr_t) p & 7); len--) {                                 \
+        crc0 = CRC8((uint32_t) crc0, *p++);                                     \
+    }                                                                           \
+    CRC32C_HW_BLOCKS(CRC64, CRC32C_LONG, crc32c_long)                           \
+    CRC32C_HW_BLOCKS(CRC64, CRC32C_SHORT, crc32c_short)                         \
+    for (; len >= 8; len -= 8, p += 8) {                                        \
+        uint64_t v;                                                             \
+        memcpy(&v, p, 8);                                                       \
+        crc0 = CRC64(crc0, v);                                                  \
+    }                                                                           \
+    for (; len; len--) {                                                        \
+        crc0 = CRC8((uint32_t) crc0, *p++);                                     \
+    }                                                                           \
+    return (uint32_t) crc0;
+
+typedef uint32_t (*crc32c_fn)(uint32_t crc, const uint8_t *p, uint64_t len);
+
+#if defined(__x86_64__) && !defined(BUER_RT_NO_HW_CRC)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, uint64_t len) {
+    CRC32C_HW_BODY(_mm_crc32_u8, _mm_crc32_u64)
+}
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__) && !defined(BUER_RT_NO_HW_CRC)
+static uint32_t crc32c_arm(uint32_t crc, const uint8_t *p, uint64_t len) {
+    CRC32C_HW_BODY(__crc32cb, __crc32cd)
+}
+#endif
+
+static _Atomic(crc32c_fn) crc32c_impl;
+
+static crc32c_fn select_crc32c(void) {
+    pthread_once(&crc32c_once, crc32c_init);
+#if defined(__x86_64__) && !defined(BUER_RT_NO_HW_CRC)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32c_sse42;
+    }
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__) && !defined(BUER_RT_NO_HW_CRC)
+    return crc32c_arm;
+#endif
+    return crc32c_soft;
+}
+
+BUER_RT_API
+uint32_t __buer_rt_v1_crc32c(uint32_t crc, const uint8_t *data, uint64_t len) {
+    crc32c_fn fn = atomic_load_explicit(&crc32c_impl, memory_order_acquire);
+    if (!fn) {
+        fn = select_crc32c();
+        atomic_store_explicit(&crc32c_impl, fn, memory_order_release);
+    }
+    return ~fn(~crc, data, len);
+}
+
+// ---------------------------------------------------------------- integrity
+
+#define BUER_RT_IC_MAX 16
+
+struct ic_range {
+    const uint8_t *begin;
+    const uint8_t *end;
+    const volatile uint32_t *expected;
+};
+
+static pthread_mutex_t ic_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ic_range ic_ranges[BUER_RT_IC_MAX];
+static uint32_t ic_count;
+static uint32_t ic_interval_ms;
+static uint64_t ic_chunk;
+static int ic_started;
+static _Atomic uint64_t ic_bytes, ic_cpu_ns, ic_rounds;
+
+static uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = {(time_t) (ns / 1000000000u), (long) (ns % 1000000000u)};
+    while (nanosleep(&ts, &ts)) {
+    }
+}
+
+// 不接收信号、只在 CPU 空闲时运行，避免与业务线程竞争
+static void ic_lower_priority(void) {
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, NULL);
+#if defined(SCHED_IDLE)
+    struct sched_param param = {0};
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0) {
+        return;
+    }
+#endif
+#if defined(__linux__)
+    setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), 19); // Linux 上 nice 值按线程生效
+#endif
+}
+
+static void *ic_main(void *arg) {
+    (void) arg;
+    ic_lower_priority();
+    struct ic_range ranges[BUER_RT_IC_MAX];
+    for (;;) {
+        pthread_mutex_lock(&ic_lock);
+        uint32_t count = ic_count;
+        memcpy(ranges, ic_ranges, sizeof(ranges[0]) * count);
+        uint64_t interval = ic_interval_ms, chunk = ic_chunk;
+        pthread_mutex_unlock(&ic_lock);
+        // 一轮的计算均匀分散到 interval 内
+        uint64_t chunks = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            chunks += ((uint64_t) (ranges[i].end - ranges[i].begin) + chunk - 1) / chunk;
+        }
+        uint64_t pause = interval * 1000000u / (chunks ? chunks : 1);
+        if (!chunks) {
+            sleep_ns(pause);
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t expected = *ranges[i].expected;
+            uint32_t crc = 0;
+            for (const uint8_t *p = ranges[i].begin; p < ranges[i].end; p += chunk) {
+                sleep_ns(pause);
+                uint64_t len = (uint64_t) (ranges[i].end - p) < chunk ? (uint64_t) (ranges[i].end - p) : chunk;
+                if (!expected) {
+                    continue; // 未经 ic_patch.py 写入期望值，仍按同样的节奏休眠
+                }
+                uint64_t start = thread_cpu_ns();
+                crc = __buer_rt_v1_crc32c(crc, p, len);
+                atomic_fetch_add_explicit(&ic_cpu_ns, thread_cpu_ns() - start, memory_order_relaxed);
+                atomic_fetch_add_explicit(&ic_bytes, len, memory_order_relaxed);
+            }
+            if (expected && crc != expected) {
+                abort();
+            }
+        }
+        atomic_fetch_add_explicit(&ic_rounds, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+BUER_RT_API
+void __buer_rt_v1_ic_register(const uint8_t *begin, const uint8_t *end, const uint32_t *expected,
+                              uint32_t interval_ms, uint32_t chunk_kb) {
+    pthread_mutex_lock(&ic_lock);
+    // 同一个 so 中每个 module 都会登记同一个区间
+    uint32_t i = 0;
+    for (; i < ic_count && ic_ranges[i].begin != begin; i++) {
+    }
+    if (i == ic_count && ic_count < BUER_RT_IC_MAX && begin < end) {
+        ic_ranges[ic_count++] = (struct ic_range) {begin, end, expected};
+    }
+    if (!ic_interval_ms || interval_ms < ic_interval_ms) {
+        ic_interval_ms = interval_ms ? interval_ms : 1;
+    }
+    if (!ic_chunk || (uint64_t) chunk_kb * 1024 < ic_chunk) {
+        ic_chunk = chunk_kb ? (uint64_t) chunk_kb * 1024 : 1024;
+    }
+    if (!ic_started) {
+        pthread_t thread;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        ic_started = pthread_create(&thread, &attr, ic_main, NULL) == 0;
+        pthread_attr_destroy(&attr);
+    }
+    pthread_mutex_unlock(&ic_lock);
+}
+
+BUER_RT_API
+void __buer_rt_v1_ic_stats(uint64_t *bytes, uint64_t *cpu_ns, uint64_t *rounds) {
+    *bytes = atomic_load_explicit(&ic_bytes, memory_order_relaxed);
+    *cpu_ns = atomic_load_explicit(&ic_cpu_ns, memory_order_relaxed);
+    *rounds = atomic_load_explicit(&ic_rounds, memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------- profile
+
+// 最后一行不分配，作为共用行
+#define BUER_RT_PROF_OWNED (BUER_RT_PROF_SLOTS - 1)
+
+BUER_RT_API __thread uint32_t __buer_rt_v1_prof_slot __attribute__((tls_model("initial-exec")));
+
+static _Atomic uint64_t prof_used; // 已分配行的位图
+static pthread_key_t prof_key;
+static pthread_once_t prof_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t prof_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void prof_release(void *value) {
+    uint32_t slot = (uint32_t) (uintptr_t) value - 1;
+    atomic_fetch_and_explicit(&prof_used, ~(1ull << slot), memory_order_release);
+}
+
+static void prof_init(void) {
+    pthread_key_create(&prof_key, prof_release);
+}
+
+BUER_RT_API
+uint32_t __buer_rt_v1_prof_thread(void) {
+    pthread_once(&prof_once, prof_init);
+    const uint64_t owned = (1ull << BUER_RT_PROF_OWNED) - 1;
+    uint32_t slot = BUER_RT_PROF_OWNED;
+    uint64_t used = atomic_load_explicit(&prof_used, memory_order_relaxed);
+    while (~used & owned) {
+        uint32_t free = (uint32_t) __builtin_ctzll(~used & owned);
+        if (atomic_compare_exchange_weak_explicit(&prof_used, &used, used | 1ull << free,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            slot = free;
+            pthread_setspecific(prof_key, (void *) (uintptr_t) (slot + 1));
+            break;
+        }
+    }
+    // 行被后来的线程复用时计数继续累加，导出时只看总和
+    __buer_rt_v1_prof_slot = slot + 1;
+    return slot + 1;
+}
+
+BUER_RT_API
+void __buer_rt_v1_prof_dump(uint32_t module, const uint64_t *counters, uint32_t count, uint32_t stride) {
+    char buf[64];
+    const char *path = getenv("BUER_PROF_FILE");
+    if (!path || !*path) {
+        snprintf(buf, sizeof(buf), "buer-prof.%d.txt", (int) getpid());
+        path = buf;
+    }
+    pthread_mutex_lock(&prof_lock);
+    FILE *out = fopen(path, "a");
+    if (out) {
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t sum = 0;
+            for (uint32_t s = 0; s < BUER_RT_PROF_SLOTS; s++) {
+                sum += __atomic_load_n(&counters[(uint64_t) s * stride + i], __ATOMIC_RELAXED);
+            }
+            if (sum) {
+                fprintf(out, "%08x %u %llu\n", module, i, (unsigned long long) sum);
+            }
+        }
+        fclose(out);
+    }
+    pthread_mutex_unlock(&prof_lock);
+}
@@ -0,0 +1,64 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "utils/Budget.h"
+#include "utils/Report.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+using namespace llvm;
+
+const uint64_t BudgetTracker::MinFunctionBase;
+
+BudgetTracker::BudgetTracker(ObfuscationOptions *Options, StringRef Pass, Module &M)
+        : Options(Options), Pass(Pass.str()) {
+    moduleBase = ModuleSize::of(M).instructions;
+    moduleStart = functionStart = clock::now();
+}
+
+uint64_t BudgetTracker::remaining(Function &F) {
+    ObfuscationBudget &config = Options->Budget;
+    auto it = usage.find(&F);
+    if (it == usage.end()) {
+        it = usage.insert({&F, FunctionUsage{F.getInstructionCount(), 0}}).first;
+    }
+    FunctionUsage &fu = it->second;
+    uint64_t result = UINT64_MAX;
+    if (config.func_growth > 0) {
+        uint64_t limit = std::max(fu.base, MinFunctionBase) * config.func_growth / 100;
+        result = limit > fu.added ? limit - fu.added : 0;
+    }
+    if (config.module_growth > 0) {
+        uint64_t limit = std::max(moduleBase, MinFunctionBase) * config.module_growth / 100;
+        result = std::min(result, limit > moduleAdded ? limit - moduleAdded : 0);
+    }
+    return result;
+}
+
+void BudgetTracker::charge(Function &F, uint64_t Added) {
+    usage[&F].added += Added;
+    moduleAdded += Added;
+}
+
+void BudgetTracker::startFunction() {
+    functionStart = clock::now();
+}
+
+bool BudgetTracker::functionTimeExceeded() const {
+    int limit = Options->Budget.func_time;
+    return limit > 0 && clock::now() - functionStart > std::chrono::milliseconds(limit);
+}
+
+bool BudgetTracker::moduleTimeExceeded() const {
+    int limit = Options->Budget.module_time;
+    return limit > 0 && clock::now() - moduleStart > std::chrono::milliseconds(limit);
+}
+
+void BudgetTracker::degrade(const GlobalValue &GV, StringRef Message) const {
+    IF_VERBOSE {
+        outs() << fmt::format(fmt::fg(fmt::color::yellow),
+                              "{}: Degrade {}: {}\n", Pass, GV.getName().str(), Message.str());
+    }
+    report->addNote(Pass, GV.getName(), Message);
+}
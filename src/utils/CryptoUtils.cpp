@@ -147,6 +147,7 @@ CryptoUtils::~CryptoUtils() {
 void CryptoUtils::populate_pool() {
 
     statsPopulate++;
+    refills++;
 
     for (int i = 0; i < CryptoUtils_POOL_SIZE; i += 16) {
 
@@ -0,0 +1,121 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "utils/OpaquePredicate.h"
+#include "utils/CryptoUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+
+using namespace llvm;
+
+// 非 internal 且加入 llvm.compiler.used，GlobalOpt 与 LTO 内部化后都无法折叠为常量
+// 初值随机即可，不同 module 合并为同一个变量不影响谓词
+GlobalVariable *OpaquePredicateFactory::getGlobal(StringRef Name, bool ThreadLocal) {
+    if (GlobalVariable *GV = M.getGlobalVariable(Name)) {
+        return GV;
+    }
+    Type *I32Ty = Type::getInt32Ty(M.getContext());
+    auto *GV = new GlobalVariable(M, I32Ty, false, GlobalValue::LinkOnceODRLinkage,
+                                  ConstantInt::get(I32Ty, crypto->get_uint32_t()), Name);
+    GV->setVisibility(GlobalValue::HiddenVisibility);
+    if (ThreadLocal) {
+        // hidden 的 general dynamic 在链接时会按产物类型放宽为 local dynamic / local exec
+        GV->setThreadLocalMode(GlobalValue::GeneralDynamicTLSModel);
+    }
+    appendToCompilerUsed(M, {GV});
+    return GV;
+}
+
+static Value *integerArgument(IRBuilder<> &IRB) {
+    Function *F = IRB.GetInsertBlock()->getParent();
+    std::vector<Argument *> Args;
+    for (auto &Arg: F->args()) {
+        if (Arg.getType()->isIntegerTy() && Arg.getType()->getIntegerBitWidth() > 1) {
+            Args.push_back(&Arg);
+        }
+    }
+    if (Args.empty()) {
+        return nullptr;
+    }
+    return IRB.CreateZExtOrTrunc(Args[crypto->get_range(Args.size())], IRB.getInt32Ty());
+}
+
+OpaqueTier OpaquePredicateFactory::choose(Function &F, OpaqueTier MinTier) {
+    if (MinTier != OpaqueTier::ALU) {
+        return MinTier;
+    }
+    if (F.hasLocalLinkage()) {
+        return OpaqueTier::Global;
+    }
+    for (auto &Arg: F.args()) {
+        if (Arg.getType()->isIntegerTy() && Arg.getType()->getIntegerBitWidth() > 1) {
+            return OpaqueTier::ALU;
+        }
+    }
+    return OpaqueTier::Global;
+}
+
+Value *OpaquePredicateFactory::getOperand(IRBuilder<> &IRB, OpaqueTier Tier) {
+    if (Tier == OpaqueTier::ALU) {
+        if (Value *Arg = integerArgument(IRB)) {
+            return Arg;
+        }
+        Tier = OpaqueTier::Global;
+    }
+    if (Tier == OpaqueTier::Global) {
+        return IRB.CreateLoad(IRB.getInt32Ty(), getGlobal("buer.opaque.x", false));
+    }
+    // 每次求值后 x = x * K + C，谓词对任意 x 成立，改写不影响结果；各线程互不干扰
+    GlobalVariable *State = getGlobal("buer.opaque.tls", true);
+    Value *X = IRB.CreateLoad(IRB.getInt32Ty(), State);
+    Value *Next = IRB.CreateAdd(IRB.CreateMul(X, IRB.getInt32(crypto->get_uint32_t() | 1)),
+                                IRB.getInt32(crypto->get_uint32_t()));
+    IRB.CreateStore(Next, State);
+    return X;
+}
+
+Value *OpaquePredicateFactory::create(IRBuilder<> &IRB, OpaqueTier Tier, bool Truth, Value *&X) {
+    X = getOperand(IRB, Tier);
+    if (crypto->get_range(2)) {
+        // x * (x + 1) 恒为偶数
+        Value *Product = IRB.CreateMul(X, IRB.CreateAdd(X, IRB.getInt32(1)));
+        Value *Odd = IRB.CreateAnd(Product, IRB.getInt32(1));
+        return Truth ? IRB.CreateICmpEQ(Odd, IRB.getInt32(0)) : IRB.CreateICmpNE(Odd, IRB.getInt32(0));
+    }
+    // 7 * y^2 - 1 != x^2：左边模 8 只能是 3/6/7，右边模 8 只能是 0/1/4
+    // ALU 等级的 y 由 x 异或随机常量得到，其他等级另读一个全局变量
+    Value *Y = Tier == OpaqueTier::ALU && !isa<LoadInst>(X)
+               ? IRB.CreateXor(X, IRB.getInt32(crypto->get_uint32_t()))
+               : IRB.CreateLoad(IRB.getInt32Ty(), getGlobal("buer.opaque.y", false));
+    Value *L = IRB.CreateSub(IRB.CreateMul(IRB.CreateMul(Y, Y), IRB.getInt32(7)), IRB.getInt32(1));
+    Value *R = IRB.CreateMul(X, X);
+    return Truth ? IRB.CreateICmpNE(L, R) : IRB.CreateICmpEQ(L, R);
+}
+
+static uint64_t value(InstructionCost C) {
+    return C.isValid() ? (uint64_t) std::max<int64_t>(*C.getValue(), 0) : 1;
+}
+
+uint64_t OpaquePredicateFactory::cost(TargetTransformInfo &TTI, LLVMContext &Ctx, OpaqueTier Tier) {
+    auto Kind = TargetTransformInfo::TCK_Latency;
+    Type *I32Ty = Type::getInt32Ty(Ctx);
+    uint64_t Mul = value(TTI.getArithmeticInstrCost(Instruction::Mul, I32Ty, Kind));
+    uint64_t Add = value(TTI.getArithmeticInstrCost(Instruction::Add, I32Ty, Kind));
+    uint64_t Cmp = value(TTI.getCmpSelInstrCost(Instruction::ICmp, I32Ty, Type::getInt1Ty(Ctx),
+                                                CmpInst::ICMP_EQ, Kind));
+    uint64_t Load = value(TTI.getMemoryOpCost(Instruction::Load, I32Ty, Align(4), 0, Kind));
+    // 两种谓词取较长的一种：3 次乘法 + 减法 + 比较
+    uint64_t result = 3 * Mul + Add + Cmp;
+    switch (Tier) {
+        case OpaqueTier::ALU:
+            return result + Add;
+        case OpaqueTier::Global:
+            return result + 2 * Load;
+        case OpaqueTier::ThreadLocal: {
+            // 线程局部变量的地址计算按一次额外访存估计，另有状态更新的乘加与写回
+            uint64_t Store = value(TTI.getMemoryOpCost(Instruction::Store, I32Ty, Align(4), 0, Kind));
+            return result + 3 * Load + Mul + Add + Store;
+        }
+    }
+    return result;
+}
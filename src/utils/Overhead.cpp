@@ -0,0 +1,373 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "utils/Overhead.h"
+#include "core/ApiHiding.h"
+#include "core/BogusControlFlow.h"
+#include "core/Flattening.h"
+#include "core/GVMerge.h"
+#include "core/IndirectCall.h"
+#include "core/Substitution.h"
+#include "core/SwitchEncoding.h"
+#include "utils/OpaquePredicate.h"
+#include "utils/Utils.h"
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <cmath>
+#include <set>
+
+using namespace llvm;
+
+uint64_t OverheadEstimator::cost(TargetTransformInfo &TTI, Instruction &I,
+                                 TargetTransformInfo::TargetCostKind Kind) {
+    InstructionCost C = TTI.getInstructionCost(&I, Kind);
+    if (!C.isValid()) {
+        return 1;
+    }
+    return (uint64_t) std::max<int64_t>(*C.getValue(), 0);
+}
+
+uint64_t OverheadEstimator::size(Function &F) {
+    auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+    uint64_t result = 0;
+    for (auto &BB: F) {
+        for (auto &I: BB) {
+            result += cost(TTI, I, TargetTransformInfo::TCK_CodeSize);
+        }
+    }
+    return result;
+}
+
+double OverheadEstimator::latency(Function &F) {
+    auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    double result = 0;
+    for (auto &BB: F) {
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        for (auto &I: BB) {
+            result += (double) cost(TTI, I, TargetTransformInfo::TCK_Latency) * freq;
+        }
+    }
+    return result;
+}
+
+std::vector<PassOverhead> OverheadEstimator::estimate(Function &F) {
+    std::vector<PassOverhead> result;
+    // FuncNameObf 与 GVNameObf 只改符号名，StructReorder 与 StackLayout 只改数据布局，FunctionOrder 与 BlockShuffle 只改排列顺序，不影响 .text 与延迟
+    Eligibility fw(Options, Options->FunctionWrapper.enable, F, "fw", FAM);
+    if (fw.function()) {
+        result.push_back(estimateFunctionWrapper(F, fw));
+    }
+    if (toObfuscate(Options->StringEncryption.enable, &F, "se")) {
+        result.push_back(estimateStringEncryption(F));
+    }
+    Eligibility sub(Options, Options->Substitution.enable, F, "sub", FAM);
+    if (sub.function()) {
+        result.push_back(estimateSubstitution(F, sub));
+    }
+    Eligibility swe(Options, Options->SwitchEncoding.enable, F, "swe", FAM);
+    if (swe.function()) {
+        PassOverhead overhead = estimateSwitchEncoding(F, swe);
+        if (overhead.size) {
+            result.push_back(overhead);
+        }
+    }
+    Eligibility fla(Options, Options->Flattening.enable, F, "fla", FAM);
+    if (fla.function() && Flattening::isSupported(F)) {
+        result.push_back(estimateFlattening(F, fla));
+    }
+    Eligibility bcf(Options, Options->BogusControlFlow.enable, F, "bcf", FAM);
+    if (bcf.function()) {
+        result.push_back(estimateBogusControlFlow(F, bcf));
+    }
+    Eligibility icall(Options, Options->IndirectCall.enable, F, "icall", FAM);
+    if (icall.function()) {
+        result.push_back(estimateIndirectCall(F, icall));
+    }
+    Eligibility api(Options, Options->ApiHiding.enable, F, "api", FAM);
+    if (api.function()) {
+        PassOverhead overhead = estimateApiHiding(F, api);
+        if (overhead.size) {
+            result.push_back(overhead);
+        }
+    }
+    // GVMerge 按全局变量选择对象，只有访问了可合并变量的函数才有开销
+    if (Options->GVMerge.enable && !F.isDeclaration()) {
+        PassOverhead overhead = estimateGVMerge(F);
+        if (overhead.size) {
+            result.push_back(overhead);
+        }
+    }
+    return result;
+}
+
+PassOverhead OverheadEstimator::estimateFunctionWrapper(Function &F, const Eligibility &Scope) {
+    PassFunctionWrapper &config = Options->FunctionWrapper;
+    auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    // 每个调用点每轮生成一个包装函数：一次同样的调用 + ret
+    double rounds = (double) Scope.repeat(config.times) * Scope.prob(config.prob) / 100;
+    PassOverhead overhead{"FunctionWrapper"};
+    double size = 0;
+    for (auto &BB: F) {
+        if (!Scope.block(BB)) {
+            continue;
+        }
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        for (auto &I: BB) {
+            auto *CB = dyn_cast<CallBase>(&I);
+            if (!CB || CB->isIndirectCall() || !CB->getCalledFunction() ||
+                CB->getCalledFunction()->getName().startswith("clang.")) {
+                continue;
+            }
+            size += rounds * (double) (cost(TTI, I, TargetTransformInfo::TCK_CodeSize) + 1);
+            overhead.latency += rounds * (double) (cost(TTI, I, TargetTransformInfo::TCK_Latency) + 1) * freq;
+        }
+    }
+    overhead.size = (uint64_t) size;
+    return overhead;
+}
+
+// 函数中引用的私有常量字符串
+static GlobalVariable *getStringOperand(Value *V) {
+    if (auto *CE = dyn_cast<ConstantExpr>(V)) {
+        return getStringOperand(CE->getOperand(0));
+    }
+    auto *GV = dyn_cast<GlobalVariable>(V);
+    if (GV && GV->isConstant() && GV->hasLocalLinkage() && GV->hasInitializer() &&
+        isa<ConstantDataArray>(GV->getInitializer())) {
+        return GV;
+    }
+    return nullptr;
+}
+
+PassOverhead OverheadEstimator::estimateStringEncryption(Function &F) {
+    PassStringEncryption &config = Options->StringEncryption;
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    PassOverhead overhead{"StringEncryption"};
+    if (config.mode == 1) {
+        return overhead; // 构造函数中解密，不影响函数本身
+    }
+    std::set<GlobalVariable *> strings;
+    for (auto &BB: F) {
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        std::set<GlobalVariable *> guarded;
+        for (auto &I: BB) {
+            for (auto &Op: I.operands()) {
+                GlobalVariable *GV = getStringOperand(Op.get());
+                if (!GV) {
+                    continue;
+                }
+                strings.insert(GV);
+                // 懒解密：每个基本块第一次使用前 load + icmp + br，慢路径的 call 不计入延迟
+                if (config.mode == 0 && guarded.insert(GV).second) {
+                    overhead.size += 4;
+                    overhead.latency += 3 * freq;
+                }
+            }
+        }
+    }
+    if (config.mode == 2) {
+        // 栈模式：每次调用都要把用到的字符串解密一遍，每 16 字节约 4 条向量指令
+        for (GlobalVariable *GV: strings) {
+            uint64_t bytes = GV->getParent()->getDataLayout().getTypeAllocSize(GV->getValueType());
+            overhead.size += 7;
+            overhead.latency += 10 + (double) (bytes / 16 + bytes % 16) * 4;
+        }
+    }
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateSubstitution(Function &F, const Eligibility &Scope) {
+    PassSubstitution &config = Options->Substitution;
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    // 每条被改写的运算最多新增 expansion(depth) - 1 条单周期 ALU 指令
+    int depth = Scope.repeat(config.depth);
+    double added = (double) (Substitution::expansion(depth) - 1) * Scope.prob(config.prob) / 100;
+    PassOverhead overhead{"Substitution"};
+    double size = 0;
+    for (auto &BB: F) {
+        if (!Scope.block(BB)) {
+            continue;
+        }
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        for (auto &I: BB) {
+            if (Substitution::isCandidate(I)) {
+                size += added;
+                overhead.latency += added * freq;
+            }
+        }
+    }
+    // pass 自身的延迟预算会截断改写，体积按同样比例缩小
+    if (config.budget && overhead.latency > 0) {
+        double cap = latency(F) * config.budget / 100;
+        if (overhead.latency > cap) {
+            size *= cap / overhead.latency;
+            overhead.latency = cap;
+        }
+    }
+    overhead.size = (uint64_t) size;
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateFlattening(Function &F, const Eligibility &Scope) {
+    PassFlattening &config = Options->Flattening;
+    auto &LI = FAM.getResult<LoopAnalysis>(F);
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    auto Hot = Flattening::hotLoopBlocks(LI, BFI, config.hot);
+    for (auto &BB: F) {
+        if (!Scope.block(BB)) {
+            Hot.insert(&BB);
+        }
+    }
+    // 每次经过分发块：store + volatile load + 解码 2 条 + 间接跳转；稀疏 switch 按比较树深度计算
+    size_t targets = 0;
+    for (auto &BB: F) {
+        targets += !Hot.count(&BB);
+    }
+    double dispatch = config.mode == 0 ? 5 : 2 + std::log2((double) std::max<size_t>(targets, 2)) * 2;
+    PassOverhead overhead{"Flattening"};
+    overhead.size = 4;
+    for (auto &BB: F) {
+        if (Hot.count(&BB) || !BB.getTerminator() || !BB.getTerminator()->getNumSuccessors()) {
+            continue;
+        }
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        overhead.size += 3;
+        overhead.latency += dispatch * freq;
+    }
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateBogusControlFlow(Function &F, const Eligibility &Scope) {
+    PassBogusControlFlow &config = Options->BogusControlFlow;
+    auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    double rate = (double) Scope.prob(config.prob) / 100;
+    // 每个块：一个不透明谓词 + 条件跳转，虚假块从不执行只计体积；另有一个垃圾函数
+    OpaqueTier Tier = OpaquePredicateFactory::choose(F, (OpaqueTier) config.strength);
+    double predicate = (double) OpaquePredicateFactory::cost(TTI, F.getContext(), Tier) + 1;
+    PassOverhead overhead{"BogusControlFlow"};
+    double size = 12;
+    for (auto &BB: F) {
+        if (BB.isEHPad() || !Scope.block(BB)) {
+            continue;
+        }
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        size += rate * BogusControlFlow::BlockCost;
+        overhead.latency += rate * predicate * freq;
+    }
+    overhead.size = (uint64_t) size;
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateIndirectCall(Function &F, const Eligibility &Scope) {
+    PassIndirectCall &config = Options->IndirectCall;
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    double rate = (double) Scope.prob(config.prob) / 100;
+    // 每个调用点：读表 + 减去密钥，间接调用比直接调用多一次分支目标预测；入口处读一次密钥
+    PassOverhead overhead{"IndirectCall"};
+    double size = 0;
+    for (auto &BB: F) {
+        if (!Scope.block(BB)) {
+            continue;
+        }
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        for (auto &I: BB) {
+            auto *CB = dyn_cast<CallBase>(&I);
+            if (!CB || !IndirectCall::isCandidate(*CB)) {
+                continue;
+            }
+            size += rate * IndirectCall::CallCost;
+            overhead.latency += rate * 6 * freq;
+        }
+    }
+    if (size > 0) {
+        size += 1;
+        overhead.latency += 4;
+    }
+    overhead.size = (uint64_t) size;
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateGVMerge(Function &F) {
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    // 每处访问：编码偏移减去密钥 + 基址加偏移；入口处读一次密钥
+    PassOverhead overhead{"GVMerge"};
+    for (auto &BB: F) {
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        for (auto &I: BB) {
+            for (Value *Op: I.operands()) {
+                auto *GV = dyn_cast<GlobalVariable>(Op->stripPointerCasts());
+                if (GV && GVMerge::isCandidate(*GV)) {
+                    overhead.size += GVMerge::UseCost;
+                    overhead.latency += 2 * freq;
+                }
+            }
+        }
+    }
+    if (overhead.size > 0) {
+        overhead.size += 1;
+        overhead.latency += 4;
+    }
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateApiHiding(Function &F, const Eligibility &Scope) {
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    auto &TLI = FAM.getResult<TargetLibraryAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    // 调用点不变，每次调用多经过一次包装函数：guard 检查 + 读表 + 解码 + 间接调用；包装函数按被调函数计入体积
+    PassOverhead overhead{"ApiHiding"};
+    std::set<Function *> Callees;
+    for (auto &BB: F) {
+        if (!Scope.block(BB)) {
+            continue;
+        }
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        for (auto &I: BB) {
+            auto *CB = dyn_cast<CallBase>(&I);
+            if (CB && ApiHiding::isCandidate(*CB, TLI, Options->ApiHiding.symbols)) {
+                overhead.latency += 6 * freq;
+                Callees.insert(CB->getCalledFunction());
+            }
+        }
+    }
+    overhead.size = Callees.size() * ApiHiding::WrapperCost;
+    return overhead;
+}
+
+PassOverhead OverheadEstimator::estimateSwitchEncoding(Function &F, const Eligibility &Scope) {
+    auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+    double entry = (double) BFI.getEntryFreq();
+    PassOverhead overhead{"SwitchEncoding"};
+    for (auto &BB: F) {
+        if (!Scope.block(BB)) {
+            continue;
+        }
+        auto *SI = dyn_cast<SwitchInst>(BB.getTerminator());
+        if (!SI || !SwitchEncoding::isCandidate(*SI)) {
+            continue;
+        }
+        unsigned cases = 0;
+        for (auto Case: SI->cases()) {
+            cases += Case.getCaseSuccessor() != SI->getDefaultDest();
+        }
+        if (cases < (unsigned) std::max(Options->SwitchEncoding.min, 1)) {
+            continue;
+        }
+        // 哈希中的乘法与两次相互依赖的查表在关键路径上，原来的比较树 / 跳转表边界检查可以抵消一部分
+        double freq = (double) BFI.getBlockFreq(&BB).getFrequency() / entry;
+        overhead.size += SwitchEncoding::DispatchCost;
+        overhead.latency += 10 * freq;
+    }
+    return overhead;
+}
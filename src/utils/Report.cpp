@@ -0,0 +1,306 @@
+//
+// Created by Ylarod on 2026/10/19.
+//
+
+#include "utils/Report.h"
+#include "utils/CryptoUtils.h"
+#include "Version.h"
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/xxhash.h>
+#include <fstream>
+#include <sys/resource.h>
+
+using namespace llvm;
+
+namespace llvm {
+    ManagedStatic<ObfuscationReport> report;
+}
+
+ModuleSize ModuleSize::of(Module &M) {
+    ModuleSize size;
+    for (auto &F: M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        size.functions++;
+        for (auto &BB: F) {
+            size.blocks++;
+            size.instructions += BB.size();
+        }
+    }
+    return size;
+}
+
+MemorySample MemorySample::now() {
+    MemorySample sample;
+    sample.heap = sys::Process::GetMallocUsage();
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+        sample.peak = usage.ru_maxrss;
+#else
+        sample.peak = usage.ru_maxrss * 1024;
+#endif
+    }
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (statm >> size >> resident) {
+        sample.rss = resident * sys::Process::getPageSizeEstimate();
+    }
+#else
+    sample.rss = sample.peak; // 没有 /proc 时只能退化为峰值
+#endif
+    return sample;
+}
+
+void ObfuscationReport::addPass(PassRecord Record) {
+    passes.push_back(std::move(Record));
+}
+
+void ObfuscationReport::addNote(StringRef Pass, StringRef Object, StringRef Message) {
+    notes.push_back({Pass.str(), Object.str(), Message.str()});
+}
+
+void ObfuscationReport::addPlan(PlanEntry Entry) {
+    plan.push_back(std::move(Entry));
+}
+
+void ObfuscationReport::addGenerated(StringRef Pass, Function *F, Function *Source) {
+    generated.push_back({Pass.str(), F, Source});
+}
+
+void ObfuscationReport::addRenamed(Function *F, StringRef Original) {
+    renamed.try_emplace(F, Original.str()); // 多次改名时保留最初的名字
+}
+
+void ObfuscationReport::addCounter(Function *F, uint32_t Index) {
+    counters[F] = Index;
+}
+
+void ObfuscationReport::replaceFunction(Function *Old, Function *New) {
+    for (auto &E: plan) {
+        if (E.F == Old) {
+            E.F = New;
+        }
+    }
+    for (auto &G: generated) {
+        if (G.F == Old) {
+            G.F = New;
+        }
+        if (G.source == Old) {
+            G.source = New;
+        }
+    }
+    auto R = renamed.find(Old);
+    if (R != renamed.end()) {
+        std::string Original = std::move(R->second);
+        renamed.erase(R);
+        renamed[New] = std::move(Original);
+    }
+    auto C = counters.find(Old);
+    if (C != counters.end()) {
+        uint32_t Index = C->second;
+        counters.erase(C);
+        counters[New] = Index;
+    }
+}
+
+uint32_t ObfuscationReport::moduleId(const Module &M) {
+    return (uint32_t) xxHash64(M.getModuleIdentifier());
+}
+
+void ObfuscationReport::measure(function_ref<uint64_t(Function &)> Size) {
+    for (auto &E: plan) {
+        if (!E.selected) {
+            continue;
+        }
+        int64_t added = (int64_t) Size(*E.F) - (int64_t) E.baseSize;
+        for (auto &G: generated) {
+            if (G.source == E.F && G.pass == E.pass) {
+                added += (int64_t) Size(*G.F);
+            }
+        }
+        E.measured = added;
+    }
+}
+
+void ObfuscationReport::clear() {
+    passes.clear();
+    notes.clear();
+    plan.clear();
+    generated.clear();
+    renamed.clear();
+    counters.clear();
+}
+
+void ObfuscationReport::write(raw_ostream &OS, Module &M, ObfuscationOptions *Options) const {
+    json::OStream J(OS, 2);
+    auto writeSize = [&J](StringRef Key, const ModuleSize &Before, const ModuleSize &After,
+                          uint64_t ModuleSize::*Field) {
+        J.attributeArray(Key, [&] {
+            J.value(Before.*Field);
+            J.value(After.*Field);
+        });
+    };
+    J.object([&] {
+        J.attribute("module", M.getModuleIdentifier());
+        J.attribute("source", M.getSourceFileName());
+        J.attribute("id", fmt::format("{:08x}", moduleId(M)));
+        J.attribute("version", obf_version_name);
+        J.attribute("fingerprint", fmt::format("{:016x}", Options->fingerprint()));
+        if (Options->mem_profile) {
+            J.attributeObject("crypto", [&] {
+                J.attribute("object_bytes", (uint64_t) sizeof(CryptoUtils));
+                J.attribute("pool_bytes", (uint64_t) CryptoUtils_POOL_SIZE);
+                J.attribute("refills", crypto->get_refills());
+            });
+        }
+        J.attributeArray("passes", [&] {
+            for (auto &P: passes) {
+                J.object([&] {
+                    J.attribute("name", P.pass);
+                    J.attribute("seconds", P.seconds);
+                    writeSize("functions", P.before, P.after, &ModuleSize::functions);
+                    writeSize("blocks", P.before, P.after, &ModuleSize::blocks);
+                    writeSize("instructions", P.before, P.after, &ModuleSize::instructions);
+                    if (P.memory) {
+                        J.attributeObject("memory", [&] {
+                            J.attributeArray("rss", [&] {
+                                J.value(P.memBefore.rss);
+                                J.value(P.memAfter.rss);
+                            });
+                            J.attributeArray("peak_rss", [&] {
+                                J.value(P.memBefore.peak);
+                                J.value(P.memAfter.peak);
+                            });
+                            J.attributeArray("heap", [&] {
+                                J.value(P.memBefore.heap);
+                                J.value(P.memAfter.heap);
+                            });
+                        });
+                    }
+                });
+            }
+        });
+        if (!plan.empty()) {
+            J.attributeObject("plan", [&] {
+                uint64_t baseSize = 0, predicted = 0;
+                for (auto &E: plan) {
+                    if (E.selected) {
+                        predicted += E.size;
+                    }
+                }
+                for (auto &F: M) {
+                    for (auto &E: plan) {
+                        if (E.F == &F) {
+                            baseSize += E.baseSize;
+                            break;
+                        }
+                    }
+                }
+                J.attribute("text_budget", Options->Budget.text_growth);
+                J.attribute("latency_budget", Options->Budget.latency_growth);
+                J.attribute("base_size", baseSize);
+                J.attribute("predicted_size", predicted);
+                J.attributeArray("entries", [&] {
+                    for (auto &E: plan) {
+                        J.object([&] {
+                            J.attribute("function", E.function);
+                            J.attribute("pass", E.pass);
+                            J.attribute("selected", E.selected);
+                            J.attribute("base_size", E.baseSize);
+                            J.attribute("base_latency", E.baseLatency);
+                            J.attribute("predicted_size", E.size);
+                            J.attribute("predicted_latency", E.latency);
+                            if (E.measured >= 0) {
+                                J.attribute("measured_size", E.measured);
+                            }
+                        });
+                    }
+                });
+            });
+        }
+        // 每个函数的 IR 规模、改名前的名字和来源，tools/report/code_size.py 据此把目标文件中的字节数归到生成它的 pass，
+        // tools/report/prof_map.py 据此把 RuntimeProfile 的计数映射回 pass 与来源函数
+        J.attributeArray("functions", [&] {
+            DenseMap<Function *, const GeneratedFunction *> Origins;
+            for (auto &G: generated) {
+                Origins[G.F] = &G;
+            }
+            for (auto &F: M) {
+                if (F.isDeclaration()) {
+                    continue;
+                }
+                J.object([&] {
+                    J.attribute("name", F.getName());
+                    J.attribute("linkage", F.hasPrivateLinkage() ? "private"
+                                           : F.hasLocalLinkage() ? "internal" : "external");
+                    J.attribute("blocks", (uint64_t) F.size());
+                    J.attribute("instructions", (uint64_t) F.getInstructionCount());
+                    auto Renamed = renamed.find(&F);
+                    if (Renamed != renamed.end()) {
+                        J.attribute("original", Renamed->second);
+                    }
+                    auto Counter = counters.find(&F);
+                    if (Counter != counters.end()) {
+                        J.attribute("counter", (uint64_t) Counter->second);
+                    }
+                    auto It = Origins.find(&F);
+                    if (It != Origins.end()) {
+                        J.attribute("pass", It->second->pass);
+                        if (It->second->source) {
+                            J.attribute("source", It->second->source->getName());
+                        }
+                    }
+                });
+            }
+        });
+        J.attributeArray("notes", [&] {
+            for (auto &N: notes) {
+                J.object([&] {
+                    J.attribute("pass", N.pass);
+                    J.attribute("object", N.object);
+                    J.attribute("message", N.message);
+                });
+            }
+        });
+    });
+    OS << "\n";
+}
+
+PassRecorder::PassRecorder(ObfuscationOptions *Options, StringRef Pass, Module &M) : Options(Options), M(M) {
+    Record.pass = Pass.str();
+    Record.before = ModuleSize::of(M);
+    Record.memory = Options->mem_profile;
+    if (Record.memory) {
+        Record.memBefore = MemorySample::now();
+    }
+    start = std::chrono::steady_clock::now();
+}
+
+PassRecorder::~PassRecorder() {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Record.seconds = elapsed.count();
+    Record.after = ModuleSize::of(M);
+    if (Record.memory) {
+        Record.memAfter = MemorySample::now();
+        IF_VERBOSE {
+            auto delta = [](uint64_t Before, uint64_t After) {
+                return (int64_t) After - (int64_t) Before;
+            };
+            outs() << fmt::format(fmt::fg(fmt::color::sky_blue),
+                                  "{}: rss {:+} KiB, heap {:+} KiB, functions {:+}, blocks {:+}, instructions {:+}\n",
+                                  Record.pass,
+                                  delta(Record.memBefore.rss, Record.memAfter.rss) / 1024,
+                                  delta(Record.memBefore.heap, Record.memAfter.heap) / 1024,
+                                  delta(Record.before.functions, Record.after.functions),
+                                  delta(Record.before.blocks, Record.after.blocks),
+                                  delta(Record.before.instructions, Record.after.instructions));
+        }
+    }
+    report->addPass(std::move(Record));
+}
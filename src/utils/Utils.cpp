@@ -1,4 +1,8 @@
 #include "utils/Utils.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/IR/IntrinsicInst.h>
@@ -43,63 +47,160 @@ namespace llvm {
             DemotePHIToStack(PN, entryBB.getTerminator());
         }
         for (Instruction *I: origReg) {
-            DemoteRegToStack(*I, entryBB.getTerminator());
+            DemoteRegToStack(*I, false, entryBB.getTerminator());
         }
     }
 
-    std::string readAnnotate(GlobalObject *go) {
-        std::string annotation;
+    void fixStack(Function &F, DominatorTree &DT) {
+        // PHI 降级后的 reload 同样可能不再支配所有使用，重复直到没有需要降级的值
+        std::vector<PHINode *> origPHI;
+        std::vector<Instruction *> origReg;
+        BasicBlock &entryBB = F.getEntryBlock();
+        do {
+            origPHI.clear();
+            origReg.clear();
+            for (BasicBlock &BB: F) {
+                SmallPtrSet<BasicBlock *, 8> preds(pred_begin(&BB), pred_end(&BB));
+                for (Instruction &I: BB) {
+                    if (auto *PN = dyn_cast<PHINode>(&I)) {
+                        bool stale = PN->getNumIncomingValues() != pred_size(&BB);
+                        for (BasicBlock *In: PN->blocks()) {
+                            stale |= !preds.count(In);
+                        }
+                        if (stale) {
+                            origPHI.push_back(PN);
+                            continue;
+                        }
+                    }
+                    if (isa<AllocaInst>(&I) && I.getParent() == &entryBB) {
+                        continue;
+                    }
+                    for (Use &U: I.uses()) {
+                        if (!DT.dominates(&I, U)) {
+                            origReg.push_back(&I);
+                            break;
+                        }
+                    }
+                }
+            }
+            for (PHINode *PN: origPHI) {
+                DemotePHIToStack(PN, entryBB.getTerminator());
+            }
+            for (Instruction *I: origReg) {
+                DemoteRegToStack(*I, false, entryBB.getTerminator());
+            }
+        } while (!origPHI.empty() || !origReg.empty());
+    }
+
+    // 由 pass 追加的注解保存在函数属性中，不修改 llvm.global.annotations
+    static const char *AnnotateAttr = "buer.annotate";
+
+    // llvm.global.annotations 按对象建立索引，数组（初始值）变化时重建；逐次线性扫描会让按函数查询注解的 pass 变为平方复杂度
+    static const std::string &readGlobalAnnotations(GlobalObject *go) {
+        static const Module *CachedModule = nullptr;
+        static const Constant *CachedInit = nullptr;
+        static DenseMap<const Value *, std::string> Index;
+        static const std::string Empty;
+        Module *M = go->getParent();
         // Get annotation variable
-        GlobalVariable *glob = go->getParent()->getGlobalVariable("llvm.global.annotations");
-        if (glob == nullptr) {
-            return "";
-        }
-        // Get the array
-        auto *ca = dyn_cast<ConstantArray>(glob->getInitializer());
-        if (ca == nullptr) {
-            return "";
-        }
+        GlobalVariable *glob = M->getGlobalVariable("llvm.global.annotations");
+        const Constant *Init = glob && glob->hasInitializer() ? glob->getInitializer() : nullptr;
+        if (M != CachedModule || Init != CachedInit) {
+            CachedModule = M;
+            CachedInit = Init;
+            Index.clear();
+            // Get the array
+            auto *ca = dyn_cast_or_null<ConstantArray>(Init);
+            for (unsigned i = 0; ca && i < ca->getNumOperands(); ++i) {
+                // Get the struct
+                auto *structAn = dyn_cast<ConstantStruct>(ca->getOperand(i));
+                if (structAn == nullptr) {
+                    continue;
+                }
 
-        for (unsigned i = 0; i < ca->getNumOperands(); ++i) {
-            // Get the struct
-            auto *structAn = dyn_cast<ConstantStruct>(ca->getOperand(i));
-            if (structAn == nullptr) {
-                continue;
-            }
+                auto *expr = dyn_cast<ConstantExpr>(structAn->getOperand(0));
+                // If it's a bitcast we can find the annotated object
+                if (expr == nullptr || expr->getOpcode() != Instruction::BitCast) {
+                    continue;
+                }
 
-            auto *expr = dyn_cast<ConstantExpr>(structAn->getOperand(0));
-            if (expr == nullptr) {
-                continue;
-            }
+                auto *note = dyn_cast<ConstantExpr>(structAn->getOperand(1));
+                // If it's a GetElementPtr, that means we found the variable
+                // containing the annotations
+                if (note == nullptr || note->getOpcode() != Instruction::GetElementPtr) {
+                    continue;
+                }
 
-            // If it's a bitcast we can check if the annotation is concerning
-            // the current function
-            if (expr->getOpcode() != Instruction::BitCast || expr->getOperand(0) != go) {
-                continue;
-            }
+                auto *annotateStr = dyn_cast<GlobalVariable>(note->getOperand(0));
+                if (annotateStr == nullptr || !annotateStr->hasInitializer()) {
+                    continue;
+                }
 
-            auto *note = cast<ConstantExpr>(structAn->getOperand(1));
-            // If it's a GetElementPtr, that means we found the variable
-            // containing the annotations
-            if (note->getOpcode() != Instruction::GetElementPtr) {
-                continue;
+                auto *data = dyn_cast<ConstantDataSequential>(annotateStr->getInitializer());
+                if (data != nullptr && data->isString()) {
+                    // 去掉结尾的 NUL，注解可能被 inheritAnnotate 写入函数属性
+                    StringRef text = data->isCString() ? data->getAsCString() : data->getAsString();
+                    Index[expr->getOperand(0)] += text.lower() + " ";
+                }
             }
+        }
+        auto It = Index.find(go);
+        return It == Index.end() ? Empty : It->second;
+    }
 
-            auto *annotateStr = dyn_cast<GlobalVariable>(note->getOperand(0));
-            if (annotateStr == nullptr) {
-                continue;
+    std::string readAnnotate(GlobalObject *go) {
+        std::string annotation;
+        if (auto *F = dyn_cast<Function>(go)) {
+            if (F->hasFnAttribute(AnnotateAttr)) {
+                annotation += F->getFnAttribute(AnnotateAttr).getValueAsString().lower() + " ";
             }
+        }
+        return annotation + readGlobalAnnotations(go);
+    }
 
-            auto *data = dyn_cast<ConstantDataSequential>(annotateStr->getInitializer());
-            if (data == nullptr) {
-                continue;
-            }
+    void addAnnotate(Function &F, StringRef annotation) {
+        std::string value = annotation.str();
+        if (F.hasFnAttribute(AnnotateAttr)) {
+            value = F.getFnAttribute(AnnotateAttr).getValueAsString().str() + " " + value;
+        }
+        F.addFnAttr(AnnotateAttr, value);
+    }
+
+    void inheritAnnotate(Function &F, GlobalObject *From) {
+        std::string annotation = readAnnotate(From);
+        if (!annotation.empty()) {
+            F.addFnAttr(AnnotateAttr, annotation);
+        }
+    }
 
-            if (data->isString()) {
-                annotation += data->getAsString().lower() + " ";
+    // 作用于函数代码的 pass 的注解名；StructReorder 与 FunctionOrder 只改数据布局和函数顺序，不受影响
+    static const char *const PassAnnotations[] = {
+            "fno", "fw", "se", "sub", "swe", "fla", "bcf", "bs", "sl", "gvm", "api", "icall",
+    };
+
+    void addPassAnnotates(Function &F, bool Enable) {
+        std::string annotate = readAnnotate(&F);
+        std::string value;
+        for (const char *Attr: PassAnnotations) {
+            // 与 toObfuscate 的判断一致：no-<pass> 或 <pass> 出现过都视为显式指定
+            if (annotate.find(Attr) != std::string::npos) {
+                continue;
             }
+            value += (value.empty() ? "" : " ") + std::string(Enable ? "" : "no-") + Attr;
         }
-        return annotation;
+        if (!value.empty()) {
+            addAnnotate(F, value);
+        }
+    }
+
+    static const char *TierAttr = "buer.tier";
+
+    StringRef readTier(const Function &F) {
+        return F.getFnAttribute(TierAttr).getValueAsString();
+    }
+
+    void writeTier(Function &F, StringRef Tier) {
+        F.addFnAttr(TierAttr, Tier);
     }
 
     bool toObfuscate(int flag, GlobalObject *go, const std::string& attribute) {
@@ -138,6 +239,53 @@ namespace llvm {
         abort();
     }
 
+    Eligibility::Eligibility(ObfuscationOptions *Options, int flag, Function &F, const std::string &attribute,
+                             FunctionAnalysisManager &FAM)
+            : Scope(Options->Scope), Tier(Options->Tier), enabled(toObfuscate(flag, &F, attribute)) {
+        light = readTier(F) == "light";
+        if (!enabled || !(Scope.loop_depth || Scope.innermost || Scope.hot)) {
+            return;
+        }
+        cold = F.hasFnAttribute(Attribute::Cold) || (F.getEntryCount() && !F.getEntryCount()->getCount());
+        if (cold) {
+            return;
+        }
+        hot = F.hasFnAttribute(Attribute::Hot);
+        LI = &FAM.getResult<LoopAnalysis>(F);
+        if (Scope.hot) {
+            BFI = &FAM.getResult<BlockFrequencyAnalysis>(F);
+            entry = (double) BFI->getEntryFreq();
+        }
+    }
+
+    bool Eligibility::block(const BasicBlock &BB) const {
+        if (!enabled) {
+            return false;
+        }
+        if (!LI) {
+            return true; // 没有配置阈值或 cold 函数
+        }
+        unsigned depth = LI->getLoopDepth(&BB);
+        if (depth && (hot || (Scope.innermost && LI->getLoopFor(&BB)->isInnermost()))) {
+            return false;
+        }
+        if (Scope.loop_depth && depth >= (unsigned) Scope.loop_depth) {
+            return false;
+        }
+        return !BFI || (double) BFI->getBlockFreq(&BB).getFrequency() / entry < Scope.hot;
+    }
+
+    Function *getRuntimeFunction(Module &M, StringRef Name, FunctionType *FTy) {
+        if (Function *F = M.getFunction(Name)) {
+            return F;
+        }
+        Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage, Name, M);
+        F->setVisibility(GlobalValue::HiddenVisibility);
+        F->setDSOLocal(true);
+        F->addFnAttr(Attribute::NoUnwind);
+        return F;
+    }
+
     void LowerConstantExpr(Function &F) {
         SmallPtrSet<Instruction *, 8> WorkList;
 
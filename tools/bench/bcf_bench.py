@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# BogusControlFlow 基准：生成若干个由菱形分支串联的函数，依次调用以放大指令 cache 压力，分别不混淆、
+# 带分支权重（-obf-bcf-w=1，默认）和不带权重（-obf-bcf-w=0）编译，比较：
+#   ns        每次 run_all 调用的耗时（多轮取最快）
+#   br-miss   每次调用的分支预测失败数
+#   l1i-miss  每次调用的 L1 指令 cache 缺失数
+#   hot / cold  目标文件中 .text 与 .text.unlikely 的字节数
+# 计数由计时程序用 perf_event_open 读取（只统计用户态），虚拟机或 perf_event_paranoid 不允许时显示 n/a。
+#
+# 用法:
+#   tools/bench/bcf_bench.py --plugin out/libObfuscator.so
+#   tools/bench/bcf_bench.py --plugin ... --funcs 512 --stages 32 --flags "-obf-bcf-s=2"
+#
+# 只依赖 python3 标准库、opt / llc 和一个 C 编译器，不联网。
+
+import argparse
+import os
+import random
+import shlex
+import sys
+import tempfile
+
+from benchlib import add_tool_args, build, compile_harness, run
+
+HARNESS = r'''
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+extern uint32_t run_all(uint32_t x);
+
+#define INPUTS (1 << 12)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int open_counter(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static double per_call(int fd, long iters) {
+    uint64_t value = 0;
+    if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+        return -1;
+    }
+    return (double) value / iters;
+}
+
+int main(int argc, char **argv) {
+    long iters = atol(argv[1]);
+    uint32_t *in = malloc(sizeof(uint32_t) * INPUTS);
+    uint64_t s = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < INPUTS; i++) {
+        s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+        in[i] = (uint32_t) (s >> 16);
+    }
+    int misses = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    int icache = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1I | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                                                  PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    double best = 1e30;
+    uint32_t sum = 0;
+    for (int round = 0; round < 5; round++) {
+        // 计数只覆盖最后一轮
+        if (round == 4) {
+            ioctl(misses, PERF_EVENT_IOC_ENABLE, 0);
+            ioctl(icache, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        double t = now();
+        for (long i = 0; i < iters; i++) {
+            sum += run_all(in[i & (INPUTS - 1)]);
+        }
+        t = (now() - t) / iters;
+        best = t < best ? t : best;
+    }
+    ioctl(misses, PERF_EVENT_IOC_DISABLE, 0);
+    ioctl(icache, PERF_EVENT_IOC_DISABLE, 0);
+    printf("%.1f %.2f %.2f %u\n", best, per_call(misses, iters), per_call(icache, iters), sum);
+    return 0;
+}
+'''
+
+
+def gen_module(funcs, stages, rng):
+    """每个函数由 stages 个菱形组成：按当前值的低位选择乘法或异或分支，再合并"""
+    out = []
+    for k in range(funcs):
+        out.append('define internal i32 @f%d(i32 %%x0) noinline {' % k)
+        out.append('entry:')
+        out.append('  br label %s0')
+        for j in range(stages):
+            out.append('s%d:' % j)
+            out.append('  %%l%d = and i32 %%x%d, %d' % (j, j, 1 << rng.randrange(8)))
+            out.append('  %%c%d = icmp eq i32 %%l%d, 0' % (j, j))
+            out.append('  br i1 %%c%d, label %%t%d, label %%e%d' % (j, j, j))
+            out.append('t%d:' % j)
+            out.append('  %%a%d = mul i32 %%x%d, %d' % (j, j, rng.randrange(3, 1 << 20) | 1))
+            out.append('  br label %%m%d' % j)
+            out.append('e%d:' % j)
+            out.append('  %%b%d = xor i32 %%x%d, %d' % (j, j, rng.randrange(1 << 20)))
+            out.append('  br label %%m%d' % j)
+            out.append('m%d:' % j)
+            out.append('  %%x%d = phi i32 [ %%a%d, %%t%d ], [ %%b%d, %%e%d ]' % (j + 1, j, j, j, j))
+            out.append('  br label %%s%d' % (j + 1) if j + 1 < stages else '  br label %exit')
+        out.append('exit:')
+        out.append('  ret i32 %%x%d' % stages)
+        out.append('}')
+    out.append('define i32 @run_all(i32 %v0) {')
+    for k in range(funcs):
+        out.append('  %%v%d = call i32 @f%d(i32 %%v%d)' % (k + 1, k, k))
+    out.append('  ret i32 %%v%d' % funcs)
+    out.append('}')
+    return "\n".join(out) + "\n"
+
+
+def section_sizes(args, obj):
+    """返回 (.text, .text.unlikely) 的字节数"""
+    hot = cold = 0
+    for line in run([args.size, "-A", obj]).splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[1].isdigit():
+            if fields[0] == ".text":
+                hot += int(fields[1])
+            elif fields[0].startswith(".text.unlikely"):
+                cold += int(fields[1])
+    return hot, cold
+
+
+def sized_build(args, ir_path, harness_obj, flags, exe):
+    """构建并返回 llc 输出的目标文件中的 (.text, .text.unlikely) 字节数"""
+    build(args, ir_path, harness_obj, flags, exe)
+    return section_sizes(args, exe + ".o")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Time, branch misses and I-cache misses of bogus control flow")
+    add_tool_args(parser)
+    parser.add_argument("--size", default="size", help="binutils size, used for section sizes")
+    parser.add_argument("--flags", default="", help="extra plugin flags for the obfuscated builds")
+    parser.add_argument("--funcs", type=int, default=256, help="functions called in sequence per call")
+    parser.add_argument("--stages", type=int, default=16, help="diamonds per function")
+    parser.add_argument("--prob", type=int, default=100, help="-obf-bcf-p for the obfuscated builds")
+    parser.add_argument("--iters", type=int, default=20000, help="run_all calls per round")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the generated constants and the plugin PRNG")
+    args = parser.parse_args()
+
+    builds = [("native", [])]
+    for name, weights in (("weights", "1"), ("no weights", "0")):
+        builds.append((name, ["-obf-bcf=2", "-obf-bcf-p=%d" % args.prob, "-obf-bcf-w=" + weights,
+                              "-obf-seed=%032x" % args.seed] + shlex.split(args.flags)))
+    with tempfile.TemporaryDirectory(prefix="bcf-bench-") as tmp:
+        harness_obj = compile_harness(args, tmp, HARNESS)
+        ir_path = os.path.join(tmp, "bcf.ll")
+        with open(ir_path, "w") as f:
+            f.write(gen_module(args.funcs, args.stages, random.Random(args.seed)))
+        print("%d functions x %d diamonds, bcf prob %d%%" % (args.funcs, args.stages, args.prob))
+        print("%10s %10s %9s %9s %9s %9s" % ("build", "ns", "br-miss", "l1i-miss", "hot B", "cold B"))
+        for name, flags in builds:
+            exe = os.path.join(tmp, name.replace(" ", "_"))
+            hot, cold = sized_build(args, ir_path, harness_obj, flags, exe)
+            ns, misses, icache, _ = run([exe, str(args.iters)]).split()
+            fmt = lambda v: "n/a" if float(v) < 0 else v
+            print("%10s %10s %9s %9s %9d %9d" % (name, ns, fmt(misses), fmt(icache), hot, cold))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
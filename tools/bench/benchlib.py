@@ -0,0 +1,52 @@
+#
+# Created by Ylarod on 2026/10/19.
+#
+# 各基准脚本共用的部分：执行命令、编译计时程序，以及 opt -O2（加载插件）→ llc → cc 的构建流程。
+# 每个脚本只保留自己的 IR 生成与测量逻辑，与本文件放在同一目录，直接 import benchlib。
+#
+# 只依赖 python3 标准库，不联网。
+
+import os
+import shlex
+import subprocess
+import sys
+
+
+def run(cmd):
+    """执行命令并返回标准输出，失败时打印命令与标准错误后退出"""
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if proc.returncode:
+        sys.stderr.write(" ".join(shlex.quote(c) for c in cmd) + "\n" + proc.stderr)
+        sys.exit(1)
+    return proc.stdout
+
+
+def add_tool_args(parser, opt=True):
+    """--cc，以及需要插件时的 --opt / --llc / --plugin"""
+    if opt:
+        parser.add_argument("--opt", default="opt", help="opt binary")
+        parser.add_argument("--llc", default="llc", help="llc binary")
+    parser.add_argument("--cc", default="cc", help="C compiler used for the harness and linking")
+    if opt:
+        parser.add_argument("--plugin", required=True, help="path to libObfuscator.so")
+
+
+def compile_harness(args, tmp, source):
+    """把计时程序写入 tmp 并编译为目标文件，返回其路径"""
+    harness = os.path.join(tmp, "harness.c")
+    with open(harness, "w") as f:
+        f.write(source)
+    harness_obj = os.path.join(tmp, "harness.o")
+    run([args.cc, "-O2", "-fPIE", "-c", harness, "-o", harness_obj])
+    return harness_obj
+
+
+def build(args, ir_path, harness_obj, flags, exe, llc_flags=(), link=()):
+    """ir_path 经 opt -O2（flags 为插件参数）、llc 编译为 <exe>.o，再与计时程序链接为 exe；返回 opt 输出的 <exe>.ll"""
+    opt_ll = exe + ".ll"
+    obj = exe + ".o"
+    run([args.opt, "-load", args.plugin, "-load-pass-plugin", args.plugin, "-passes=default<O2>",
+         "-S", ir_path, "-o", opt_ll] + list(flags))
+    run([args.llc, "-O2", "-relocation-model=pic", "-filetype=obj", opt_ll, "-o", obj] + list(llc_flags))
+    run([args.cc, "-O2", "-pie", obj, harness_obj, "-o", exe] + list(link))
+    return opt_ll
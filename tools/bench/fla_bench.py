@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# Flattening 基准：生成深度 2 ~ 8 的二叉判定树函数（每层按输入的一位分支，叶子做一次乘法和异或），
+# 分别不混淆、用跳转表分发（-obf-fla-m=0）和按稀疏状态值 switch 分发（-obf-fla-m=1，即朴素的比较树分发）编译，
+# 与同一个计时程序链接，比较每次调用的耗时。判定树中没有循环，全部基本块都经过分发块。
+#
+# 用法:
+#   tools/bench/fla_bench.py --plugin out/libObfuscator.so
+#   tools/bench/fla_bench.py --plugin ... --depths 3,6,9 --iters 5000000
+#
+# 只依赖 python3 标准库、opt / llc 和一个 C 编译器，不联网。
+
+import argparse
+import os
+import random
+import shlex
+import sys
+import tempfile
+
+from benchlib import add_tool_args, build, compile_harness, run
+
+# 计时程序：随机输入，多轮取最快的一轮
+HARNESS = r'''
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern int32_t work(uint32_t x);
+
+#define INPUTS (1 << 16)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    long iters = atol(argv[1]);
+    uint32_t *in = malloc(sizeof(uint32_t) * INPUTS);
+    uint64_t s = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < INPUTS; i++) {
+        s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+        in[i] = (uint32_t) (s >> 16);
+    }
+    double best = 1e30;
+    int32_t sum = 0;
+    for (int round = 0; round < 5; round++) {
+        double t = now();
+        for (long i = 0; i < iters; i++) {
+            sum += work(in[i & (INPUTS - 1)]);
+        }
+        t = (now() - t) / iters;
+        best = t < best ? t : best;
+    }
+    printf("%.3f %d\n", best, sum);
+    return 0;
+}
+'''
+
+MODES = (("jump table", "0"), ("sparse switch", "1"))
+
+
+def gen_module(depth, rng):
+    """节点 i 的子节点为 2i / 2i+1，第 d 层按 x 的第 d 位分支，共 2^depth 个叶子"""
+    out = ['define i32 @work(i32 %x) noinline {',
+           'entry:',
+           '  br label %n1']
+    leaves = 1 << depth
+    for i in range(1, leaves):
+        level = i.bit_length() - 1
+        out.append('n%d:' % i)
+        out.append('  %%b%d = and i32 %%x, %d' % (i, 1 << level))
+        out.append('  %%c%d = icmp ne i32 %%b%d, 0' % (i, i))
+        out.append('  br i1 %%c%d, label %%n%d, label %%n%d' % (i, 2 * i, 2 * i + 1))
+    incoming = []
+    for i in range(leaves, 2 * leaves):
+        out.append('n%d:' % i)
+        out.append('  %%m%d = mul i32 %%x, %d' % (i, rng.randrange(3, 1 << 20) | 1))
+        out.append('  %%r%d = xor i32 %%m%d, %d' % (i, i, rng.randrange(1 << 20)))
+        out.append('  br label %exit')
+        incoming.append('[ %%r%d, %%n%d ]' % (i, i))
+    out.append('exit:')
+    out.append('  %%r = phi i32 %s' % ", ".join(incoming))
+    out.append('  ret i32 %r')
+    out.append('}')
+    return "\n".join(out) + "\n"
+
+
+def flattened(args, ir_path, harness_obj, flags, exe):
+    """构建并返回输出中状态槽的 volatile 访问数，为 0 说明没有平坦化"""
+    with open(build(args, ir_path, harness_obj, flags, exe)) as f:
+        return f.read().count("volatile")
+
+
+def measure(args, exe):
+    return float(run([exe, str(args.iters)]).split()[0])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Call latency of flattened functions per dispatcher")
+    add_tool_args(parser)
+    parser.add_argument("--flags", default="", help="extra plugin flags for the flattened builds")
+    parser.add_argument("--depths", default="2,4,6,8", help="comma separated decision tree depths")
+    parser.add_argument("--iters", type=int, default=10000000, help="calls per round")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the leaf constants")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="fla-bench-") as tmp:
+        harness_obj = compile_harness(args, tmp, HARNESS)
+        print("%6s %7s %10s %14s %14s" % ("depth", "blocks", "native ns", "jump table ns", "sparse sw ns"))
+        for depth in (int(d) for d in args.depths.split(",")):
+            ir_path = os.path.join(tmp, "tree-%d.ll" % depth)
+            with open(ir_path, "w") as f:
+                f.write(gen_module(depth, random.Random(args.seed * 1000003 + depth)))
+            native = os.path.join(tmp, "native-%d" % depth)
+            build(args, ir_path, harness_obj, [], native)
+            base = measure(args, native)
+            cells = []
+            for _, mode in MODES:
+                exe = os.path.join(tmp, "fla%s-%d" % (mode, depth))
+                flags = ["-obf-fla=2", "-obf-fla-hot=0", "-obf-fla-m=" + mode] + shlex.split(args.flags)
+                if not flattened(args, ir_path, harness_obj, flags, exe):
+                    cells.append("not flattened")
+                    continue
+                t = measure(args, exe)
+                cells.append("%6.2f %+6.0f%%" % (t, (t - base) / base * 100))
+            print("%6d %7d %10.2f %14s %14s" % (depth, 2 << depth, base, cells[0], cells[1]))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
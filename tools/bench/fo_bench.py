@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# FunctionOrder 基准：生成大量函数，其中每隔 --hot-every 个有一个带 hot 属性的小函数，其余是较大的普通函数，
+# hot 函数在源码顺序中分散在普通函数之间；run_hot 依次调用全部 hot 函数。分别以不重排（源码顺序）、
+# 分组重排（-obf-fo-m=0，hot 函数集中在 .text 开头）和整体随机重排（-obf-fo-m=1）编译，比较：
+#   ns         每次 run_hot 调用的耗时（多轮取最快）
+#   hot span   最终二进制中第一个到最后一个 hot 函数所跨的字节数
+#   hot pages  hot 函数所在的 4 KiB 页数，体现 i-TLB 压力
+# llc 默认按 hot / cold 属性与 profile 把函数放进 .text.hot / .text.unlikely，链接器会把它们聚在一起，
+# 这时三种顺序的差别只剩各 section 内部；默认用 -profile-guided-section-prefix=false 关掉，
+# 让 module 中的函数顺序决定布局，--section-prefix 保留 llc 的默认行为。
+#
+# 用法:
+#   tools/bench/fo_bench.py --plugin out/libObfuscator.so
+#   tools/bench/fo_bench.py --plugin ... --funcs 8192 --hot-every 16
+#
+# 只依赖 python3 标准库、opt / llc、binutils nm 和一个 C 编译器，不联网。
+
+import argparse
+import os
+import random
+import shlex
+import sys
+import tempfile
+
+from benchlib import add_tool_args, build, compile_harness, run
+
+# 计时程序：随机输入，多轮取最快的一轮
+HARNESS = r'''
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern uint32_t run_hot(uint32_t x);
+
+#define INPUTS (1 << 12)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    long iters = atol(argv[1]);
+    uint32_t *in = malloc(sizeof(uint32_t) * INPUTS);
+    uint64_t s = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < INPUTS; i++) {
+        s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+        in[i] = (uint32_t) (s >> 16);
+    }
+    double best = 1e30;
+    uint32_t sum = 0;
+    for (int round = 0; round < 5; round++) {
+        double t = now();
+        for (long i = 0; i < iters; i++) {
+            sum += run_hot(in[i & (INPUTS - 1)]);
+        }
+        t = (now() - t) / iters;
+        best = t < best ? t : best;
+    }
+    printf("%.1f %u\n", best, sum);
+    return 0;
+}
+'''
+
+BUILDS = (
+    ("unshuffled", []),
+    ("bucketed", ["-obf-fo=2", "-obf-fo-m=0"]),
+    ("random", ["-obf-fo=2", "-obf-fo-m=1"]),
+)
+
+
+def gen_function(name, ops, attrs, rng):
+    """ops 条相互依赖的乘法、异或与循环移位，相邻两条不同类，不会被合并"""
+    out = ['define i32 @%s(i32 %%x0) %s {' % (name, attrs), 'entry:']
+    for i in range(ops):
+        kind = i % 3
+        if kind == 0:
+            out.append('  %%x%d = mul i32 %%x%d, %d' % (i + 1, i, rng.randrange(3, 1 << 20) | 1))
+        elif kind == 1:
+            out.append('  %%x%d = xor i32 %%x%d, %d' % (i + 1, i, rng.randrange(1 << 20)))
+        else:
+            out.append('  %%x%d = call i32 @llvm.fshl.i32(i32 %%x%d, i32 %%x%d, i32 %d)' % (i + 1, i, i,
+                                                                                       1 + rng.randrange(31)))
+    out.append('  ret i32 %%x%d' % ops)
+    out.append('}')
+    return out
+
+
+def gen_module(args, rng):
+    out = ['declare i32 @llvm.fshl.i32(i32, i32, i32)']
+    hot = []
+    for k in range(args.funcs):
+        if k % args.hot_every == args.hot_every // 2:
+            hot.append("hot%d" % k)
+            out += gen_function(hot[-1], args.hot_ops, "noinline hot", rng)
+        else:
+            out += gen_function("f%d" % k, args.ops, "noinline", rng)
+    out.append('define i32 @run_hot(i32 %v0) noinline {')
+    for i, name in enumerate(hot):
+        out.append('  %%v%d = call i32 @%s(i32 %%v%d)' % (i + 1, name, i))
+    out.append('  ret i32 %%v%d' % len(hot))
+    out.append('}')
+    return "\n".join(out) + "\n", len(hot)
+
+
+def hot_layout(args, exe):
+    """返回 (hot 函数跨越的字节数, hot 函数占用的 4 KiB 页数)"""
+    ranges = []
+    for line in run([args.nm, "-S", exe]).splitlines():
+        fields = line.split()
+        if len(fields) == 4 and fields[3].startswith("hot"):
+            start = int(fields[0], 16)
+            ranges.append((start, start + int(fields[1], 16)))
+    if not ranges:
+        return 0, 0
+    pages = set()
+    for start, end in ranges:
+        pages.update(range(start >> 12, ((end - 1) >> 12) + 1))
+    return max(e for _, e in ranges) - min(s for s, _ in ranges), len(pages)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Hot path latency and hot code spread per function order")
+    add_tool_args(parser)
+    parser.add_argument("--nm", default="nm", help="binutils nm, used for function addresses")
+    parser.add_argument("--flags", default="", help="extra plugin flags for the reordered builds")
+    parser.add_argument("--section-prefix", action="store_true",
+                        help="keep llc's .text.hot / .text.unlikely placement")
+    parser.add_argument("--funcs", type=int, default=4096, help="functions in the module")
+    parser.add_argument("--hot-every", type=int, default=8, help="one hot function per this many functions")
+    parser.add_argument("--ops", type=int, default=48, help="instructions per ordinary function")
+    parser.add_argument("--hot-ops", type=int, default=8, help="instructions per hot function")
+    parser.add_argument("--iters", type=int, default=20000, help="run_hot calls per round")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the generated code and the plugin PRNG")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="fo-bench-") as tmp:
+        harness_obj = compile_harness(args, tmp, HARNESS)
+        ir_path = os.path.join(tmp, "funcs.ll")
+        text, hot = gen_module(args, random.Random(args.seed))
+        with open(ir_path, "w") as f:
+            f.write(text)
+        print("%d functions, %d hot" % (args.funcs, hot))
+        print("%12s %10s %14s %10s" % ("build", "ns", "hot span KiB", "hot pages"))
+        llc_flags = [] if args.section_prefix else ["-profile-guided-section-prefix=false"]
+        for name, flags in BUILDS:
+            exe = os.path.join(tmp, name)
+            if flags:
+                flags = flags + ["-obf-seed=%032x" % args.seed] + shlex.split(args.flags)
+            build(args, ir_path, harness_obj, flags, exe, llc_flags)
+            span, pages = hot_layout(args, exe)
+            ns = float(run([exe, str(args.iters)]).split()[0])
+            print("%12s %10.1f %14.1f %10d" % (name, ns, span / 1024.0, pages))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# IndirectCall 基准：work 依次调用 N 个 noinline 的小函数，分别不混淆、经函数指针表间接调用（-obf-icall）、
+# 经 FunctionWrapper 包装链（-obf-fw-t=1 与 -obf-fw-t=5）以及包装链再间接调用编译，比较每次 work 调用的耗时。
+# 表中被调函数越多，表占用的 cache line 越多，可以用 --callees 调整。
+#
+# 用法:
+#   tools/bench/icall_bench.py --plugin out/libObfuscator.so
+#   tools/bench/icall_bench.py --plugin ... --callees 64 --iters 2000000
+#
+# 只依赖 python3 标准库、opt / llc 和一个 C 编译器，不联网。
+
+import argparse
+import os
+import random
+import shlex
+import sys
+import tempfile
+
+from benchlib import add_tool_args, build, compile_harness, run
+
+# 计时程序：随机输入，多轮取最快的一轮
+HARNESS = r'''
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern uint32_t work(uint32_t x);
+
+#define INPUTS (1 << 12)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    long iters = atol(argv[1]);
+    uint32_t *in = malloc(sizeof(uint32_t) * INPUTS);
+    uint64_t s = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < INPUTS; i++) {
+        s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+        in[i] = (uint32_t) (s >> 16);
+    }
+    double best = 1e30;
+    uint32_t sum = 0;
+    for (int round = 0; round < 5; round++) {
+        double t = now();
+        for (long i = 0; i < iters; i++) {
+            sum += work(in[i & (INPUTS - 1)]);
+        }
+        t = (now() - t) / iters;
+        best = t < best ? t : best;
+    }
+    printf("%.2f %u\n", best, sum);
+    return 0;
+}
+'''
+
+BUILDS = (
+    ("direct", []),
+    ("icall", ["-obf-icall=2"]),
+    ("fw t=1", ["-obf-fw=2", "-obf-fw-t=1"]),
+    ("fw t=5", ["-obf-fw=2", "-obf-fw-t=5"]),
+    ("fw t=5 + icall", ["-obf-fw=2", "-obf-fw-t=5", "-obf-icall=2"]),
+)
+
+
+def gen_module(callees, rng):
+    """每个被调函数做一次乘法和异或，work 把结果串起来依次调用"""
+    out = []
+    for k in range(callees):
+        out += ['define internal i32 @leaf%d(i32 %%x) noinline {' % k,
+                'entry:',
+                '  %%m = mul i32 %%x, %d' % (rng.randrange(3, 1 << 20) | 1),
+                '  %%r = xor i32 %%m, %d' % rng.randrange(1 << 20),
+                '  ret i32 %r',
+                '}']
+    out.append('define i32 @work(i32 %v0) noinline {')
+    for k in range(callees):
+        out.append('  %%v%d = call i32 @leaf%d(i32 %%v%d)' % (k + 1, k, k))
+    out.append('  ret i32 %%v%d' % callees)
+    out.append('}')
+    return "\n".join(out) + "\n"
+
+
+def counted_build(args, ir_path, harness_obj, flags, exe):
+    """构建并返回输出中定义的函数数，包装函数会使它增加"""
+    with open(build(args, ir_path, harness_obj, flags, exe)) as f:
+        return sum(1 for line in f if line.startswith("define "))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Call latency of indirect calls and wrapper chains")
+    add_tool_args(parser)
+    parser.add_argument("--flags", default="", help="extra plugin flags for the obfuscated builds")
+    parser.add_argument("--callees", type=int, default=16, help="distinct functions called by work")
+    parser.add_argument("--iters", type=int, default=1000000, help="work calls per round")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the callee constants")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory(prefix="icall-bench-") as tmp:
+        harness_obj = compile_harness(args, tmp, HARNESS)
+        ir_path = os.path.join(tmp, "calls.ll")
+        with open(ir_path, "w") as f:
+            f.write(gen_module(args.callees, random.Random(args.seed)))
+        print("work calls %d functions" % args.callees)
+        print("%16s %10s %8s %10s" % ("build", "functions", "ns", "vs direct"))
+        base = None
+        for name, flags in BUILDS:
+            exe = os.path.join(tmp, name.replace(" ", "").replace("=", "").replace("+", "_"))
+            flags = flags + (shlex.split(args.flags) if flags else [])
+            functions = counted_build(args, ir_path, harness_obj, flags, exe)
+            ns = float(run([exe, str(args.iters)]).split()[0])
+            base = base if base is not None else ns
+            print("%16s %10d %8.2f %+9.0f%%" % (name, functions, ns, (ns - base) / base * 100))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# StringEncryption 基准：生成 N 个字符串、每个字符串由一个函数读取，分别不混淆和用 -obf-se 的三种模式
+# （0 首次使用时解密、1 构造函数中解密、2 每次调用解密到栈上）编译，比较：
+#   startup  进程从 exec 到 main 返回的耗时（取多次运行中最快的一次），体现构造函数中的解密
+#   first    第一次读取全部字符串的耗时，体现首次使用时的解密
+#   steady   之后每次读取全部字符串的耗时，体现 guard 检查与栈上解密
+#
+# 用法:
+#   tools/bench/se_bench.py --plugin out/libObfuscator.so
+#   tools/bench/se_bench.py --plugin ... --strings 4096 --length 64 --flags "-obf-rt=1" --link "libbuer_rt.a -lpthread -ldl"
+#
+# 只依赖 python3 标准库、opt / llc 和一个 C 编译器，不联网。
+
+import argparse
+import os
+import random
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+from benchlib import add_tool_args, build, compile_harness, run
+
+# 参数为 s 时直接返回，只测启动；否则测第一次与之后多轮读取全部字符串的耗时
+HARNESS = r'''
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+extern uint64_t touch_all(void);
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && argv[1][0] == 's') {
+        return 0;
+    }
+    double t = now();
+    uint64_t sum = touch_all();
+    double first = now() - t;
+    double best = 1e30;
+    for (int round = 0; round < 20; round++) {
+        t = now();
+        sum += touch_all();
+        t = now() - t;
+        best = t < best ? t : best;
+    }
+    printf("%.0f %.0f %llu\n", first, best, (unsigned long long) sum);
+    return 0;
+}
+'''
+
+
+def gen_module(count, length, rng):
+    """每个字符串一个 noinline 函数，逐字节求和；touch_all 依次调用全部函数"""
+    out = []
+    for i in range(count):
+        text = "".join(rng.choice("abcdefghijklmnopqrstuvwxyz0123456789") for _ in range(length - 1))
+        out.append('@s%d = private unnamed_addr constant [%d x i8] c"%s\\00"' % (i, length, text))
+    for i in range(count):
+        out += ['define internal i64 @t%d() noinline {' % i,
+                'entry:',
+                '  br label %loop',
+                'loop:',
+                '  %i = phi i64 [ 0, %entry ], [ %i1, %loop ]',
+                '  %s = phi i64 [ 0, %entry ], [ %s1, %loop ]',
+                '  %%p = getelementptr [%d x i8], [%d x i8]* @s%d, i64 0, i64 %%i' % (length, length, i),
+                '  %c = load volatile i8, i8* %p',
+                '  %z = zext i8 %c to i64',
+                '  %s1 = add i64 %s, %z',
+                '  %i1 = add i64 %i, 1',
+                '  %%d = icmp ult i64 %%i1, %d' % length,
+                '  br i1 %d, label %loop, label %exit',
+                'exit:',
+                '  ret i64 %s1',
+                '}']
+    out.append('define i64 @touch_all() {')
+    for i in range(count):
+        out.append('  %%r%d = call i64 @t%d()' % (i, i))
+    acc = "0"
+    for i in range(count):
+        out.append('  %%a%d = add i64 %s, %%r%d' % (i, acc, i))
+        acc = "%%a%d" % i
+    out.append('  ret i64 %s' % acc)
+    out.append('}')
+    return "\n".join(out) + "\n"
+
+
+def startup(exe, runs):
+    best = 1e30
+    for _ in range(runs):
+        t = time.perf_counter()
+        subprocess.run([exe, "s"], check=True)
+        best = min(best, time.perf_counter() - t)
+    return best * 1e6
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Startup and first-access cost of encrypted strings per mode")
+    add_tool_args(parser)
+    parser.add_argument("--flags", default="", help="extra plugin flags for the obfuscated builds")
+    parser.add_argument("--link", default="", help="extra link arguments, e.g. libbuer_rt.a with -obf-rt=1")
+    parser.add_argument("--strings", type=int, default=2048, help="number of strings")
+    parser.add_argument("--length", type=int, default=32, help="bytes per string including the terminator")
+    parser.add_argument("--runs", type=int, default=50, help="process starts per build")
+    parser.add_argument("--seed", type=int, default=1, help="seed for the string contents")
+    args = parser.parse_args()
+
+    builds = [("native", [])] + [("mode %d" % m, ["-obf-se=2", "-obf-se-m=%d" % m] + shlex.split(args.flags))
+                                 for m in (0, 1, 2)]
+    with tempfile.TemporaryDirectory(prefix="se-bench-") as tmp:
+        harness_obj = compile_harness(args, tmp, HARNESS)
+        ir_path = os.path.join(tmp, "strings.ll")
+        with open(ir_path, "w") as f:
+            f.write(gen_module(args.strings, args.length, random.Random(args.seed)))
+        print("%d strings x %d bytes" % (args.strings, args.length))
+        print("%8s %12s %12s %12s" % ("build", "startup us", "first us", "steady us"))
+        for name, flags in builds:
+            exe = os.path.join(tmp, name.replace(" ", ""))
+            build(args, ir_path, harness_obj, flags, exe, link=shlex.split(args.link))
+            first, steady, _ = run([exe]).split()
+            print("%8s %12.1f %12.1f %12.1f" % (name, startup(exe, args.runs), float(first) / 1000,
+                                                float(steady) / 1000))
+            sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
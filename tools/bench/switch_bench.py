@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# SwitchEncoding 基准：生成 4 ~ 4096 个 case 的 switch，分别不混淆和用 -obf-swe 混淆后
+# 经 opt -O2 + llc 编译，与同一个计时程序链接，比较每次分发的耗时。wrap 布局对截断到 i1 / i8 的条件值 switch，
+# case 覆盖 0 与最大值，区间跨满整个位宽（稠密编码不能做范围检查）；两个版本的校验和不一致时标记 MISMATCH。
+#
+# 用法:
+#   tools/bench/switch_bench.py --plugin out/libObfuscator.so
+#   tools/bench/switch_bench.py --plugin ... --sizes 16,256,4096 --layout sparse --pattern sequential
+#   tools/bench/switch_bench.py --plugin ... --layout wrap
+#
+# 只依赖 python3 标准库、opt / llc 和一个 C 编译器，不联网。
+
+import argparse
+import os
+import random
+import re
+import shlex
+import sys
+import tempfile
+
+from benchlib import add_tool_args, build, compile_harness, run
+
+# 计时程序：输入序列中 7/8 命中 case，1/8 走 default；多轮取最快的一轮
+HARNESS = r'''
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern int32_t dispatch(uint32_t x);
+extern const uint32_t case_values[];
+extern const uint32_t case_count;
+
+#define INPUTS (1 << 16)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    long iters = atol(argv[1]);
+    int sequential = atoi(argv[2]);
+    uint32_t *in = malloc(sizeof(uint32_t) * INPUTS);
+    uint64_t s = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < INPUTS; i++) {
+        s ^= s << 13, s ^= s >> 7, s ^= s << 17;
+        if (sequential) {
+            in[i] = case_values[i % case_count];
+        } else if ((s & 7) == 0) {
+            in[i] = (uint32_t) (s >> 32) | 1u << 31;
+        } else {
+            in[i] = case_values[(s >> 8) % case_count];
+        }
+    }
+    double best = 1e30;
+    int32_t sum = 0;
+    for (int round = 0; round < 5; round++) {
+        double t = now();
+        for (long i = 0; i < iters; i++) {
+            sum += dispatch(in[i & (INPUTS - 1)]);
+        }
+        t = (now() - t) / iters;
+        best = t < best ? t : best;
+    }
+    printf("%.3f %d\n", best, sum);
+    return 0;
+}
+'''
+
+
+# wrap 布局的 case 数：i1 的两个值，以及刚好达到稠密阈值和覆盖全部取值的 i8
+WRAP_SIZES = (2, 130, 256)
+
+
+def gen_module(size, layout, rng):
+    """生成 dispatch(x)：每个 case 做一次不同的乘法和异或，避免 SimplifyCFG 把 switch 换成查找表"""
+    bits = 32
+    if layout == "dense":
+        values = list(range(size))
+    elif layout == "wrap":
+        bits = 1 if size <= 2 else 8
+        ends = sorted({0, (1 << bits) - 1, (1 << (bits - 1)) - 1, 1 << (bits - 1)})
+        rest = [v for v in range(1 << bits) if v not in ends]
+        values = ends + rng.sample(rest, size - len(ends))
+    else:
+        # 稀疏分布，最高位留给 default 输入
+        values = rng.sample(range(1, 1 << 31), size)
+    out = ['@case_count = constant i32 %d' % size,
+           '@case_values = constant [%d x i32] [%s]' % (size, ", ".join("i32 %d" % v for v in values)),
+           '',
+           'define i32 @dispatch(i32 %x) noinline {',
+           'entry:']
+    if bits == 32:
+        out.append('  switch i32 %x, label %default [')
+    else:
+        out.append('  %%t = trunc i32 %%x to i%d' % bits)
+        out.append('  switch i%d %%t, label %%default [' % bits)
+    for i, v in enumerate(values):
+        # 按有符号数书写，i8 的 128 ~ 255 写成负数
+        literal = v - (1 << bits) if 1 < bits < 32 and v >= 1 << (bits - 1) else v
+        out.append('    i%d %d, label %%c%d' % (bits, literal, i))
+    out.append('  ]')
+    incoming = []
+    for i in range(size):
+        out.append('c%d:' % i)
+        out.append('  %%m%d = mul i32 %%x, %d' % (i, rng.randrange(3, 1 << 20) | 1))
+        out.append('  %%r%d = xor i32 %%m%d, %d' % (i, i, rng.randrange(1 << 20)))
+        out.append('  br label %exit')
+        incoming.append('[ %%r%d, %%c%d ]' % (i, i))
+    out.append('default:')
+    out.append('  br label %exit')
+    incoming.append('[ -1, %default ]')
+    out.append('exit:')
+    out.append('  %%r = phi i32 %s' % ", ".join(incoming))
+    out.append('  ret i32 %r')
+    out.append('}')
+    return "\n".join(out) + "\n"
+
+
+def encoded_build(args, ir_path, harness_obj, flags, exe):
+    """构建并返回输出中的分发块数"""
+    opt_ll = build(args, ir_path, harness_obj, flags, exe)
+    # 两种编码都会生成 <块名>.swe 分发块与 <块名>.swe.unreachable，稠密 switch 没有 buer.swe.keys；
+    # 不做范围检查时分发块会被合并进原来的块，只剩后者
+    with open(opt_ll) as f:
+        return len(re.findall(r'^[\w.$-]+\.swe(\.unreachable)?:', f.read(), re.M))
+
+
+def measure(args, exe, pattern):
+    """返回 (每次分发的耗时, 校验和)"""
+    out = run([exe, str(args.iters), "1" if pattern == "sequential" else "0"]).split()
+    return float(out[0]), out[1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Dispatch latency of encoded switches")
+    add_tool_args(parser)
+    parser.add_argument("--flags", default="-obf-swe=2", help="plugin flags for the obfuscated build")
+    parser.add_argument("--sizes", default="4,16,64,256,1024,4096", help="comma separated case counts")
+    parser.add_argument("--layout", choices=("dense", "sparse", "wrap", "all"), default="all",
+                        help="case values 0..n-1 (jump table), random 31-bit values (compare tree), "
+                             "or i1 / i8 switches spanning the whole type (fixed sizes, --sizes ignored)")
+    parser.add_argument("--pattern", choices=("random", "sequential"), default="random",
+                        help="random inputs with 1/8 misses, or cycling through the cases in order")
+    parser.add_argument("--iters", type=int, default=20000000, help="dispatches per round")
+    parser.add_argument("--seed", type=int, default=1, help="seed for case values and constants")
+    args = parser.parse_args()
+
+    layouts = ("dense", "sparse", "wrap") if args.layout == "all" else (args.layout,)
+    with tempfile.TemporaryDirectory(prefix="swe-bench-") as tmp:
+        harness_obj = compile_harness(args, tmp, HARNESS)
+        print("%6s %7s %10s %10s %9s" % ("cases", "layout", "native ns", "swe ns", "overhead"))
+        for layout in layouts:
+            sizes = WRAP_SIZES if layout == "wrap" else (int(s) for s in args.sizes.split(","))
+            for size in sizes:
+                ir_path = os.path.join(tmp, "sw-%s-%d.ll" % (layout, size))
+                with open(ir_path, "w") as f:
+                    f.write(gen_module(size, layout, random.Random(args.seed * 1000003 + size)))
+                native = os.path.join(tmp, "native-%s-%d" % (layout, size))
+                obf = os.path.join(tmp, "swe-%s-%d" % (layout, size))
+                build(args, ir_path, harness_obj, [], native)
+                encoded = encoded_build(args, ir_path, harness_obj, shlex.split(args.flags), obf)
+                # i1 的 switch 编码后仍会被 -O2 化简为 select，看不到分发块，但仍需核对结果
+                if not encoded and layout != "wrap":
+                    print("%6d %7s  switch not encoded, check --flags" % (size, layout))
+                    continue
+                a, want = measure(args, native, args.pattern)
+                b, got = measure(args, obf, args.pattern)
+                print("%6d %7s %10.3f %10.3f %8.1f%%%s%s" % (size, layout, a, b, (b - a) / a * 100,
+                                                             "" if got == want else "  MISMATCH",
+                                                             "" if encoded else "  (folded)"))
+                sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
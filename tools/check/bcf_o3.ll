@@ -0,0 +1,35 @@
+; BogusControlFlow 的 O3 存活检查输入，由 tools/check/bcf_o3.py 使用
+; 外部函数且带整数参数，三个等级的谓词都可以直接使用
+
+define i32 @pick(i32 %a, i32 %b) {
+entry:
+  %c = icmp slt i32 %a, %b
+  br i1 %c, label %lt, label %ge
+lt:
+  %x = mul i32 %a, 3
+  br label %done
+ge:
+  %y = xor i32 %b, 7
+  br label %done
+done:
+  %r = phi i32 [ %x, %lt ], [ %y, %ge ]
+  ret i32 %r
+}
+
+define i32 @sum(i32* %p, i32 %n) {
+entry:
+  %empty = icmp sle i32 %n, 0
+  br i1 %empty, label %exit, label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i1, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s1, %loop ]
+  %q = getelementptr i32, i32* %p, i32 %i
+  %v = load i32, i32* %q
+  %s1 = add i32 %s, %v
+  %i1 = add i32 %i, 1
+  %more = icmp slt i32 %i1, %n
+  br i1 %more, label %loop, label %exit
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s1, %loop ]
+  ret i32 %r
+}
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# BogusControlFlow 的 O3 存活检查：用 opt -O3 分别以 -obf-bcf-s=0/1/2 处理 bcf_o3.ll（-obf-bcf-p=100），
+# 检查每个原始基本块的不透明谓词都还在：调用 Bcf_<函数名> 的块不少于原始基本块数，且每个这样的块都由一条
+# 条件不是常量、两个后继不同的条件分支到达（循环中的谓词会被 unswitch 到 preheader，跳转线程化会复制真实块，
+# 这些都不算折叠）；并检查谓词用到了对应等级的数据（0 不读 buer.opaque.*，1 读 buer.opaque.x / y，
+# 2 读 buer.opaque.tls）。每个等级用 --seeds 个固定种子各跑一次，任何一项不满足时列出原因并返回 1。
+#
+# 用法:
+#   tools/check/bcf_o3.py --plugin out/libObfuscator.so
+#   tools/check/bcf_o3.py --plugin ... --opt opt-14 --input other.ll --seeds 32 --flags=-obf-bcf-w=0
+#
+# 只依赖 python3 标准库和 opt，不联网。
+
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+TIER_GLOBALS = {
+    0: (),
+    1: ("@buer.opaque.x",),
+    2: ("@buer.opaque.tls",),
+}
+
+DEFINE = re.compile(r'^define .*@([\w.$]+)\(')
+LABEL = re.compile(r'^([\w.$-]+):')
+COND_BR = re.compile(r'^\s*br i1 (\S+), label %([\w.$-]+), label %([\w.$-]+)')
+LABEL_REF = re.compile(r'label %([\w.$-]+)')
+
+
+def parse_functions(text):
+    """返回 {函数名: [(块名, [指令行])]}，入口块没有标签时记为 entry"""
+    functions = {}
+    blocks = None
+    for line in text.splitlines():
+        m = DEFINE.match(line)
+        if m:
+            blocks = functions.setdefault(m.group(1), [])
+            blocks.append(("entry", []))
+            continue
+        if blocks is None:
+            continue
+        if line.startswith("}"):
+            blocks = None
+            continue
+        m = LABEL.match(line)
+        if m:
+            if blocks[-1][1] or blocks[-1][0] != "entry" or len(blocks) > 1:
+                blocks.append((m.group(1), []))
+            continue
+        if line.strip() and not line.lstrip().startswith(";"):
+            blocks[-1][1].append(line)
+    return functions
+
+
+def check_function(name, blocks, expected, tier):
+    """返回问题列表"""
+    problems = []
+    junk = "@Bcf_" + name + "("
+    fakes = {label: body for label, body in blocks if any(junk in line for line in body)}
+    if len(fakes) < expected:
+        problems.append("%s: %d of %d predicates left" % (name, len(fakes), expected))
+    for fake in fakes:
+        guarded = False
+        for label, pred in blocks:
+            if label == fake or not pred or fake not in LABEL_REF.findall(pred[-1]):
+                continue
+            b = COND_BR.match(pred[-1])
+            if b and b.group(2) != b.group(3) and b.group(1) not in ("true", "false"):
+                guarded = True
+        if not guarded:
+            problems.append("%s: %s is reached without an opaque branch" % (name, fake))
+    text = "\n".join(line for _, body in blocks for line in body)
+    if tier == 0 and "@buer.opaque." in text:
+        problems.append("%s: tier 0 predicate reads buer.opaque.*" % name)
+    for gv in TIER_GLOBALS[tier]:
+        if gv not in text:
+            problems.append("%s: tier %d predicate does not read %s" % (name, tier, gv))
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check that opaque predicates of every tier survive opt -O3")
+    parser.add_argument("--opt", default="opt", help="opt binary")
+    parser.add_argument("--plugin", required=True, help="path to libObfuscator.so")
+    parser.add_argument("--input", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "bcf_o3.ll"),
+                        help="IR module, every block of every function gets a predicate")
+    parser.add_argument("--seeds", type=int, default=8, help="fixed plugin seeds per tier")
+    parser.add_argument("--flags", default="", help="extra plugin flags")
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        original = {name: len(blocks) for name, blocks in parse_functions(f.read()).items()}
+    failed = False
+    with tempfile.TemporaryDirectory(prefix="bcf-o3-") as tmp:
+        for tier in sorted(TIER_GLOBALS):
+            problems = []
+            for seed in range(1, args.seeds + 1):
+                out = os.path.join(tmp, "s%d-%d.ll" % (tier, seed))
+                cmd = [args.opt, "-load", args.plugin, "-load-pass-plugin", args.plugin, "-passes=default<O3>",
+                       "-obf-bcf=2", "-obf-bcf-p=100", "-obf-bcf-s=%d" % tier, "-obf-seed=%032x" % seed,
+                       "-S", args.input, "-o", out] + shlex.split(args.flags)
+                proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+                if proc.returncode:
+                    sys.stderr.write(" ".join(shlex.quote(c) for c in cmd) + "\n" + proc.stderr)
+                    return 1
+                with open(out) as f:
+                    functions = parse_functions(f.read())
+                for name, expected in sorted(original.items()):
+                    if name not in functions:
+                        problems.append("seed %d: %s: missing from the output" % (seed, name))
+                        continue
+                    problems += ["seed %d: %s" % (seed, p) for p in check_function(name, functions[name], expected,
+                                                                                      tier)]
+            print("tier %d: %s" % (tier, "ok" if not problems else "FAILED"))
+            for problem in problems:
+                print("  " + problem)
+            failed |= bool(problems)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,263 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# 编译耗时复杂度 fuzzer：随机生成 IR module，按倍数放大后交给 opt + 插件，
+# 检查耗时 / 内存是否随输入规模超线性增长，并把超线性的输入缩小成最小复现。
+#
+# 用法:
+#   tools/fuzz/complexity_fuzz.py --plugin out/libObfuscator.so --runs 20
+#   tools/fuzz/complexity_fuzz.py --plugin ... --flags "-obf-fw=2 -obf-fw-t=5" --seed 42
+#
+# 只依赖 python3 标准库和 opt，不联网。
+
+import argparse
+import math
+import os
+import random
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+# 各类特征的基础数量，实际数量 = 基础数量 * 权重 * 放大倍数
+FEATURES = ("calls", "chain", "annotations", "invokes", "blocks")
+
+
+def gen_module(params):
+    """根据特征数量生成一个文本 IR module"""
+    out = []
+    defs = []
+    annotated = []
+    out.append('declare void @ext(i32)')
+    out.append('declare i32 @__gxx_personality_v0(...)')
+    out.append('declare void @may_throw(i32)')
+
+    # 大量调用点集中在一个函数中
+    n = params["calls"]
+    if n:
+        body = ['define i32 @many_calls(i32 %a) {']
+        for i in range(n):
+            body.append('  call void @ext(i32 %a)')
+        body.append('  ret i32 %a')
+        body.append('}')
+        defs.append("\n".join(body))
+        annotated.append("many_calls")
+
+    # 深调用链 chain_0 -> chain_1 -> ... -> chain_{n-1}
+    n = params["chain"]
+    for i in range(n):
+        callee = 'call i32 @chain_%d(i32 %%x)' % (i + 1) if i + 1 < n else 'add i32 %x, 1'
+        defs.append('define i32 @chain_%d(i32 %%x) {\n  %%r = %s\n  ret i32 %%r\n}' % (i, callee))
+        annotated.append("chain_%d" % i)
+
+    # 大量带异常处理的 invoke
+    n = params["invokes"]
+    if n:
+        body = ['define void @eh(i32 %a) personality i8* bitcast (i32 (...)* @__gxx_personality_v0 to i8*) {',
+                'entry:', '  br label %bb0']
+        for i in range(n):
+            body.append('bb%d:' % i)
+            body.append('  invoke void @may_throw(i32 %%a) to label %%bb%d unwind label %%lpad' % (i + 1))
+        body.append('bb%d:' % n)
+        body.append('  ret void')
+        body.append('lpad:')
+        body.append('  %lp = landingpad { i8*, i32 } cleanup')
+        body.append('  resume { i8*, i32 } %lp')
+        body.append('}')
+        defs.append("\n".join(body))
+
+    # 大量基本块
+    n = params["blocks"]
+    if n:
+        body = ['define i32 @blocks(i32 %a) {', 'entry:', '  br label %b0']
+        for i in range(n):
+            body.append('b%d:' % i)
+            body.append('  %%c%d = icmp eq i32 %%a, %d' % (i, i))
+            body.append('  br i1 %%c%d, label %%b%d, label %%exit' % (i, i + 1))
+        body.append('b%d:' % n)
+        body.append('  br label %exit')
+        body.append('exit:')
+        body.append('  ret i32 %a')
+        body.append('}')
+        defs.append("\n".join(body))
+
+    # 大量注解，另外生成一批只用于注解的空函数
+    n = params["annotations"]
+    for i in range(n):
+        defs.append('define void @annotated_%d() {\n  ret void\n}' % i)
+        annotated.append("annotated_%d" % i)
+
+    out.extend(defs)
+    if params["annotations"] and annotated:
+        note = b"fw fno\x00"
+        out.append('@.str.note = private unnamed_addr constant [%d x i8] c"fw fno\\00", section "llvm.metadata"'
+                   % len(note))
+        out.append('@.str.file = private unnamed_addr constant [6 x i8] c"fuzz\\00\\00", section "llvm.metadata"')
+        entries = []
+        for name in annotated:
+            ty = "i32 (i32)*" if not name.startswith("annotated_") else "void ()*"
+            entries.append('{ i8*, i8*, i8*, i32, i8* } { i8* bitcast (%s @%s to i8*), '
+                           'i8* getelementptr inbounds ([%d x i8], [%d x i8]* @.str.note, i32 0, i32 0), '
+                           'i8* getelementptr inbounds ([6 x i8], [6 x i8]* @.str.file, i32 0, i32 0), '
+                           'i32 1, i8* null }' % (ty, name, len(note), len(note)))
+        out.append('@llvm.global.annotations = appending global [%d x { i8*, i8*, i8*, i32, i8* }] [%s], '
+                   'section "llvm.metadata"' % (len(entries), ", ".join(entries)))
+    return "\n\n".join(out) + "\n"
+
+
+def random_params(rng):
+    """随机选择一组特征权重，每个特征要么关闭，要么给一个基础数量"""
+    params = {}
+    for f in FEATURES:
+        params[f] = rng.choice([0, 0, rng.randint(1, 8) * 8])
+    if not any(params.values()):
+        params[rng.choice(FEATURES)] = 32
+    return params
+
+
+def scale(params, factor):
+    return {k: v * factor for k, v in params.items()}
+
+
+def run_opt(args, ir):
+    """运行一次 opt，返回 (耗时秒, 峰值 RSS KiB, 是否成功)"""
+    with tempfile.NamedTemporaryFile("w", suffix=".ll", delete=False) as f:
+        f.write(ir)
+        path = f.name
+    cmd = opt_command(args, path)
+    try:
+        start = time.monotonic()
+        proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        deadline = start + args.timeout
+        while True:
+            pid, status, usage = os.wait4(proc.pid, os.WNOHANG)
+            if pid:
+                break
+            if time.monotonic() > deadline:
+                proc.kill()
+                pid, status, usage = os.wait4(proc.pid, 0)
+                return args.timeout, usage.ru_maxrss, False
+            time.sleep(0.005)
+        elapsed = time.monotonic() - start
+        return elapsed, usage.ru_maxrss, os.waitstatus_to_exitcode(status) == 0
+    finally:
+        os.unlink(path)
+
+
+def opt_command(args, path):
+    return ([args.opt, "-load", args.plugin, "-load-pass-plugin", args.plugin,
+             "-passes=" + args.passes] + shlex.split(args.flags) + ["-disable-output", path])
+
+
+def slope(points):
+    """log-log 最小二乘斜率，1 为线性，2 为平方"""
+    xs = [math.log(p[0]) for p in points]
+    ys = [math.log(max(p[1], 1e-4)) for p in points]
+    mx, my = sum(xs) / len(xs), sum(ys) / len(ys)
+    den = sum((x - mx) ** 2 for x in xs)
+    return sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / den if den else 0.0
+
+
+def measure(args, params):
+    """按 1, 2, 4, ... 倍放大，返回 [(规模, 耗时, rss)]"""
+    samples = []
+    for step in range(args.steps):
+        factor = 1 << step
+        ir = gen_module(scale(params, factor))
+        elapsed, rss, ok = run_opt(args, ir)
+        if not ok:
+            return samples, "crash or timeout at x%d" % factor
+        samples.append((factor, elapsed, rss))
+    return samples, None
+
+
+def is_superlinear(args, samples):
+    # 太快的样本只是进程启动噪声，不参与拟合
+    timed = [(n, t) for n, t, _ in samples if t >= args.noise]
+    time_slope = slope(timed) if len(timed) >= 2 else 0.0
+    # rss 包含 opt 自身的固定开销，只看增量，增量太小时同样视为噪声
+    base = samples[0][2] if samples else 0
+    mem_delta = [(n, r - base) for n, _, r in samples[1:] if r - base > 1024]
+    mem_slope = 0.0
+    if len(mem_delta) >= 2 and mem_delta[-1][1] >= args.mem_noise:
+        mem_slope = slope(mem_delta)
+    return time_slope > args.max_slope or mem_slope > args.max_slope, time_slope, mem_slope
+
+
+def minimize(args, params):
+    """在特征空间上做 delta debugging：逐个关闭 / 减半基础规模的特征，候选重新按 measure 放大，
+    只有斜率检查仍然判定为超线性时才接受，避免缩小成一个只是规模大、并不超线性的输入"""
+    current = dict(params)
+    changed = True
+    while changed:
+        changed = False
+        for f in FEATURES:
+            while current[f]:
+                candidate = dict(current)
+                candidate[f] = 0 if current[f] <= 1 else current[f] // 2
+                if not any(candidate.values()):
+                    break
+                samples, error = measure(args, candidate)
+                if error or not is_superlinear(args, samples)[0]:
+                    break
+                current = candidate
+                changed = True
+    return current
+
+
+def write_repro(args, params, seed):
+    os.makedirs(args.out, exist_ok=True)
+    ll = os.path.join(args.out, "repro-%d.ll" % seed)
+    with open(ll, "w") as f:
+        f.write("; params: %s\n" % params)
+        f.write(gen_module(params))
+    sh = os.path.join(args.out, "repro-%d.sh" % seed)
+    with open(sh, "w") as f:
+        f.write("#!/bin/sh\n" + " ".join(shlex.quote(c) for c in opt_command(args, ll)) + "\n")
+    os.chmod(sh, 0o755)
+    return ll
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile-time complexity fuzzer for Buer passes")
+    parser.add_argument("--opt", default="opt", help="opt binary")
+    parser.add_argument("--plugin", required=True, help="path to libObfuscator.so")
+    parser.add_argument("--passes", default="default<O0>", help="pipeline given to opt -passes")
+    parser.add_argument("--flags", default="-obf-fn=2 -obf-gvn=2 -obf-fw=2",
+                        help="obfuscator flags passed to opt")
+    parser.add_argument("--seed", type=int, default=None, help="first seed (random by default)")
+    parser.add_argument("--runs", type=int, default=10, help="number of random modules")
+    parser.add_argument("--steps", type=int, default=5, help="scaling steps (x1, x2, x4, ...)")
+    parser.add_argument("--max-slope", type=float, default=1.5,
+                        help="flag when log-log slope of time or memory exceeds this")
+    parser.add_argument("--noise", type=float, default=0.05, help="ignore runs faster than this [s]")
+    parser.add_argument("--mem-noise", type=int, default=16384,
+                        help="ignore memory growth below this [KiB]")
+    parser.add_argument("--timeout", type=float, default=120, help="per run timeout [s]")
+    parser.add_argument("--out", default="fuzz-out", help="directory for reproducers")
+    args = parser.parse_args()
+
+    first = args.seed if args.seed is not None else random.randrange(1 << 30)
+    found = 0
+    for seed in range(first, first + args.runs):
+        params = random_params(random.Random(seed))
+        samples, error = measure(args, params)
+        summary = " ".join("x%d:%.3fs/%dKiB" % s for s in samples)
+        if error:
+            ll = write_repro(args, scale(params, 1 << len(samples)), seed)
+            print("[%d] %s %s -> %s" % (seed, params, error, ll))
+            found += 1
+            continue
+        bad, time_slope, mem_slope = is_superlinear(args, samples)
+        print("[%d] %s time^%.2f mem^%.2f %s" % (seed, params, time_slope, mem_slope, summary))
+        if bad:
+            ll = write_repro(args, scale(minimize(args, params), samples[-1][0]), seed)
+            print("    superlinear, reproducer: %s" % ll)
+            found += 1
+    return 1 if found else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
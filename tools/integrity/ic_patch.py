@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# IntegrityCheck 的链接后处理：计算 ELF 中 buer_ic_text 段的 CRC32C，写入 buer_ic_sum 段，
+# 运行时 buer_rt 的后台线程按同样的算法校验。必须在最终链接之后、签名之前执行；strip 不影响这两个段。
+#
+# 用法:
+#   tools/integrity/ic_patch.py app            # 原地写入
+#   tools/integrity/ic_patch.py --check app    # 只比较，不一致时返回 1
+#
+# 只依赖 python3 标准库。
+
+import argparse
+import struct
+import sys
+
+TEXT_SECTION = b"buer_ic_text"
+SUM_SECTION = b"buer_ic_sum"
+
+
+def crc32c_table():
+    table = []
+    for n in range(256):
+        c = n
+        for _ in range(8):
+            c = (c >> 1) ^ 0x82F63B78 if c & 1 else c >> 1
+        table.append(c)
+    return table
+
+
+def crc32c(data):
+    table = crc32c_table()
+    crc = 0xFFFFFFFF
+    for b in data:
+        crc = (crc >> 8) ^ table[(crc ^ b) & 0xFF]
+    return crc ^ 0xFFFFFFFF
+
+
+def read_sections(image):
+    """返回 {段名: (文件偏移, 大小)} 与字节序前缀"""
+    if image[:4] != b"\x7fELF":
+        raise ValueError("not an ELF file")
+    is64 = image[4] == 2
+    endian = "<" if image[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", image, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", image, 0x3A)
+        fmt = endian + "IIQQQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", image, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", image, 0x2E)
+        fmt = endian + "IIIIII"
+    headers = []
+    for i in range(shnum):
+        name, _type, _flags, _addr, offset, size = struct.unpack_from(fmt, image, shoff + i * shentsize)
+        headers.append((name, offset, size))
+    strtab_offset = headers[shstrndx][1]
+    sections = {}
+    for name, offset, size in headers:
+        end = image.index(b"\0", strtab_offset + name)
+        sections[bytes(image[strtab_offset + name:end])] = (offset, size)
+    return sections, endian
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Write the expected CRC32C of buer_ic_text into buer_ic_sum")
+    parser.add_argument("binary", help="linked executable or shared library")
+    parser.add_argument("--check", action="store_true", help="only compare the stored and the actual checksum")
+    args = parser.parse_args()
+
+    with open(args.binary, "rb") as f:
+        image = bytearray(f.read())
+    sections, endian = read_sections(image)
+    if TEXT_SECTION not in sections or SUM_SECTION not in sections:
+        sys.stderr.write("%s: no %s / %s section, was it built with -obf-ic?\n"
+                         % (args.binary, TEXT_SECTION.decode(), SUM_SECTION.decode()))
+        return 1
+    text_offset, text_size = sections[TEXT_SECTION]
+    sum_offset, sum_size = sections[SUM_SECTION]
+    crc = crc32c(image[text_offset:text_offset + text_size])
+    if crc == 0:
+        sys.stderr.write("%s: checksum is 0, which the runtime treats as unpatched\n" % args.binary)
+    # comdat 去重后只有一项；按 4 字节写满整个段，兼容没有去重的链接方式
+    slots = sum_size // 4
+    stored = {struct.unpack_from(endian + "I", image, sum_offset + i * 4)[0] for i in range(slots)}
+    print("%s: %d bytes, crc32c %08x, stored %s" % (TEXT_SECTION.decode(), text_size, crc,
+                                                    " ".join("%08x" % s for s in sorted(stored))))
+    if args.check:
+        return 0 if stored == {crc} else 1
+    for i in range(slots):
+        struct.pack_into(endian + "I", image, sum_offset + i * 4, crc)
+    with open(args.binary, "r+b") as f:
+        f.write(image)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# 机器码大小归因：读取 -obf-report 写出的每个编译单元的报告，与目标文件 / 最终二进制的 ELF 符号表对照，
+# 按函数列出降级后的实际字节数（AsmPrinter 写入的 .size，即符号的 st_size），并把 Wra_*、Bcf_*、<函数名>.cold.N
+# 等插件生成的函数归到生成它的 pass 与来源函数，按 pass 汇总。
+#
+# 用法:
+#   tools/report/code_size.py --report obf-report build/*.o
+#   tools/report/code_size.py --report obf-report --write app   # 结果同时写回报告的 code_size 字段
+#
+# 只依赖 python3 标准库。private 函数没有符号，只能列出 IR 规模；被内联或删除的函数计为 0。
+
+import argparse
+import glob
+import json
+import os
+import struct
+import sys
+
+SHT_SYMTAB = 2
+SHT_DYNSYM = 11
+STT_FUNC = 2
+STT_FILE = 4
+STB_LOCAL = 0
+
+NATIVE = "<native>"
+
+
+def read_symbols(path):
+    """返回 [(所属源文件, 符号名, 大小, 是否局部)]；所属源文件取前一个 STT_FILE 符号，没有时为空串"""
+    with open(path, "rb") as f:
+        image = f.read()
+    if image[:4] != b"\x7fELF":
+        raise ValueError("%s: not an ELF file" % path)
+    is64 = image[4] == 2
+    endian = "<" if image[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", image, 0x28)
+        shentsize, shnum = struct.unpack_from(endian + "HH", image, 0x3A)
+        shfmt = endian + "IIQQQQII"
+    else:
+        shoff, = struct.unpack_from(endian + "I", image, 0x20)
+        shentsize, shnum = struct.unpack_from(endian + "HH", image, 0x2E)
+        shfmt = endian + "IIIIIIII"
+    headers = [struct.unpack_from(shfmt, image, shoff + i * shentsize) for i in range(shnum)]
+    # strip 之后只剩 .dynsym，局部函数就看不到了
+    tables = [h for h in headers if h[1] == SHT_SYMTAB] or [h for h in headers if h[1] == SHT_DYNSYM]
+    symbols = []
+    for _name, _type, _flags, _addr, offset, size, link, _info in tables:
+        str_offset = headers[link][4]
+        entsize = 24 if is64 else 16
+        current = ""
+        for i in range(1, size // entsize):
+            at = offset + i * entsize
+            if is64:
+                st_name, st_info, _other, st_shndx, _value, st_size = struct.unpack_from(endian + "IBBHQQ", image, at)
+            else:
+                st_name, _value, st_size, st_info, _other, st_shndx = struct.unpack_from(endian + "IIIBBH", image, at)
+            name = image[str_offset + st_name:image.index(b"\0", str_offset + st_name)].decode(errors="replace")
+            kind, bind = st_info & 0xF, st_info >> 4
+            if kind == STT_FILE:
+                current = os.path.basename(name)
+            elif kind == STT_FUNC and st_shndx != 0:
+                symbols.append((current, name, st_size, bind == STB_LOCAL))
+    return symbols
+
+
+class SymbolIndex:
+    def __init__(self, paths):
+        self.scoped = {}   # (源文件, 符号名) -> 大小
+        self.globals = {}  # 符号名 -> 大小
+        for path in paths:
+            symbols = read_symbols(path)
+            files = {s[0] for s in symbols if s[3] and s[0]}
+            # 单个目标文件里全局符号也属于这个编译单元；链接后的二进制中全局符号无法再按文件区分
+            only = files.pop() if len(files) == 1 else None
+            for file, name, size, local in symbols:
+                if local:
+                    self.scoped.setdefault((file, name), size)
+                else:
+                    if only is not None:
+                        self.scoped.setdefault((only, name), size)
+                    self.globals.setdefault(name, size)
+
+    def lookup(self, file, name, local):
+        if (file, name) in self.scoped:
+            return self.scoped[(file, name)]
+        if not local:
+            return self.globals.get(name)
+        return None
+
+    def variants(self, file, name, local):
+        """后续优化改名产生的 <函数名>.xxx（ThinLTO 提升的 .llvm.N、拆分出的 .cold.N 等）"""
+        prefix = name + "."
+        names = {n for f, n in self.scoped if f == file and n.startswith(prefix)}
+        if not local:
+            names |= {n for n in self.globals if n.startswith(prefix)}
+        return names
+
+
+def attribute(report, index):
+    file = os.path.basename(report.get("source", ""))
+    functions = report["functions"]
+    known = {f["name"] for f in functions}
+    rows = []
+    for f in functions:
+        local = f["linkage"] != "external"
+        row = {"name": f["name"], "instructions": f["instructions"], "pass": f.get("pass", NATIVE)}
+        if "source" in f:
+            row["source"] = f["source"]
+        if f["linkage"] == "private":
+            row["bytes"] = None
+        else:
+            size = index.lookup(file, f["name"], local)
+            extra = sorted(index.variants(file, f["name"], local) - known)
+            for name in extra:
+                size = (size or 0) + (index.lookup(file, name, local) or 0)
+            row["bytes"] = size or 0
+            if extra:
+                row["variants"] = extra
+        rows.append(row)
+    by_pass = {}
+    for row in rows:
+        entry = by_pass.setdefault(row["pass"], {"functions": 0, "bytes": 0})
+        entry["functions"] += 1
+        entry["bytes"] += row["bytes"] or 0
+    total = sum(row["bytes"] or 0 for row in rows)
+    return {"total": total, "by_pass": by_pass, "functions": rows}
+
+
+def print_table(path, report, result, top):
+    total = result["total"]
+    print("== %s (%s): %d bytes" % (report.get("source", "?"), os.path.basename(path), total))
+    print("%8s %6s %6s  %-18s %s" % ("bytes", "share", "ir", "pass", "function"))
+    rows = sorted(result["functions"], key=lambda r: -(r["bytes"] or 0))
+    for row in rows[:top] if top else rows:
+        size = "-" if row["bytes"] is None else str(row["bytes"])
+        share = "%5.1f%%" % (row["bytes"] * 100.0 / total) if row["bytes"] and total else ""
+        name = row["name"]
+        if "source" in row:
+            name += " <- " + row["source"]
+        if "variants" in row:
+            name += " (+" + ", ".join(row["variants"]) + ")"
+        print("%8s %6s %6d  %-18s %s" % (size, share, row["instructions"], row["pass"], name))
+    for name, entry in sorted(result["by_pass"].items(), key=lambda e: -e[1]["bytes"]):
+        print("  %-18s %8d bytes in %d functions" % (name, entry["bytes"], entry["functions"]))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Attribute machine code bytes per function to obfuscation passes")
+    parser.add_argument("--report", required=True, help="directory given to -obf-report")
+    parser.add_argument("--write", action="store_true", help="store the result as code_size in each report")
+    parser.add_argument("--top", type=int, default=0, help="only print the N largest functions of each TU")
+    parser.add_argument("inputs", nargs="+", help="ELF objects, executables or shared libraries")
+    args = parser.parse_args()
+
+    index = SymbolIndex(args.inputs)
+    matched = 0
+    for path in sorted(glob.glob(os.path.join(args.report, "*.json"))):
+        with open(path) as f:
+            report = json.load(f)
+        if "functions" not in report:
+            continue
+        result = attribute(report, index)
+        if not result["total"]:
+            continue  # 这个编译单元不在输入的文件里
+        matched += 1
+        print_table(path, report, result, args.top)
+        if args.write:
+            result["inputs"] = args.inputs
+            report["code_size"] = result
+            with open(path, "w") as f:
+                json.dump(report, f, indent=2)
+                f.write("\n")
+    if not matched:
+        sys.stderr.write("no report in %s matches the symbols of the inputs\n" % args.report)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+#
+# Created by Ylarod on 2026/10/19.
+#
+# RuntimeProfile 计数映射：把 buer_rt 在退出时写出的 buer-prof.<pid>.txt（"<module> <index> <count>"）
+# 通过 -obf-report 写出的报告映射回计数器所在的函数、生成它的 pass 与来源函数（FuncNameObf 之前的原名），
+# 按来源函数和 pass 汇总，列出执行最多的注入代码以及可以加到来源函数上的 no-<pass> 注解。
+#
+# 用法:
+#   tools/report/prof_map.py --report obf-report buer-prof.*.txt
+#   tools/report/prof_map.py --report obf-report --top 20 --functions buer-prof.1234.txt
+#
+# 只依赖 python3 标准库。
+
+import argparse
+import collections
+import glob
+import json
+import os
+import sys
+
+# pass 与排除它的注解
+ANNOTATIONS = {
+    "FunctionWrapper": "no-fw",
+    "StringEncryption": "no-se",
+    "ApiHiding": "no-api",
+    "BogusControlFlow": "no-bcf",
+    "IntegrityCheck": "no-ic",
+}
+
+
+def load_reports(directory):
+    """返回 {module 标识: (报告路径, {计数器下标: 函数}, {函数名: 函数})}"""
+    modules = {}
+    for path in sorted(glob.glob(os.path.join(directory, "*.json"))):
+        with open(path) as f:
+            report = json.load(f)
+        if "id" not in report:
+            continue
+        functions = report.get("functions", [])
+        counters = {f["counter"]: f for f in functions if "counter" in f}
+        if counters:
+            modules[report["id"]] = (path, counters, {f["name"]: f for f in functions})
+    return modules
+
+
+def original(functions, name):
+    f = functions.get(name)
+    return f.get("original", name) if f else name
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Map RuntimeProfile counters back to passes and source functions")
+    parser.add_argument("--report", required=True, help="directory given to -obf-report")
+    parser.add_argument("--top", type=int, default=0, help="only print the N hottest entries")
+    parser.add_argument("--functions", action="store_true",
+                        help="list every instrumented function instead of summing per source and pass")
+    parser.add_argument("dumps", nargs="+", help="buer-prof.<pid>.txt files, counts are summed")
+    args = parser.parse_args()
+
+    modules = load_reports(args.report)
+    counts = collections.Counter()
+    unknown = 0
+    for path in args.dumps:
+        with open(path) as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) != 3:
+                    continue
+                module, index, count = fields[0], int(fields[1]), int(fields[2])
+                if module not in modules or index not in modules[module][1]:
+                    unknown += count
+                    continue
+                counts[(module, index)] += count
+
+    rows = collections.Counter()
+    for (module, index), count in counts.items():
+        path, counters, functions = modules[module]
+        f = counters[index]
+        source = original(functions, f["source"]) if "source" in f else "-"
+        unit = os.path.basename(path).split(".")[0]
+        if args.functions:
+            key = (f.get("pass", "?"), source, unit, original(functions, f["name"]))
+        else:
+            key = (f.get("pass", "?"), source, unit)
+        rows[key] += count
+
+    total = sum(rows.values())
+    if args.functions:
+        print("%14s %6s  %-18s %-24s %-16s %s" % ("entries", "share", "pass", "source", "unit", "function"))
+    else:
+        print("%14s %6s  %-18s %-24s %-16s %s" % ("entries", "share", "pass", "source", "unit", "exclude with"))
+    items = rows.most_common(args.top or None)
+    for key, count in items:
+        share = "%5.1f%%" % (count * 100.0 / total) if total else ""
+        last = key[3] if args.functions else ANNOTATIONS.get(key[0], "-")
+        print("%14d %6s  %-18s %-24s %-16s %s" % (count, share, key[0], key[1], key[2], last))
+    if unknown:
+        sys.stderr.write("%d entries from modules or counters missing in %s\n" % (unknown, args.report))
+    return 0 if rows else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())